@@ -0,0 +1,164 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <snippets/bloomfilter.h>
+
+#define N_KEYS 100000
+
+/* URL-like keys of 40 to 140 bytes */
+static char *keys[N_KEYS];
+static size_t lens[N_KEYS];
+
+static void
+setup_keys (void)
+{
+  char buf[256];
+  int i, len;
+
+  for (i = 0; i < N_KEYS; i++) {
+    len = snprintf (buf, sizeof (buf),
+        "https://www.example.org/some/path/to/a/resource/%d/%0*d.html?q=%x",
+        i % 1000, (i * 7) % 80, i, i * 2654435761U);
+    keys[i] = strdup (buf);
+    lens[i] = len;
+  }
+}
+
+static uint64_t
+run (SnippetsBloomFilterHash hash, unsigned int hash_size, int runs)
+{
+  struct timeval tv_start, tv_end;
+  uint64_t start, end;
+  SnippetsBloomFilter *filter;
+  int i, j, found = 0;
+
+  filter = snippets_bloom_filter_new_full (N_KEYS * 10, 7, hash, hash_size,
+      NULL);
+
+  gettimeofday (&tv_start, NULL);
+  for (i = 0; i < runs; i++) {
+    for (j = 0; j < N_KEYS; j++)
+      snippets_bloom_filter_insert (filter, (const uint8_t *) keys[j],
+          lens[j]);
+    for (j = 0; j < N_KEYS; j++)
+      found +=
+          snippets_bloom_filter_contains (filter, (const uint8_t *) keys[j],
+          lens[j]);
+  }
+  gettimeofday (&tv_end, NULL);
+
+  if (found != runs * N_KEYS)
+    abort ();
+
+  snippets_bloom_filter_free (filter);
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+
+  return end - start;
+}
+
+/* Deduplication: check if the key is contained and insert it if not,
+ * with half of the keys being duplicates */
+static uint64_t
+run_dedup (int mode, int runs)
+{
+  struct timeval tv_start, tv_end;
+  uint64_t start, end;
+  SnippetsBloomFilter *filter;
+  SnippetsHashedKey key;
+  int i, j, found = 0;
+
+  gettimeofday (&tv_start, NULL);
+  for (i = 0; i < runs; i++) {
+    filter = snippets_bloom_filter_new (N_KEYS * 10, 7, 128);
+    for (j = 0; j < 2 * N_KEYS; j++) {
+      const uint8_t *k = (const uint8_t *) keys[j % N_KEYS];
+      size_t l = lens[j % N_KEYS];
+
+      switch (mode) {
+        case 0:
+          if (snippets_bloom_filter_contains (filter, k, l))
+            found++;
+          else
+            snippets_bloom_filter_insert (filter, k, l);
+          break;
+        case 1:
+          snippets_bloom_filter_hash_key (filter, k, l, &key);
+          if (snippets_bloom_filter_contains_hashed (filter, &key))
+            found++;
+          else
+            snippets_bloom_filter_insert_hashed (filter, &key);
+          break;
+        case 2:
+          found += snippets_bloom_filter_test_and_insert (filter, k, l);
+          break;
+      }
+    }
+    snippets_bloom_filter_free (filter);
+  }
+  gettimeofday (&tv_end, NULL);
+
+  if (found < runs * N_KEYS)
+    abort ();
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+
+  return end - start;
+}
+
+#define RUN_DEDUP(mode, name, runs) do { \
+  uint64_t _duration; \
+  _duration = run_dedup (mode, runs); \
+  printf (name ":\t%04lu.%06lus for " #runs " runs (%lf keys/s)\n", _duration / 1000000, _duration % 1000000, (((double)runs) * 2 * N_KEYS * 1000000.0) / ((double)_duration)); \
+} while (0);
+
+#define RUN(hash, hash_size, runs) do { \
+  uint64_t _duration; \
+  _duration = run (SNIPPETS_BLOOM_FILTER_HASH_##hash, hash_size, runs); \
+  printf (#hash " " #hash_size ":\t%04lu.%06lus for " #runs " runs (%lf operations/s)\n", _duration / 1000000, _duration % 1000000, (((double)runs) * 2 * N_KEYS * 1000000.0) / ((double)_duration)); \
+} while (0);
+
+int
+main (int argc, char **argv)
+{
+  setup_keys ();
+
+  RUN (FNV1A, 64, 50);
+  RUN (WYHASH, 64, 50);
+
+  RUN (FNV1A, 128, 50);
+  RUN (WYHASH, 128, 50);
+
+  RUN_DEDUP (0, "contains + insert", 20);
+  RUN_DEDUP (1, "hashed contains + insert", 20);
+  RUN_DEDUP (2, "test_and_insert", 20);
+
+  return 0;
+}
@@ -22,9 +22,14 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <sys/time.h>
 
 #include <snippets/fnv.h>
+#include <snippets/fnv-inline.h>
+#include <snippets/wyhash.h>
 
 static uint8_t test_data[8096];
 
@@ -49,6 +54,287 @@ run (fnv_func func, int runs)
   return end - start;
 }
 
+static const uint64_t seed[2] = { 0x0123456789abcdefULL, 0xfedcba9876543210ULL };
+
+static void
+fnv1a_64_unseeded (const uint8_t * data, size_t len, uint8_t * hash)
+{
+  *(uint64_t *) hash = snippets_fnv1a_64_uint64 (data, len);
+}
+
+static void
+wyhash_64 (const uint8_t * data, size_t len, uint8_t * hash)
+{
+  *(uint64_t *) hash = snippets_wyhash_64 (data, len, 0);
+}
+
+static void
+fnv1a_64_seeded (const uint8_t * data, size_t len, uint8_t * hash)
+{
+  *(uint64_t *) hash = snippets_fnv1a_64_seeded (data, len, seed);
+}
+
+/* Many short keys of 8 to 64 bytes */
+#define N_KEYS 100000
+static const uint8_t *keys[N_KEYS];
+static size_t lens[N_KEYS];
+
+static void
+setup_keys (void)
+{
+  int i;
+
+  for (i = 0; i < N_KEYS; i++) {
+    keys[i] = test_data + (i * 97) % (sizeof (test_data) - 64);
+    lens[i] = 8 + (i * 37) % 57;
+  }
+}
+
+static uint64_t
+run_keys_32 (int runs)
+{
+  struct timeval tv_start, tv_end;
+  uint64_t start, end;
+  int i, j;
+  uint8_t hash[4];
+
+  gettimeofday (&tv_start, NULL);
+  for (i = 0; i < runs; i++)
+    for (j = 0; j < N_KEYS; j++)
+      snippets_fnv1a_32 (keys[j], lens[j], hash);
+  gettimeofday (&tv_end, NULL);
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+
+  return end - start;
+}
+
+static uint64_t
+run_keys_32_batch (int runs)
+{
+  static uint32_t out[N_KEYS];
+  struct timeval tv_start, tv_end;
+  uint64_t start, end;
+  int i;
+
+  gettimeofday (&tv_start, NULL);
+  for (i = 0; i < runs; i++)
+    snippets_fnv1a_32_batch (keys, lens, N_KEYS, out);
+  gettimeofday (&tv_end, NULL);
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+
+  return end - start;
+}
+
+static uint64_t
+run_keys_64 (int runs)
+{
+  struct timeval tv_start, tv_end;
+  uint64_t start, end;
+  int i, j;
+  uint8_t hash[8];
+
+  gettimeofday (&tv_start, NULL);
+  for (i = 0; i < runs; i++)
+    for (j = 0; j < N_KEYS; j++)
+      snippets_fnv1a_64 (keys[j], lens[j], hash);
+  gettimeofday (&tv_end, NULL);
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+
+  return end - start;
+}
+
+static uint64_t
+run_keys_64_seeded (int runs)
+{
+  struct timeval tv_start, tv_end;
+  uint64_t start, end;
+  int i, j;
+  volatile uint64_t hash;
+
+  gettimeofday (&tv_start, NULL);
+  for (i = 0; i < runs; i++)
+    for (j = 0; j < N_KEYS; j++)
+      hash = snippets_fnv1a_64_seeded (keys[j], lens[j], seed);
+  gettimeofday (&tv_end, NULL);
+
+  (void) hash;
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+
+  return end - start;
+}
+
+static uint64_t
+run_keys_64_batch (int runs)
+{
+  static uint64_t out[N_KEYS];
+  struct timeval tv_start, tv_end;
+  uint64_t start, end;
+  int i;
+
+  gettimeofday (&tv_start, NULL);
+  for (i = 0; i < runs; i++)
+    snippets_fnv1a_64_batch (keys, lens, N_KEYS, out);
+  gettimeofday (&tv_end, NULL);
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+
+  return end - start;
+}
+
+/* 8 byte integer keys */
+static uint64_t
+run_keys_u64 (int runs)
+{
+  struct timeval tv_start, tv_end;
+  uint64_t start, end, key, sum = 0;
+  int i, j;
+
+  gettimeofday (&tv_start, NULL);
+  for (i = 0; i < runs; i++) {
+    for (j = 0; j < N_KEYS; j++) {
+      key = j;
+      sum += snippets_fnv1a_64_uint64 ((const uint8_t *) &key, 8);
+    }
+  }
+  gettimeofday (&tv_end, NULL);
+
+  if (sum == 0)
+    printf ("unlikely\n");
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+
+  return end - start;
+}
+
+static uint64_t
+run_keys_u64_inline (int runs)
+{
+  struct timeval tv_start, tv_end;
+  uint64_t start, end, sum = 0;
+  int i, j;
+
+  gettimeofday (&tv_start, NULL);
+  for (i = 0; i < runs; i++)
+    for (j = 0; j < N_KEYS; j++)
+      sum += snippets_fnv1a_64_u64 (j);
+  gettimeofday (&tv_end, NULL);
+
+  if (sum == 0)
+    printf ("unlikely\n");
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+
+  return end - start;
+}
+
+/* FNV tree mode over a large buffer */
+#define TREE_SIZE (256 * 1024 * 1024)
+#define TREE_CHUNK_SIZE (1024 * 1024)
+
+static void
+run_tree (unsigned int n_threads)
+{
+  struct timeval tv_start, tv_end;
+  uint64_t start, end, duration;
+  uint8_t *data, hash[8];
+  size_t i;
+
+  data = malloc (TREE_SIZE);
+  for (i = 0; i < TREE_SIZE; i++)
+    data[i] = i & 0xff;
+
+  gettimeofday (&tv_start, NULL);
+  snippets_fnv_tree (SNIPPETS_FNV_VARIANT_1A, 64, TREE_CHUNK_SIZE, n_threads,
+      data, TREE_SIZE, hash);
+  gettimeofday (&tv_end, NULL);
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+  duration = end - start;
+
+  printf ("snippets_fnv_tree (%u threads):\t%04lu.%06lus (%lf kb/s)\n",
+      n_threads, duration / 1000000, duration % 1000000,
+      (((double) TREE_SIZE) * 1000.0) / ((double) duration));
+
+  free (data);
+}
+
+/* File hashing, memory mapped vs. a plain read() loop. For
+ * numbers that don't just measure the page cache pass a file
+ * that is bigger than the RAM on the command line. */
+#define FILE_SIZE (256 * 1024 * 1024)
+
+static void
+create_file (const char *path)
+{
+  uint8_t block[64 * 1024];
+  FILE *f;
+  int i;
+
+  for (i = 0; i < sizeof (block); i++)
+    block[i] = i & 0xff;
+
+  f = fopen (path, "wb");
+  for (i = 0; i < FILE_SIZE / sizeof (block); i++)
+    fwrite (block, 1, sizeof (block), f);
+  fclose (f);
+}
+
+static void
+run_file (const char *path, int use_mmap)
+{
+  struct timeval tv_start, tv_end;
+  uint64_t start, end, duration, size = 0;
+  SnippetsFnvState *state;
+  uint8_t buffer[64 * 1024], hash[8];
+  ssize_t n;
+  int fd;
+
+  gettimeofday (&tv_start, NULL);
+  if (use_mmap) {
+    snippets_fnv_hash_file (path, SNIPPETS_FNV_VARIANT_1A, 64, hash);
+  } else {
+    state = snippets_fnv_state_new (SNIPPETS_FNV_VARIANT_1A, 64);
+    fd = open (path, O_RDONLY);
+    while ((n = read (fd, buffer, sizeof (buffer))) > 0)
+      snippets_fnv_state_update (state, buffer, n);
+    close (fd);
+    snippets_fnv_state_final (state, hash);
+    snippets_fnv_state_free (state);
+  }
+  gettimeofday (&tv_end, NULL);
+
+  fd = open (path, O_RDONLY);
+  size = lseek (fd, 0, SEEK_END);
+  close (fd);
+
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec;
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec;
+  duration = end - start;
+
+  printf ("%s:\t%04lu.%06lus (%lf kb/s)\n",
+      use_mmap ? "snippets_fnv_hash_file" : "read () loop",
+      duration / 1000000, duration % 1000000,
+      (((double) size) * 1000.0) / ((double) duration));
+}
+
+#define RUN_KEYS(func, runs) do { \
+  uint64_t _duration; \
+  _duration = func (runs); \
+  printf (#func ":\t%04lu.%06lus for " #runs " runs (%lf keys/s)\n", _duration / 1000000, _duration % 1000000, (((double)runs) * N_KEYS * 1000000.0) / ((double)_duration)); \
+} while (0);
+
 #define RUN(func, runs) do { \
   uint64_t _duration; \
   _duration = run (func, runs); \
@@ -59,6 +345,12 @@ int
 main (int argc, char **argv)
 {
   int i;
+  long n_cpus;
+  unsigned int n_threads;
+
+  /* SNIPPETS_SIMD=scalar|sse4.2|avx2|avx512 forces a lower SIMD level */
+  printf ("SIMD level: %s\n", getenv ("SNIPPETS_SIMD") ?
+      getenv ("SNIPPETS_SIMD") : "auto");
 
   for (i = 0; i < sizeof (test_data); i++)
     test_data[i] = i & 0xff;
@@ -68,6 +360,9 @@ main (int argc, char **argv)
 
   RUN (snippets_fnv1_64, 100000);
   RUN (snippets_fnv1a_64, 100000);
+  RUN (fnv1a_64_unseeded, 100000);
+  RUN (fnv1a_64_seeded, 100000);
+  RUN (wyhash_64, 100000);
 
   RUN (snippets_fnv1_128, 100000);
   RUN (snippets_fnv1a_128, 100000);
@@ -81,5 +376,37 @@ main (int argc, char **argv)
   RUN (snippets_fnv1_1024, 100000);
   RUN (snippets_fnv1a_1024, 100000);
 
+  setup_keys ();
+
+  RUN_KEYS (run_keys_32, 1000);
+  RUN_KEYS (run_keys_32_batch, 1000);
+
+  RUN_KEYS (run_keys_64, 1000);
+  RUN_KEYS (run_keys_64_seeded, 1000);
+  RUN_KEYS (run_keys_64_batch, 1000);
+
+  RUN_KEYS (run_keys_u64, 1000);
+  RUN_KEYS (run_keys_u64_inline, 1000);
+
+  n_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+  if (n_cpus < 1)
+    n_cpus = 1;
+  for (n_threads = 1; n_threads < n_cpus; n_threads *= 2)
+    run_tree (n_threads);
+  run_tree (n_cpus);
+
+  if (argc > 1) {
+    run_file (argv[1], FALSE);
+    run_file (argv[1], TRUE);
+  } else {
+    char path[] = "/tmp/snippets-fnv-benchmark-XXXXXX";
+
+    close (mkstemp (path));
+    create_file (path);
+    run_file (path, FALSE);
+    run_file (path, TRUE);
+    unlink (path);
+  }
+
   return 0;
 }
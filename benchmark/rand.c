@@ -21,11 +21,15 @@
 #include "config.h"
 #endif
 
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
 
 #include <snippets/rand.h>
+#include <snippets/rand-inline.h>
+#include <snippets/philox.h>
 
 #define NRUNS 250000000
 
@@ -92,12 +96,366 @@ mt19937_double_range (void)
   snippets_rand_free (rand);
 }
 
+/* Bulk generation into a buffer of FILL_SIZE numbers */
+#define FILL_SIZE 4096
+
+static void
+mt19937_fill_uint32 (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  static uint32_t buf[FILL_SIZE];
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i += FILL_SIZE)
+    snippets_rand_fill_uint32 (rand, buf, FILL_SIZE);
+
+  snippets_rand_free (rand);
+}
+
+static void
+mt19937_fill_uint32_range (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  static uint32_t buf[FILL_SIZE];
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i += FILL_SIZE)
+    snippets_rand_fill_uint32_range (rand, buf, FILL_SIZE, 100, 1000);
+
+  snippets_rand_free (rand);
+}
+
+static void
+mt19937_fill_double (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  static double buf[FILL_SIZE];
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i += FILL_SIZE)
+    snippets_rand_fill_double (rand, buf, FILL_SIZE);
+
+  snippets_rand_free (rand);
+}
+
+static void
+mt19937_fill_double_range (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  static double buf[FILL_SIZE];
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i += FILL_SIZE)
+    snippets_rand_fill_double_range (rand, buf, FILL_SIZE, 100, 1000);
+
+  snippets_rand_free (rand);
+}
+
+/* Box-Muller on top of snippets_rand_double() for comparison */
+static void
+mt19937_box_muller (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  volatile double x;
+  unsigned int i;
+  double u, v;
+
+  for (i = 0; i < NRUNS; i += 2) {
+    u = 1.0 - snippets_rand_double (rand);
+    v = snippets_rand_double (rand);
+    x = sqrt (-2.0 * log (u)) * cos (2.0 * M_PI * v);
+    x = sqrt (-2.0 * log (u)) * sin (2.0 * M_PI * v);
+  }
+  (void) x;
+
+  snippets_rand_free (rand);
+}
+
+static void
+mt19937_normal (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i++)
+    snippets_rand_normal (rand, 0.0, 1.0);
+
+  snippets_rand_free (rand);
+}
+
+static void
+mt19937_exponential (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i++)
+    snippets_rand_exponential (rand, 1.0);
+
+  snippets_rand_free (rand);
+}
+
+static void
+mt19937_fill_normal (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  static double buf[FILL_SIZE];
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i += FILL_SIZE)
+    snippets_rand_fill_normal (rand, buf, FILL_SIZE, 0.0, 1.0);
+
+  snippets_rand_free (rand);
+}
+
+static void
+mt19937_fill_exponential (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  static double buf[FILL_SIZE];
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i += FILL_SIZE)
+    snippets_rand_fill_exponential (rand, buf, FILL_SIZE, 1.0);
+
+  snippets_rand_free (rand);
+}
+
+#define ENGINE_FUNCS(name, engine) \
+static void \
+name##_uint32 (void) \
+{ \
+  SnippetsRand *rand = snippets_rand_new_with_engine (engine, time (0)); \
+  unsigned int i; \
+  \
+  for (i = 0; i < NRUNS; i++) \
+    snippets_rand_uint32 (rand); \
+  \
+  snippets_rand_free (rand); \
+} \
+\
+static void \
+name##_fill_double (void) \
+{ \
+  SnippetsRand *rand = snippets_rand_new_with_engine (engine, time (0)); \
+  static double buf[FILL_SIZE]; \
+  unsigned int i; \
+  \
+  for (i = 0; i < NRUNS; i += FILL_SIZE) \
+    snippets_rand_fill_double (rand, buf, FILL_SIZE); \
+  \
+  snippets_rand_free (rand); \
+}
+
+#define NEW_FUNC(name, engine) \
+static void \
+name##_new (void) \
+{ \
+  unsigned int i; \
+  \
+  for (i = 0; i < NRUNS / 1000; i++) \
+    snippets_rand_free (snippets_rand_new_with_engine (engine, i)); \
+}
+
+ENGINE_FUNCS (xoshiro256ss, SNIPPETS_RAND_ENGINE_XOSHIRO256SS);
+ENGINE_FUNCS (pcg64, SNIPPETS_RAND_ENGINE_PCG64);
+ENGINE_FUNCS (splitmix64, SNIPPETS_RAND_ENGINE_SPLITMIX64);
+ENGINE_FUNCS (philox4x32, SNIPPETS_RAND_ENGINE_PHILOX4X32);
+
+/* Counter-based stream without a generator */
+static void
+philox4x32_10_fill (void)
+{
+  static const uint32_t key[2] = { 0x12345678, 0x9abcdef0 };
+  static uint32_t buf[FILL_SIZE];
+  uint32_t counter[4] = { 0, 0, 0, 0 };
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i += FILL_SIZE) {
+    snippets_philox4x32_10_fill (key, counter, buf, FILL_SIZE);
+    counter[0] += FILL_SIZE / 4;
+  }
+}
+
+static volatile uint32_t sink;
+
+/* Shuffling of NRUNS elements in total, in arrays of SHUFFLE_SMALL
+ * elements that stay in the cache and of SHUFFLE_LARGE that don't */
+#define SHUFFLE_SMALL (1 << 16)
+#define SHUFFLE_LARGE (1 << 25)
+
+static uint32_t *
+shuffle_array (size_t n)
+{
+  uint32_t *array = malloc (n * sizeof (uint32_t));
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    array[i] = i;
+
+  return array;
+}
+
+/* Fisher-Yates with one snippets_rand_uint32_range() per element */
+static void
+shuffle_naive (uint32_t * array, size_t n, SnippetsRand * rand)
+{
+  uint32_t i, j, tmp;
+
+  for (i = n - 1; i > 0; i--) {
+    j = snippets_rand_uint32_range (rand, 0, i + 1);
+    tmp = array[i];
+    array[i] = array[j];
+    array[j] = tmp;
+  }
+}
+
+#define SHUFFLE_FUNC(name, size, call) \
+static void \
+name (void) \
+{ \
+  SnippetsRand *rand = \
+      snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_XOSHIRO256SS, time (0)); \
+  uint32_t *array = shuffle_array (size); \
+  unsigned int i; \
+  \
+  for (i = 0; i < NRUNS; i += size) \
+    call; \
+  sink = array[0]; \
+  \
+  free (array); \
+  snippets_rand_free (rand); \
+}
+
+SHUFFLE_FUNC (shuffle_naive_small, SHUFFLE_SMALL,
+    shuffle_naive (array, SHUFFLE_SMALL, rand));
+SHUFFLE_FUNC (shuffle_small, SHUFFLE_SMALL,
+    snippets_rand_shuffle (rand, array, SHUFFLE_SMALL, sizeof (uint32_t)));
+SHUFFLE_FUNC (shuffle_naive_large, SHUFFLE_LARGE,
+    shuffle_naive (array, SHUFFLE_LARGE, rand));
+SHUFFLE_FUNC (shuffle_large, SHUFFLE_LARGE,
+    snippets_rand_shuffle (rand, array, SHUFFLE_LARGE, sizeof (uint32_t)));
+SHUFFLE_FUNC (shuffle_large_parallel, SHUFFLE_LARGE,
+    snippets_rand_shuffle_parallel (rand, array, SHUFFLE_LARGE,
+        sizeof (uint32_t), 4));
+
+static void
+thread_default_uint32 (void)
+{
+  uint32_t sum = 0;
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i++)
+    sum += snippets_rand_uint32 (snippets_rand_thread_default ());
+  sink = sum;
+}
+
+static void
+thread_inline_uint32 (void)
+{
+  SnippetsRandThreadState *state = snippets_rand_thread_state ();
+  uint32_t sum = 0;
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i++)
+    sum += snippets_rand_thread_uint32 (state);
+  sink = sum;
+}
+
+static void
+thread_inline_uint32_range (void)
+{
+  SnippetsRandThreadState *state = snippets_rand_thread_state ();
+  uint32_t sum = 0;
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i++)
+    sum += snippets_rand_thread_uint32_range (state, 100, 1000);
+  sink = sum;
+}
+
+NEW_FUNC (mt19937, SNIPPETS_RAND_ENGINE_MT19937);
+NEW_FUNC (xoshiro256ss, SNIPPETS_RAND_ENGINE_XOSHIRO256SS);
+NEW_FUNC (pcg64, SNIPPETS_RAND_ENGINE_PCG64);
+NEW_FUNC (splitmix64, SNIPPETS_RAND_ENGINE_SPLITMIX64);
+
+static void
+mt19937_new_from_array (void)
+{
+  uint32_t key[2] = { 0, 0x12345678 };
+  unsigned int i;
+
+  for (i = 0; i < NRUNS / 1000; i++) {
+    key[0] = i;
+    snippets_rand_free (snippets_rand_new_from_array (key, 2));
+  }
+}
+
+static void
+mt19937_new_entropy (void)
+{
+  unsigned int i;
+
+  for (i = 0; i < NRUNS / 1000; i++)
+    snippets_rand_free (snippets_rand_new_entropy ());
+}
+
+static void
+xoshiro256ss_new_entropy (void)
+{
+  unsigned int i;
+
+  for (i = 0; i < NRUNS / 1000; i++)
+    snippets_rand_free (snippets_rand_new_entropy_with_engine
+        (SNIPPETS_RAND_ENGINE_XOSHIRO256SS));
+}
+
 int
 main (int argc, char **argv)
 {
+  /* SNIPPETS_SIMD=scalar|sse4.2|avx2|avx512 forces a lower SIMD level */
+  printf ("SIMD level: %s\n", getenv ("SNIPPETS_SIMD") ?
+      getenv ("SNIPPETS_SIMD") : "auto");
+
   RUN (mt19937_uint32, "MT19937 uint32       ");
   RUN (mt19937_uint32_range, "MT19937 uint32 range ");
   RUN (mt19937_double, "MT19937 double       ");
   RUN (mt19937_double_range, "MT19937 double range ");
+  RUN (mt19937_fill_uint32, "MT19937 fill uint32  ");
+  RUN (mt19937_fill_uint32_range, "MT19937 fill uint32 range");
+  RUN (mt19937_fill_double, "MT19937 fill double  ");
+  RUN (mt19937_fill_double_range, "MT19937 fill double range");
+  RUN (mt19937_box_muller, "MT19937 Box-Muller   ");
+  RUN (mt19937_normal, "MT19937 normal       ");
+  RUN (mt19937_exponential, "MT19937 exponential  ");
+  RUN (mt19937_fill_normal, "MT19937 fill normal  ");
+  RUN (mt19937_fill_exponential, "MT19937 fill exponential");
+
+  RUN (xoshiro256ss_uint32, "xoshiro256** uint32  ");
+  RUN (xoshiro256ss_fill_double, "xoshiro256** fill double");
+  RUN (pcg64_uint32, "PCG64 uint32         ");
+  RUN (pcg64_fill_double, "PCG64 fill double    ");
+  RUN (splitmix64_uint32, "SplitMix64 uint32    ");
+  RUN (splitmix64_fill_double, "SplitMix64 fill double");
+  RUN (philox4x32_uint32, "Philox4x32 uint32    ");
+  RUN (philox4x32_fill_double, "Philox4x32 fill double");
+  RUN (philox4x32_10_fill, "Philox4x32-10 fill   ");
+  RUN (thread_default_uint32, "Thread default uint32");
+  RUN (thread_inline_uint32, "Thread inline uint32 ");
+  RUN (thread_inline_uint32_range, "Thread inline uint32 range");
+  RUN (shuffle_naive_small, "Naive shuffle 64K    ");
+  RUN (shuffle_small, "Shuffle 64K          ");
+  RUN (shuffle_naive_large, "Naive shuffle 32M    ");
+  RUN (shuffle_large, "Shuffle 32M          ");
+  RUN (shuffle_large_parallel, "Shuffle 32M, 4 threads");
+
+  /* Creation of NRUNS / 1000 generators */
+  RUN (mt19937_new, "MT19937 new          ");
+  RUN (xoshiro256ss_new, "xoshiro256** new     ");
+  RUN (pcg64_new, "PCG64 new            ");
+  RUN (splitmix64_new, "SplitMix64 new       ");
+  RUN (mt19937_new_from_array, "MT19937 new from array");
+  RUN (mt19937_new_entropy, "MT19937 new entropy  ");
+  RUN (xoshiro256ss_new_entropy, "xoshiro256** new entropy");
   return 0;
 }
@@ -0,0 +1,237 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <snippets/rand.h>
+#include <snippets/sampler.h>
+
+#define NRUNS 10000000
+#define N_WEIGHTS 1024
+
+#define RUN(func, name) do { \
+  uint64_t start, end, duration; \
+  struct timeval tv_start, tv_end; \
+  \
+  gettimeofday (&tv_start, NULL); \
+  func(); \
+  gettimeofday (&tv_end, NULL); \
+  \
+  start = tv_start.tv_sec * 1000000 + tv_start.tv_usec; \
+  end = tv_end.tv_sec * 1000000 + tv_end.tv_usec; \
+  \
+  duration = end - start; \
+  printf (name ":\t%04lu.%06lus for %d runs\n", duration / 1000000, duration % 1000000, NRUNS); \
+} while (0);
+
+static double weights[N_WEIGHTS];
+static volatile uint32_t sink;
+
+static void
+init_weights (void)
+{
+  unsigned int i;
+
+  for (i = 0; i < N_WEIGHTS; i++)
+    weights[i] = 1.0 / (i + 1);
+}
+
+/* Linear scan over the weights for comparison */
+static void
+cumulative_scan (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  double sum = 0, r;
+  uint32_t total = 0;
+  unsigned int i, j;
+
+  for (j = 0; j < N_WEIGHTS; j++)
+    sum += weights[j];
+
+  for (i = 0; i < NRUNS; i++) {
+    r = snippets_rand_double (rand) * sum;
+    for (j = 0; j < N_WEIGHTS - 1 && r >= weights[j]; j++)
+      r -= weights[j];
+    total += j;
+  }
+  sink = total;
+
+  snippets_rand_free (rand);
+}
+
+static void
+alias_sample (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  SnippetsWeightedSampler *sampler;
+  uint32_t total = 0;
+  unsigned int i;
+
+  sampler = snippets_weighted_sampler_new (weights, N_WEIGHTS);
+  for (i = 0; i < NRUNS; i++)
+    total += snippets_weighted_sampler_sample (sampler, rand);
+  sink = total;
+
+  snippets_weighted_sampler_free (sampler);
+  snippets_rand_free (rand);
+}
+
+#define FILL_SIZE 4096
+
+static void
+alias_fill (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  SnippetsWeightedSampler *sampler;
+  static uint32_t buf[FILL_SIZE];
+  unsigned int i;
+
+  sampler = snippets_weighted_sampler_new (weights, N_WEIGHTS);
+  for (i = 0; i < NRUNS; i += FILL_SIZE)
+    snippets_weighted_sampler_fill (sampler, rand, buf, FILL_SIZE);
+
+  snippets_weighted_sampler_free (sampler);
+  snippets_rand_free (rand);
+}
+
+/* A weight update and a rebuild every 1000 samples */
+static void
+alias_update (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  SnippetsWeightedSampler *sampler;
+  uint32_t total = 0;
+  unsigned int i;
+
+  sampler = snippets_weighted_sampler_new (weights, N_WEIGHTS);
+  for (i = 0; i < NRUNS; i++) {
+    if (i % 1000 == 0)
+      snippets_weighted_sampler_set_weight (sampler, i % N_WEIGHTS, i % 7);
+    total += snippets_weighted_sampler_sample (sampler, rand);
+  }
+  sink = total;
+
+  snippets_weighted_sampler_free (sampler);
+  snippets_rand_free (rand);
+}
+
+#define CAPACITY 1000
+
+/* Algorithm R, one random number per item, for comparison */
+static void
+reservoir_r (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  static uint32_t reservoir[CAPACITY];
+  uint32_t j;
+  unsigned int i;
+
+  for (i = 0; i < NRUNS; i++) {
+    if (i < CAPACITY) {
+      reservoir[i] = i;
+    } else {
+      j = snippets_rand_uint32_range (rand, 0, i + 1);
+      if (j < CAPACITY)
+        reservoir[j] = i;
+    }
+  }
+  sink = reservoir[0];
+
+  snippets_rand_free (rand);
+}
+
+static void
+reservoir_add (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  SnippetsReservoir *reservoir;
+  unsigned int i;
+
+  reservoir = snippets_reservoir_new (CAPACITY, sizeof (i), NULL, NULL);
+  for (i = 0; i < NRUNS; i++)
+    snippets_reservoir_add (reservoir, rand, &i);
+  sink = *snippets_reservoir_get (reservoir, 0, unsigned int);
+
+  snippets_reservoir_free (reservoir);
+  snippets_rand_free (rand);
+}
+
+static void
+reservoir_add_array (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  SnippetsReservoir *reservoir;
+  static uint32_t buf[FILL_SIZE];
+  unsigned int i;
+
+  for (i = 0; i < FILL_SIZE; i++)
+    buf[i] = i;
+
+  reservoir = snippets_reservoir_new (CAPACITY, sizeof (uint32_t), NULL, NULL);
+  for (i = 0; i < NRUNS; i += FILL_SIZE)
+    snippets_reservoir_add_array (reservoir, rand, buf, FILL_SIZE);
+  sink = *snippets_reservoir_get (reservoir, 0, uint32_t);
+
+  snippets_reservoir_free (reservoir);
+  snippets_rand_free (rand);
+}
+
+static void
+weighted_reservoir_add (void)
+{
+  SnippetsRand *rand = snippets_rand_new (time (0));
+  SnippetsWeightedReservoir *reservoir;
+  unsigned int i;
+
+  reservoir =
+      snippets_weighted_reservoir_new (CAPACITY, sizeof (i), NULL, NULL);
+  for (i = 0; i < NRUNS; i++)
+    snippets_weighted_reservoir_add (reservoir, rand, &i,
+        weights[i % N_WEIGHTS]);
+  sink = *snippets_weighted_reservoir_get (reservoir, 0, unsigned int);
+
+  snippets_weighted_reservoir_free (reservoir);
+  snippets_rand_free (rand);
+}
+
+int
+main (int argc, char **argv)
+{
+  init_weights ();
+
+  RUN (cumulative_scan, "Cumulative scan      ");
+  RUN (alias_sample, "Alias sample         ");
+  RUN (alias_fill, "Alias fill           ");
+  RUN (alias_update, "Alias with updates   ");
+
+  /* Samples of CAPACITY items from a stream of NRUNS */
+  RUN (reservoir_r, "Reservoir algorithm R");
+  RUN (reservoir_add, "Reservoir add        ");
+  RUN (reservoir_add_array, "Reservoir add array  ");
+  RUN (weighted_reservoir_add, "Weighted reservoir add");
+
+  return 0;
+}
@@ -23,6 +23,9 @@
 
 #include <snippets/bloomfilter.h>
 #include <snippets/fnv.h>
+#include <snippets/wyhash.h>
+
+#include "fnv-private.h"
 
 #include <math.h>
 
@@ -31,6 +34,7 @@
 #endif
 
 #include <assert.h>
+#include <string.h>
 
 /* This implements a bloom filter, see
  *
@@ -56,41 +60,128 @@ struct _SnippetsBloomFilter
   unsigned int n_hash_functions;
   unsigned int hash_size;
 
-  void (*hash) (const uint8_t * data, size_t size, uint8_t * hash);
+  SnippetsBloomFilterHash hash_type;
+  void (*hash) (SnippetsBloomFilter * filter, const uint8_t * data,
+      size_t size, uint32_t * hash);
+
+  int seeded;
+  uint64_t seed[2];
+  uint64_t wyhash_seed;
 };
 
+static void
+bloom_filter_fnv1a_64 (SnippetsBloomFilter * filter, const uint8_t * data,
+    size_t size, uint32_t * hash)
+{
+  uint64_t tmp = snippets_fnv1a_64_uint64 (data, size);
+
+  hash[0] = tmp >> 32;
+  hash[1] = tmp & 0xffffffff;
+}
+
+static void
+bloom_filter_fnv1a_words (SnippetsBloomFilter * filter, const uint8_t * data,
+    size_t size, uint32_t * hash)
+{
+  switch (filter->hash_size) {
+    case 128:
+      snippets_fnv1a_128_words (data, size, hash);
+      break;
+    case 256:
+      snippets_fnv1a_256_words (data, size, hash);
+      break;
+    case 512:
+      snippets_fnv1a_512_words (data, size, hash);
+      break;
+    case 1024:
+      snippets_fnv1a_1024_words (data, size, hash);
+      break;
+  }
+}
+
+static void
+bloom_filter_fnv1a_seeded (SnippetsBloomFilter * filter, const uint8_t * data,
+    size_t size, uint32_t * hash)
+{
+  struct iovec iov;
+
+  iov.iov_base = (void *) data;
+  iov.iov_len = size;
+  _snippets_fnv1a_iov_words (filter->hash_size, filter->seed, &iov, 1, hash);
+}
+
+static void
+bloom_filter_wyhash_64 (SnippetsBloomFilter * filter, const uint8_t * data,
+    size_t size, uint32_t * hash)
+{
+  uint64_t tmp = snippets_wyhash_64 (data, size, filter->wyhash_seed);
+
+  hash[0] = tmp >> 32;
+  hash[1] = tmp & 0xffffffff;
+}
+
+static void
+bloom_filter_wyhash_128 (SnippetsBloomFilter * filter, const uint8_t * data,
+    size_t size, uint32_t * hash)
+{
+  uint64_t tmp[2];
+
+  snippets_wyhash_128 (data, size, filter->wyhash_seed, tmp);
+
+  hash[0] = tmp[0] >> 32;
+  hash[1] = tmp[0] & 0xffffffff;
+  hash[2] = tmp[1] >> 32;
+  hash[3] = tmp[1] & 0xffffffff;
+}
+
 SnippetsBloomFilter *
-snippets_bloom_filter_new (uint32_t size, unsigned int n_hash_functions,
-    unsigned int hash_size)
+snippets_bloom_filter_new_full (uint32_t size, unsigned int n_hash_functions,
+    SnippetsBloomFilterHash hash_type, unsigned int hash_size,
+    const uint64_t seed[2])
 {
   SnippetsBloomFilter *filter;
 
   assert (size > 0);
   assert (n_hash_functions > 0);
+  assert (hash_type == SNIPPETS_BLOOM_FILTER_HASH_FNV1A ||
+      hash_type == SNIPPETS_BLOOM_FILTER_HASH_WYHASH);
   assert (hash_size > 0 && hash_size <= 1024);
+  assert (hash_type != SNIPPETS_BLOOM_FILTER_HASH_WYHASH || hash_size <= 128);
 
   /* Round up to next byte multiple */
   size = (((size) + 7) & ~7);
 
   filter = calloc (sizeof (SnippetsBloomFilter) + size / 8, 1);
 
-  if (hash_size <= 64) {
+  if (hash_size <= 64)
     filter->hash_size = 64;
-    filter->hash = snippets_fnv1a_64;
-  } else if (hash_size <= 128) {
+  else if (hash_size <= 128)
     filter->hash_size = 128;
-    filter->hash = snippets_fnv1a_128;
-  } else if (hash_size <= 256) {
+  else if (hash_size <= 256)
     filter->hash_size = 256;
-    filter->hash = snippets_fnv1a_256;
-  } else if (hash_size <= 512) {
+  else if (hash_size <= 512)
     filter->hash_size = 512;
-    filter->hash = snippets_fnv1a_512;
-  } else if (hash_size <= 1024) {
+  else if (hash_size <= 1024)
     filter->hash_size = 1024;
-    filter->hash = snippets_fnv1a_1024;
+
+  filter->hash_type = hash_type;
+  if (seed) {
+    filter->seeded = TRUE;
+    filter->seed[0] = seed[0];
+    filter->seed[1] = seed[1];
+    /* wyhash only takes a 64 bit seed */
+    filter->wyhash_seed = seed[0] ^ ((seed[1] << 32) | (seed[1] >> 32));
   }
 
+  if (hash_type == SNIPPETS_BLOOM_FILTER_HASH_WYHASH)
+    filter->hash = filter->hash_size == 64 ?
+        bloom_filter_wyhash_64 : bloom_filter_wyhash_128;
+  else if (seed)
+    filter->hash = bloom_filter_fnv1a_seeded;
+  else
+    filter->hash = filter->hash_size == 64 ?
+        bloom_filter_fnv1a_64 : bloom_filter_fnv1a_words;
+
   filter->filter = ((uint8_t *) filter) + sizeof (SnippetsBloomFilter);
   filter->size = size;
   filter->n_hash_functions = n_hash_functions;
@@ -98,14 +189,87 @@ snippets_bloom_filter_new (uint32_t size, unsigned int n_hash_functions,
   return filter;
 }
 
+SnippetsBloomFilter *
+snippets_bloom_filter_new (uint32_t size, unsigned int n_hash_functions,
+    unsigned int hash_size)
+{
+  return snippets_bloom_filter_new_full (size, n_hash_functions,
+      SNIPPETS_BLOOM_FILTER_HASH_FNV1A, hash_size, NULL);
+}
+
+SnippetsBloomFilter *
+snippets_bloom_filter_new_seeded (uint32_t size, unsigned int n_hash_functions,
+    unsigned int hash_size, const uint64_t seed[2])
+{
+  assert (seed != NULL);
+
+  return snippets_bloom_filter_new_full (size, n_hash_functions,
+      SNIPPETS_BLOOM_FILTER_HASH_FNV1A, hash_size, seed);
+}
+
+/* Calculates the hash of the concatenated buffers of @iov
+ * as 32 bit words for snippets_bloom_filter_hash() */
+static void
+bloom_filter_hash_iov (SnippetsBloomFilter * filter, const struct iovec *iov,
+    int n, uint32_t * hash)
+{
+  uint8_t stack_buf[256], *buf;
+  size_t len, pos;
+  int i;
+
+  if (filter->hash_type == SNIPPETS_BLOOM_FILTER_HASH_FNV1A) {
+    _snippets_fnv1a_iov_words (filter->hash_size,
+        filter->seeded ? filter->seed : NULL, iov, n, hash);
+    return;
+  }
+
+  /* wyhash can't be calculated incrementally, so gather the
+   * buffers unless there is only one */
+  if (n == 1) {
+    filter->hash (filter, iov[0].iov_base, iov[0].iov_len, hash);
+    return;
+  }
+
+  for (i = 0, len = 0; i < n; i++)
+    len += iov[i].iov_len;
+
+  if (len == 0) {
+    filter->hash (filter, NULL, 0, hash);
+    return;
+  }
+
+  buf = len <= sizeof (stack_buf) ? stack_buf : malloc (len);
+  for (i = 0, pos = 0; i < n; i++) {
+    if (iov[i].iov_len)
+      memcpy (buf + pos, iov[i].iov_base, iov[i].iov_len);
+    pos += iov[i].iov_len;
+  }
+
+  filter->hash (filter, buf, len, hash);
+
+  if (buf != stack_buf)
+    free (buf);
+}
+
 #define SET_BIT(filter, bit) (filter[bit / 8] |= (1 << (bit % 8)))
 #define GET_BIT(filter, bit) (filter[bit / 8] & (1 << (bit % 8)))
 
+#define HANDLE_BIT(bit) do { \
+  if (!GET_BIT (filter->filter, bit)) { \
+    if (!set) \
+      return FALSE; \
+    SET_BIT (filter->filter, bit); \
+    found = FALSE; \
+  } \
+} while (0)
+
+/* Sets or checks the bits selected by @hash, which has
+ * filter->hash_size bits. Returns %TRUE if all of them were
+ * set already */
 static int
-snippets_bloom_filter_hash (SnippetsBloomFilter * filter, const uint8_t * data,
-    size_t length, int set)
+snippets_bloom_filter_hash (SnippetsBloomFilter * filter, const uint32_t * hash,
+    int set)
 {
-  uint32_t hash[32];
   unsigned int n_hash_functions, first_n_hash_functions;
   unsigned int hash_index;
   unsigned int hash_values;
@@ -113,6 +277,7 @@ snippets_bloom_filter_hash (SnippetsBloomFilter * filter, const uint8_t * data,
   unsigned int last_functions;
   uint32_t x, y;
   uint32_t size;
+  int found = TRUE;
   int i, j;
 
   size = filter->size;
@@ -138,8 +303,6 @@ snippets_bloom_filter_hash (SnippetsBloomFilter * filter, const uint8_t * data,
     first_n_hash_functions = n_hash_functions - last_functions;
   }
 
-  filter->hash (data, length, (uint8_t *) hash);
-
   hash_index = 0;
 
   /* If there are fewer hash functions than hash value pairs
@@ -156,19 +319,13 @@ snippets_bloom_filter_hash (SnippetsBloomFilter * filter, const uint8_t * data,
     if (functions_per_value == 1)
       x = (x + y) % size;
 
-    if (set)
-      SET_BIT (filter->filter, x);
-    else if (!GET_BIT (filter->filter, x))
-      return FALSE;
+    HANDLE_BIT (x);
 
     for (j = 0; j < functions_per_value - 1; j++) {
       x = (x + y) % size;
       y = (y + j) % size;
 
-      if (set)
-        SET_BIT (filter->filter, x);
-      else if (!GET_BIT (filter->filter, x))
-        return FALSE;
+      HANDLE_BIT (x);
     }
     hash_index++;
   }
@@ -180,33 +337,30 @@ snippets_bloom_filter_hash (SnippetsBloomFilter * filter, const uint8_t * data,
     x = hash[hash_index] % size;
     y = hash[hash_index + hash_values / 2] % size;
 
-    if (set)
-      SET_BIT (filter->filter, x);
-    else if (!GET_BIT (filter->filter, x))
-      return FALSE;
+    HANDLE_BIT (x);
 
     for (j = 0; j < last_functions - 1; j++) {
       x = (x + y) % size;
       y = (y + j) % size;
 
-      if (set)
-        SET_BIT (filter->filter, x);
-      else if (!GET_BIT (filter->filter, x))
-        return FALSE;
+      HANDLE_BIT (x);
     }
   }
 
-  return TRUE;
+  return found;
 }
 
 void
 snippets_bloom_filter_insert (SnippetsBloomFilter * filter,
     const uint8_t * data, size_t length)
 {
+  uint32_t hash[32];
+
   assert (filter != NULL);
   assert (data != NULL);
 
-  snippets_bloom_filter_hash (filter, data, length, TRUE);
+  filter->hash (filter, data, length, hash);
+  snippets_bloom_filter_hash (filter, hash, TRUE);
   filter->n_elements++;
 }
 
@@ -214,10 +368,142 @@ int
 snippets_bloom_filter_contains (SnippetsBloomFilter * filter,
     const uint8_t * data, size_t length)
 {
+  uint32_t hash[32];
+
+  assert (filter != NULL);
+  assert (data != NULL);
+
+  filter->hash (filter, data, length, hash);
+  return snippets_bloom_filter_hash (filter, hash, FALSE);
+}
+
+void
+snippets_bloom_filter_insert_iov (SnippetsBloomFilter * filter,
+    const struct iovec *iov, int n)
+{
+  uint32_t hash[32];
+
+  assert (filter != NULL);
+  assert (iov != NULL || n == 0);
+
+  bloom_filter_hash_iov (filter, iov, n, hash);
+  snippets_bloom_filter_hash (filter, hash, TRUE);
+  filter->n_elements++;
+}
+
+int
+snippets_bloom_filter_contains_iov (SnippetsBloomFilter * filter,
+    const struct iovec *iov, int n)
+{
+  uint32_t hash[32];
+
+  assert (filter != NULL);
+  assert (iov != NULL || n == 0);
+
+  bloom_filter_hash_iov (filter, iov, n, hash);
+  return snippets_bloom_filter_hash (filter, hash, FALSE);
+}
+
+int
+snippets_bloom_filter_test_and_insert (SnippetsBloomFilter * filter,
+    const uint8_t * data, size_t length)
+{
+  uint32_t hash[32];
+  int found;
+
   assert (filter != NULL);
   assert (data != NULL);
 
-  return snippets_bloom_filter_hash (filter, data, length, FALSE);
+  filter->hash (filter, data, length, hash);
+  found = snippets_bloom_filter_hash (filter, hash, TRUE);
+  if (!found)
+    filter->n_elements++;
+
+  return found;
+}
+
+void
+snippets_bloom_filter_hash_key (SnippetsBloomFilter * filter,
+    const uint8_t * data, size_t length, SnippetsHashedKey * key)
+{
+  assert (filter != NULL);
+  assert (data != NULL);
+  assert (key != NULL);
+
+  key->hash_type = filter->hash_type;
+  key->hash_size = filter->hash_size;
+  key->seeded = filter->seeded;
+  key->seed[0] = filter->seed[0];
+  key->seed[1] = filter->seed[1];
+  filter->hash (filter, data, length, key->hash);
+}
+
+void
+snippets_bloom_filter_hash_key_iov (SnippetsBloomFilter * filter,
+    const struct iovec *iov, int n, SnippetsHashedKey * key)
+{
+  assert (filter != NULL);
+  assert (iov != NULL || n == 0);
+  assert (key != NULL);
+
+  key->hash_type = filter->hash_type;
+  key->hash_size = filter->hash_size;
+  key->seeded = filter->seeded;
+  key->seed[0] = filter->seed[0];
+  key->seed[1] = filter->seed[1];
+  bloom_filter_hash_iov (filter, iov, n, key->hash);
+}
+
+/* Checks if @key was calculated with the same hash
+ * configuration as used by @filter */
+static int
+bloom_filter_key_compatible (SnippetsBloomFilter * filter,
+    const SnippetsHashedKey * key)
+{
+  return key->hash_type == filter->hash_type &&
+      key->hash_size == filter->hash_size &&
+      key->seeded == filter->seeded &&
+      key->seed[0] == filter->seed[0] && key->seed[1] == filter->seed[1];
+}
+
+void
+snippets_bloom_filter_insert_hashed (SnippetsBloomFilter * filter,
+    const SnippetsHashedKey * key)
+{
+  assert (filter != NULL);
+  assert (key != NULL);
+  assert (bloom_filter_key_compatible (filter, key));
+
+  snippets_bloom_filter_hash (filter, key->hash, TRUE);
+  filter->n_elements++;
+}
+
+int
+snippets_bloom_filter_contains_hashed (SnippetsBloomFilter * filter,
+    const SnippetsHashedKey * key)
+{
+  assert (filter != NULL);
+  assert (key != NULL);
+  assert (bloom_filter_key_compatible (filter, key));
+
+  return snippets_bloom_filter_hash (filter, key->hash, FALSE);
+}
+
+int
+snippets_bloom_filter_test_and_insert_hashed (SnippetsBloomFilter * filter,
+    const SnippetsHashedKey * key)
+{
+  int found;
+
+  assert (filter != NULL);
+  assert (key != NULL);
+  assert (bloom_filter_key_compatible (filter, key));
+
+  found = snippets_bloom_filter_hash (filter, key->hash, TRUE);
+  if (!found)
+    filter->n_elements++;
+
+  return found;
 }
 
 void
@@ -250,6 +536,14 @@ snippets_bloom_filter_n_hash_functions (SnippetsBloomFilter * filter)
   return filter->n_hash_functions;
 }
 
+SnippetsBloomFilterHash
+snippets_bloom_filter_hash_type (SnippetsBloomFilter * filter)
+{
+  assert (filter != NULL);
+
+  return filter->hash_type;
+}
+
 uint32_t
 snippets_bloom_filter_size (SnippetsBloomFilter * filter)
 {
@@ -22,15 +22,62 @@
 
 #include <snippets/utils.h>
 
+#include <sys/uio.h>
+
 typedef struct _SnippetsBloomFilter SnippetsBloomFilter;
 
+/** SnippetsBloomFilterHash:
+ *  @SNIPPETS_BLOOM_FILTER_HASH_FNV1A: FNV1A with 64 to 1024 bits, the default
+ *  @SNIPPETS_BLOOM_FILTER_HASH_WYHASH: wyhash with 64 or 128 bits, much
+ *    faster for long keys
+ *
+ *  Hash function used for selecting the bits of an element.
+ */
+typedef enum {
+  SNIPPETS_BLOOM_FILTER_HASH_FNV1A = 0,
+  SNIPPETS_BLOOM_FILTER_HASH_WYHASH
+} SnippetsBloomFilterHash;
+
+/** SnippetsHashedKey:
+ *
+ *  Digest of a key as calculated by snippets_bloom_filter_hash_key(),
+ *  so that it can be checked and inserted without hashing it again.
+ *  It can be used with every bloom filter that has the same hash
+ *  function, hash size and seed as the filter it was calculated for.
+ *
+ *  Usually allocated on the stack, all fields are private.
+ */
+typedef struct {
+  /* < private > */
+  SnippetsBloomFilterHash hash_type;
+  unsigned int hash_size;
+  int seeded;
+  uint64_t seed[2];
+  uint32_t hash[32];
+} SnippetsHashedKey;
+
 SnippetsBloomFilter * snippets_bloom_filter_new       (uint32_t size, unsigned int n_hash_functions, unsigned int hash_size);
+SnippetsBloomFilter * snippets_bloom_filter_new_seeded (uint32_t size, unsigned int n_hash_functions, unsigned int hash_size, const uint64_t seed[2]);
+SnippetsBloomFilter * snippets_bloom_filter_new_full (uint32_t size, unsigned int n_hash_functions, SnippetsBloomFilterHash hash, unsigned int hash_size, const uint64_t seed[2]);
 void          snippets_bloom_filter_insert    (SnippetsBloomFilter *filter, const uint8_t *data, size_t length);
 int           snippets_bloom_filter_contains  (SnippetsBloomFilter *filter, const uint8_t *data, size_t length);
+void          snippets_bloom_filter_insert_iov   (SnippetsBloomFilter *filter, const struct iovec *iov, int n);
+int           snippets_bloom_filter_contains_iov (SnippetsBloomFilter *filter, const struct iovec *iov, int n);
+/* Inserts the element and returns whether it was contained before,
+ * only elements that were not contained are counted */
+int           snippets_bloom_filter_test_and_insert (SnippetsBloomFilter *filter, const uint8_t *data, size_t length);
+
+void          snippets_bloom_filter_hash_key     (SnippetsBloomFilter *filter, const uint8_t *data, size_t length, SnippetsHashedKey *key);
+void          snippets_bloom_filter_hash_key_iov (SnippetsBloomFilter *filter, const struct iovec *iov, int n, SnippetsHashedKey *key);
+void          snippets_bloom_filter_insert_hashed   (SnippetsBloomFilter *filter, const SnippetsHashedKey *key);
+int           snippets_bloom_filter_contains_hashed (SnippetsBloomFilter *filter, const SnippetsHashedKey *key);
+int           snippets_bloom_filter_test_and_insert_hashed (SnippetsBloomFilter *filter, const SnippetsHashedKey *key);
+
 void          snippets_bloom_filter_free      (SnippetsBloomFilter *filter);
 
 unsigned int snippets_bloom_filter_n_hash_functions (SnippetsBloomFilter *filter);
 uint32_t snippets_bloom_filter_size (SnippetsBloomFilter *filter);
+SnippetsBloomFilterHash snippets_bloom_filter_hash_type (SnippetsBloomFilter *filter);
 
 uint64_t snippets_bloom_filter_n_elements (SnippetsBloomFilter *filter);
 double snippets_bloom_filter_false_positive_rate (SnippetsBloomFilter *filter);
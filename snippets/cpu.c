@@ -0,0 +1,76 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cpu.h"
+
+#include <string.h>
+
+static SnippetsCpuLevel
+cpu_detect_level (void)
+{
+#ifdef HAVE_X86_SIMD_DISPATCH
+  __builtin_cpu_init ();
+
+  if (__builtin_cpu_supports ("avx512f")
+      && __builtin_cpu_supports ("avx512dq"))
+    return SNIPPETS_CPU_LEVEL_AVX512;
+  if (__builtin_cpu_supports ("avx2"))
+    return SNIPPETS_CPU_LEVEL_AVX2;
+  if (__builtin_cpu_supports ("sse4.2"))
+    return SNIPPETS_CPU_LEVEL_SSE42;
+#endif
+
+  return SNIPPETS_CPU_LEVEL_SCALAR;
+}
+
+/* Detected once on first use. Concurrent first calls from multiple
+ * threads all calculate and store the same value */
+SnippetsCpuLevel
+_snippets_cpu_level (void)
+{
+  static int level = -1;
+  SnippetsCpuLevel detected, forced;
+  const char *env;
+
+  if (level != -1)
+    return level;
+
+  detected = forced = cpu_detect_level ();
+
+  env = getenv ("SNIPPETS_SIMD");
+  if (env) {
+    if (strcmp (env, "scalar") == 0)
+      forced = SNIPPETS_CPU_LEVEL_SCALAR;
+    else if (strcmp (env, "sse4.2") == 0)
+      forced = SNIPPETS_CPU_LEVEL_SSE42;
+    else if (strcmp (env, "avx2") == 0)
+      forced = SNIPPETS_CPU_LEVEL_AVX2;
+    else if (strcmp (env, "avx512") == 0)
+      forced = SNIPPETS_CPU_LEVEL_AVX512;
+  }
+
+  /* Never use instructions the CPU doesn't have */
+  level = (forced < detected) ? forced : detected;
+
+  return level;
+}
@@ -0,0 +1,57 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SNIPPETS_CPU_H__
+#define __SNIPPETS_CPU_H__
+
+#include <snippets/utils.h>
+
+SNIPPETS_BEGIN_DECLS
+
+/* Internal, not installed: Runtime selection of SIMD implementations.
+ *
+ * The SIMD implementations are compiled with the target attribute
+ * for their instruction set, independent of the compiler flags used
+ * for the remaining code, and the best level supported by the CPU
+ * is selected at runtime.
+ *
+ * The SNIPPETS_SIMD environment variable can be set to "scalar",
+ * "sse4.2", "avx2" or "avx512" to use a lower level than supported,
+ * e.g. for benchmarking the different implementations.
+ */
+
+typedef enum
+{
+  SNIPPETS_CPU_LEVEL_SCALAR = 0,
+  SNIPPETS_CPU_LEVEL_SSE42,
+  SNIPPETS_CPU_LEVEL_AVX2,
+  SNIPPETS_CPU_LEVEL_AVX512
+} SnippetsCpuLevel;
+
+#ifdef HAVE_X86_SIMD_DISPATCH
+#define SNIPPETS_TARGET_SSE42 __attribute__ ((target ("sse4.2")))
+#define SNIPPETS_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#define SNIPPETS_TARGET_AVX512 __attribute__ ((target ("avx512f,avx512dq")))
+#endif
+
+SnippetsCpuLevel _snippets_cpu_level (void);
+
+SNIPPETS_END_DECLS
+
+#endif /* __SNIPPETS_CPU_H__ */
@@ -0,0 +1,103 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SNIPPETS_FNV_INLINE_H__
+#define __SNIPPETS_FNV_INLINE_H__
+
+#include <snippets/utils.h>
+
+#include <string.h>
+
+SNIPPETS_BEGIN_DECLS
+
+/* Inline FNV1A 64 bit hashing of short, fixed size keys.
+ *
+ * For keys of a known, small size the call to snippets_fnv1a_64()
+ * is more expensive than the hashing itself. The functions below
+ * hash the bytes of the key as they are stored in memory, i.e. they
+ * give the same result as snippets_fnv1a_64_uint64() on a pointer
+ * to the key, but can be completely unrolled by the compiler.
+ */
+
+#define SNIPPETS_FNV_INLINE_PRIME_64 1099511628211ULL
+#define SNIPPETS_FNV_INLINE_OFFSET_64 14695981039346656037ULL
+
+/** fnv1a_64_u32:
+ *  @key: Key to be hashed
+ *
+ *  Calculates the FNV1A 64 bit hash from the 4 bytes of @key
+ *  and returns it as an integer in host byte order.
+ */
+static inline uint64_t
+snippets_fnv1a_64_u32 (uint32_t key)
+{
+  uint8_t data[4];
+  uint64_t hash = SNIPPETS_FNV_INLINE_OFFSET_64;
+  int i;
+
+  memcpy (data, &key, sizeof (data));
+  for (i = 0; i < 4; i++)
+    hash = (hash ^ data[i]) * SNIPPETS_FNV_INLINE_PRIME_64;
+
+  return hash;
+}
+
+/** fnv1a_64_u64:
+ *  @key: Key to be hashed
+ *
+ *  Calculates the FNV1A 64 bit hash from the 8 bytes of @key
+ *  and returns it as an integer in host byte order.
+ */
+static inline uint64_t
+snippets_fnv1a_64_u64 (uint64_t key)
+{
+  uint8_t data[8];
+  uint64_t hash = SNIPPETS_FNV_INLINE_OFFSET_64;
+  int i;
+
+  memcpy (data, &key, sizeof (data));
+  for (i = 0; i < 8; i++)
+    hash = (hash ^ data[i]) * SNIPPETS_FNV_INLINE_PRIME_64;
+
+  return hash;
+}
+
+/** fnv1a_64_u128:
+ *  @key: Pointer to the 16 byte key to be hashed
+ *
+ *  Calculates the FNV1A 64 bit hash from the 16 bytes of @key
+ *  and returns it as an integer in host byte order.
+ */
+static inline uint64_t
+snippets_fnv1a_64_u128 (const uint64_t key[2])
+{
+  uint8_t data[16];
+  uint64_t hash = SNIPPETS_FNV_INLINE_OFFSET_64;
+  int i;
+
+  memcpy (data, key, sizeof (data));
+  for (i = 0; i < 16; i++)
+    hash = (hash ^ data[i]) * SNIPPETS_FNV_INLINE_PRIME_64;
+
+  return hash;
+}
+
+SNIPPETS_END_DECLS
+
+#endif /* __SNIPPETS_FNV_INLINE_H__ */
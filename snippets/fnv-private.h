@@ -0,0 +1,39 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SNIPPETS_FNV_PRIVATE_H__
+#define __SNIPPETS_FNV_PRIVATE_H__
+
+#include <snippets/utils.h>
+
+#include <sys/uio.h>
+
+SNIPPETS_BEGIN_DECLS
+
+/* Internal, not installed */
+
+/* Calculates the FNV1A hash of @width bits, at least 64, from the
+ * buffers of @iov and puts it into @hash as 32 bit integers in host
+ * byte order, highest word first. If @seed is not %NULL the hash is
+ * seeded like snippets_fnv_state_new_seeded() */
+void _snippets_fnv1a_iov_words (unsigned int width, const uint64_t *seed, const struct iovec *iov, int n, uint32_t *hash);
+
+SNIPPETS_END_DECLS
+
+#endif /* __SNIPPETS_FNV_PRIVATE_H__ */
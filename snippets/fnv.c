@@ -23,6 +23,30 @@
 
 #include <snippets/fnv.h>
 
+#include <assert.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include "cpu.h"
+#include "fnv-private.h"
+
+#ifdef HAVE_X86_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
 /* Implementations of the Fowler–Noll–Vo hash function.
  * This implements FNV 1 and 1A for various bit depths
  *
@@ -30,14 +54,264 @@
  * http://www.isthe.com/chongo/tech/comp/fnv/index.html
  */
 
+/* Writes the hash value from the internal representation
+ * to @hash, highest byte first */
+static void
+fnv_final (const uint64_t * state, unsigned int width, uint8_t * hash)
+{
+  unsigned int i;
+
+  if (width == 64) {
+    for (i = 0; i < 8; i++)
+      hash[i] = (state[0] >> (56 - 8 * i)) & 0xff;
+    return;
+  }
+
+  for (i = 0; i < width / 32; i++) {
+    hash[4 * i + 0] = (state[i] >> 24) & 0xff;
+    hash[4 * i + 1] = (state[i] >> 16) & 0xff;
+    hash[4 * i + 2] = (state[i] >> 8) & 0xff;
+    hash[4 * i + 3] = (state[i] >> 0) & 0xff;
+  }
+}
+
+/* Writes the hash value from the internal representation
+ * to @hash as 32 bit integers in host byte order, highest
+ * word first */
+static void
+fnv_final_words (const uint64_t * state, unsigned int width, uint32_t * hash)
+{
+  unsigned int i;
+
+  for (i = 0; i < width / 32; i++)
+    hash[i] = state[i];
+}
+
+/* Hashes all @n buffers of @iov one after another */
+static inline void
+fnv_update_iov (void (*update) (uint64_t * state, const uint8_t * data,
+        size_t len), uint64_t * state, const struct iovec *iov, int n)
+{
+  int i;
+
+  assert (n >= 0);
+  assert (iov != NULL || n == 0);
+
+  for (i = 0; i < n; i++)
+    update (state, iov[i].iov_base, iov[i].iov_len);
+}
+
+/* Seeded hashing: The 128 bit secret is mixed into the lowest bits of
+ * the offset basis, so that colliding inputs can't be calculated without
+ * knowing it. The result is passed through the MurmurHash3 finalizer
+ * together with the secret, so that the internal state isn't exposed
+ * directly by the hash values. */
+static inline uint32_t
+fnv_fmix32 (uint32_t h)
+{
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+
+  return h;
+}
+
+static inline uint64_t
+fnv_fmix64 (uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return h;
+}
+
+/* Mixes @seed into the initialized @state */
+static inline void
+fnv_seed (uint64_t * state, unsigned int width, const uint64_t seed[2])
+{
+  unsigned int n = width / 32;
+
+  if (width == 32) {
+    state[0] ^= (uint32_t) (seed[0] ^ (seed[0] >> 32));
+  } else if (width == 64) {
+    state[0] ^= seed[0];
+  } else {
+    state[n - 1] ^= seed[0] & 0xffffffff;
+    state[n - 2] ^= seed[0] >> 32;
+    state[n - 3] ^= seed[1] & 0xffffffff;
+    state[n - 4] ^= seed[1] >> 32;
+  }
+}
+
+/* Puts the finalized hash value of @state into @out, both in the
+ * internal representation. @out can be the same as @state */
+static inline void
+fnv_seed_final (const uint64_t * state, unsigned int width,
+    const uint64_t seed[2], uint64_t * out)
+{
+  unsigned int i, n = width / 32;
+  uint64_t w;
+
+  if (width == 32) {
+    out[0] = fnv_fmix32 (state[0] ^ (uint32_t) (seed[1] ^ (seed[1] >> 32)));
+  } else if (width == 64) {
+    out[0] = fnv_fmix64 (state[0] ^ seed[1]);
+  } else {
+    for (i = 0; i < n / 2; i++) {
+      w = (state[n - 2 - 2 * i] << 32) | state[n - 1 - 2 * i];
+      w = fnv_fmix64 (w ^ seed[i & 1]);
+      out[n - 2 - 2 * i] = w >> 32;
+      out[n - 1 - 2 * i] = w & 0xffffffff;
+    }
+  }
+}
+
+#ifdef HAVE_UNSIGNED___INT128
+/* All FNV primes above 64 bit are of the form P = 2^shift + c with a
+ * small constant c, so the multiplication by the prime is a multiplication
+ * of every 64 bit limb by c plus the number shifted left by shift bits.
+ * Using 128 bit intermediate products the carries can be chained without
+ * any masking.
+ *
+ * As 2 * shift >= width for all of them, this goes even further:
+ * P^m = c^m + m * c^(m-1) * 2^shift (mod 2^width). XOR-ing a byte into
+ * the hash is the same as adding a small signed difference e that only
+ * depends on the lowest byte of the hash, and the lowest 64 bits of the
+ * hash can be calculated on their own with a single multiplication per
+ * byte. For blocks of 6 bytes this gives
+ *
+ *   h' = h * P^6 + sum (e_i * P^j_i)
+ *      = h * c^6 + E + ((h * 6 * c^5 + F) << shift)
+ *
+ * with E = sum (e_i * c^j_i) and F = sum (e_i * j_i * c^(j_i-1)), which
+ * both fit into a signed 64 bit integer for 6 bytes. So instead of one
+ * multiplication per limb and byte there is only one per limb every
+ * 6 bytes, plus one per byte for the lowest 64 bits.
+ *
+ * The state is converted from/to the 32 bit fields that are used by
+ * the generic implementation below, so both can be mixed freely. */
+#define FNV_INT128_BLOCK 6
+
+/* Must be inlined for the loops over the limbs to be unrolled */
+static inline __attribute__ ((always_inline)) void
+fnv_update_int128 (uint64_t * state, const uint8_t * data, size_t len,
+    int fnv1a, const unsigned int n_limbs, const unsigned int shift,
+    const uint64_t c)
+{
+  const unsigned int limb_shift = shift / 64;
+  const unsigned int bit_shift = shift % 64;
+  /* j * c^(j-1) for j = 6..0, the weights of the e_i for F */
+  const uint64_t w[FNV_INT128_BLOCK + 1] = {
+    6 * c * c * c * c * c, 5 * c * c * c * c, 4 * c * c * c, 3 * c * c,
+    2 * c, 1, 0
+  };
+  const uint64_t c6 = c * c * c * c * c * c;
+  uint64_t x[16], r[16];
+  uint64_t lo, e, E, F, sE, sF, y, y_prev;
+  unsigned __int128 acc, acc2;
+  unsigned int i, j;
+
+  /* 64 bit limbs, lowest 64 bit first */
+  for (j = 0; j < n_limbs; j++)
+    x[j] = state[2 * (n_limbs - j) - 1] | (state[2 * (n_limbs - j) - 2] << 32);
+
+  /* Only worth it if there are enough limbs */
+  while (n_limbs >= 4 && len >= FNV_INT128_BLOCK) {
+    lo = x[0];
+    F = 0;
+    /* All of this is modulo 2^64, which gives the correct two's
+     * complement representation as the real values fit */
+    for (i = 0; i < FNV_INT128_BLOCK; i++) {
+      if (fnv1a) {
+        e = ((lo & 0xff) ^ data[i]) - (lo & 0xff);
+        lo = (lo ^ data[i]) * c;
+        F += e * w[i];
+      } else {
+        lo = lo * c;
+        e = ((lo & 0xff) ^ data[i]) - (lo & 0xff);
+        lo = lo ^ data[i];
+        F += e * w[i + 1];
+      }
+    }
+    E = lo - x[0] * c6;
+    sE = (E >> 63) ? ~(uint64_t) 0 : 0;
+    sF = (F >> 63) ? ~(uint64_t) 0 : 0;
+
+    /* r = x * c^6 + E + ((x * 6 * c^5 + F) << shift) */
+    acc = (unsigned __int128) x[0] * c6 + E;
+    acc2 = 0;
+    y_prev = 0;
+#pragma GCC unroll 16
+    for (j = 0; j < n_limbs; j++) {
+      if (j > 0)
+        acc += (unsigned __int128) x[j] * c6 + sE;
+      if (j >= limb_shift) {
+        acc2 += (unsigned __int128) x[j - limb_shift] * w[0];
+        acc2 += (j == limb_shift) ? F : sF;
+        y = (uint64_t) acc2;
+        acc2 >>= 64;
+        acc += (y << bit_shift) | (y_prev >> (64 - bit_shift));
+        y_prev = y;
+      }
+      r[j] = (uint64_t) acc;
+      acc >>= 64;
+    }
+#pragma GCC unroll 16
+    for (j = 0; j < n_limbs; j++)
+      x[j] = r[j];
+
+    data += FNV_INT128_BLOCK;
+    len -= FNV_INT128_BLOCK;
+  }
+
+  /* And the remaining bytes one by one, bit_shift is never 0 here */
+  while (len > 0) {
+    if (fnv1a)
+      x[0] ^= *data;
+
+    acc = 0;
+#pragma GCC unroll 16
+    for (j = 0; j < n_limbs; j++) {
+      acc += (unsigned __int128) x[j] * c;
+      if (j == limb_shift)
+        acc += x[0] << bit_shift;
+      else if (j > limb_shift)
+        acc += (x[j - limb_shift] << bit_shift) |
+            (x[j - limb_shift - 1] >> (64 - bit_shift));
+      r[j] = (uint64_t) acc;
+      acc >>= 64;
+    }
+#pragma GCC unroll 16
+    for (j = 0; j < n_limbs; j++)
+      x[j] = r[j];
+
+    if (!fnv1a)
+      x[0] ^= *data;
+
+    data++;
+    len--;
+  }
+
+  for (j = 0; j < n_limbs; j++) {
+    state[2 * (n_limbs - j) - 1] = x[j] & 0xffffffff;
+    state[2 * (n_limbs - j) - 2] = x[j] >> 32;
+  }
+}
+#endif
+
 static const uint32_t FNV_prime_32 = 16777619U;
 static const uint32_t FNV_offset_32 = 2166136261U;
 
-void
-snippets_fnv1_32 (const uint8_t * data, size_t len, uint8_t hash[4])
+static void
+fnv1_32_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
-  uint32_t tmp = FNV_offset_32;
+  uint32_t tmp = *state;
 
   for (i = 0; i < len; i++) {
     tmp = tmp * FNV_prime_32;   /* Multiplication mod 2^32 as per C standard */
@@ -45,17 +319,14 @@ snippets_fnv1_32 (const uint8_t * data, size_t len, uint8_t hash[4])
     data++;
   }
 
-  hash[0] = (tmp >> 24) & 0xff;
-  hash[1] = (tmp >> 16) & 0xff;
-  hash[2] = (tmp >> 8) & 0xff;
-  hash[3] = (tmp >> 0) & 0xff;
+  *state = tmp;
 }
 
-void
-snippets_fnv1a_32 (const uint8_t * data, size_t len, uint8_t hash[4])
+static void
+fnv1a_32_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
-  uint32_t tmp = FNV_offset_32;
+  uint32_t tmp = *state;
 
   for (i = 0; i < len; i++) {
     tmp = tmp ^ *data;
@@ -63,20 +334,90 @@ snippets_fnv1a_32 (const uint8_t * data, size_t len, uint8_t hash[4])
     data++;
   }
 
-  hash[0] = (tmp >> 24) & 0xff;
-  hash[1] = (tmp >> 16) & 0xff;
-  hash[2] = (tmp >> 8) & 0xff;
-  hash[3] = (tmp >> 0) & 0xff;
+  *state = tmp;
+}
+
+void
+snippets_fnv1_32 (const uint8_t * data, size_t len, uint8_t hash[4])
+{
+  uint64_t tmp = FNV_offset_32;
+
+  fnv1_32_update (&tmp, data, len);
+  fnv_final (&tmp, 32, hash);
+}
+
+uint32_t
+snippets_fnv1_32_uint32 (const uint8_t * data, size_t len)
+{
+  uint64_t tmp = FNV_offset_32;
+
+  fnv1_32_update (&tmp, data, len);
+
+  return tmp;
+}
+
+uint32_t
+snippets_fnv1_32_iov (const struct iovec *iov, int n)
+{
+  uint64_t tmp = FNV_offset_32;
+
+  fnv_update_iov (fnv1_32_update, &tmp, iov, n);
+
+  return tmp;
+}
+
+void
+snippets_fnv1a_32 (const uint8_t * data, size_t len, uint8_t hash[4])
+{
+  uint64_t tmp = FNV_offset_32;
+
+  fnv1a_32_update (&tmp, data, len);
+  fnv_final (&tmp, 32, hash);
+}
+
+uint32_t
+snippets_fnv1a_32_uint32 (const uint8_t * data, size_t len)
+{
+  uint64_t tmp = FNV_offset_32;
+
+  fnv1a_32_update (&tmp, data, len);
+
+  return tmp;
+}
+
+uint32_t
+snippets_fnv1a_32_iov (const struct iovec *iov, int n)
+{
+  uint64_t tmp = FNV_offset_32;
+
+  fnv_update_iov (fnv1a_32_update, &tmp, iov, n);
+
+  return tmp;
+}
+
+uint32_t
+snippets_fnv1a_32_seeded (const uint8_t * data, size_t len,
+    const uint64_t seed[2])
+{
+  uint64_t tmp = FNV_offset_32;
+
+  assert (seed != NULL);
+
+  fnv_seed (&tmp, 32, seed);
+  fnv1a_32_update (&tmp, data, len);
+  fnv_seed_final (&tmp, 32, seed, &tmp);
+
+  return tmp;
 }
 
 static const uint64_t FNV_prime_64 = 1099511628211ULL;
 static const uint64_t FNV_offset_64 = 14695981039346656037ULL;
 
-void
-snippets_fnv1_64 (const uint8_t * data, size_t len, uint8_t hash[8])
+static void
+fnv1_64_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
-  uint64_t tmp = FNV_offset_64;
+  uint64_t tmp = *state;
 
   for (i = 0; i < len; i++) {
     tmp = tmp * FNV_prime_64;   /* Multiplication mod 2^64 as per C standard */
@@ -84,21 +425,14 @@ snippets_fnv1_64 (const uint8_t * data, size_t len, uint8_t hash[8])
     data++;
   }
 
-  hash[0] = (tmp >> 56) & 0xff;
-  hash[1] = (tmp >> 48) & 0xff;
-  hash[2] = (tmp >> 40) & 0xff;
-  hash[3] = (tmp >> 32) & 0xff;
-  hash[4] = (tmp >> 24) & 0xff;
-  hash[5] = (tmp >> 16) & 0xff;
-  hash[6] = (tmp >> 8) & 0xff;
-  hash[7] = (tmp >> 0) & 0xff;
+  *state = tmp;
 }
 
-void
-snippets_fnv1a_64 (const uint8_t * data, size_t len, uint8_t hash[8])
+static void
+fnv1a_64_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
-  uint64_t tmp = FNV_offset_64;
+  uint64_t tmp = *state;
 
   for (i = 0; i < len; i++) {
     tmp = tmp ^ *data;
@@ -106,30 +440,542 @@ snippets_fnv1a_64 (const uint8_t * data, size_t len, uint8_t hash[8])
     data++;
   }
 
-  hash[0] = (tmp >> 56) & 0xff;
-  hash[1] = (tmp >> 48) & 0xff;
-  hash[2] = (tmp >> 40) & 0xff;
-  hash[3] = (tmp >> 32) & 0xff;
-  hash[4] = (tmp >> 24) & 0xff;
-  hash[5] = (tmp >> 16) & 0xff;
-  hash[6] = (tmp >> 8) & 0xff;
-  hash[7] = (tmp >> 0) & 0xff;
+  *state = tmp;
+}
+
+void
+snippets_fnv1_64 (const uint8_t * data, size_t len, uint8_t hash[8])
+{
+  uint64_t tmp = FNV_offset_64;
+
+  fnv1_64_update (&tmp, data, len);
+  fnv_final (&tmp, 64, hash);
+}
+
+uint64_t
+snippets_fnv1_64_uint64 (const uint8_t * data, size_t len)
+{
+  uint64_t tmp = FNV_offset_64;
+
+  fnv1_64_update (&tmp, data, len);
+
+  return tmp;
+}
+
+uint64_t
+snippets_fnv1_64_iov (const struct iovec *iov, int n)
+{
+  uint64_t tmp = FNV_offset_64;
+
+  fnv_update_iov (fnv1_64_update, &tmp, iov, n);
+
+  return tmp;
+}
+
+void
+snippets_fnv1a_64 (const uint8_t * data, size_t len, uint8_t hash[8])
+{
+  uint64_t tmp = FNV_offset_64;
+
+  fnv1a_64_update (&tmp, data, len);
+  fnv_final (&tmp, 64, hash);
+}
+
+uint64_t
+snippets_fnv1a_64_uint64 (const uint8_t * data, size_t len)
+{
+  uint64_t tmp = FNV_offset_64;
+
+  fnv1a_64_update (&tmp, data, len);
+
+  return tmp;
+}
+
+uint64_t
+snippets_fnv1a_64_iov (const struct iovec *iov, int n)
+{
+  uint64_t tmp = FNV_offset_64;
+
+  fnv_update_iov (fnv1a_64_update, &tmp, iov, n);
+
+  return tmp;
+}
+
+uint64_t
+snippets_fnv1a_64_seeded (const uint8_t * data, size_t len,
+    const uint64_t seed[2])
+{
+  uint64_t tmp = FNV_offset_64;
+
+  assert (seed != NULL);
+
+  fnv_seed (&tmp, 64, seed);
+  fnv1a_64_update (&tmp, data, len);
+  fnv_seed_final (&tmp, 64, seed, &tmp);
+
+  return tmp;
+}
+
+/* Batch hashing of many independent keys
+ *
+ * FNV is inherently serial for a single key, but separate keys are
+ * independent and can be hashed at once in the lanes of SIMD registers,
+ * or at least interleaved to hide the latency of the multiplications.
+ * All keys of a group are processed in parallel up to the length of the
+ * shortest key, the remaining bytes are then hashed interleaved in
+ * smaller groups of 4 keys and finally one by one with the normal
+ * implementation.
+ *
+ * The SIMD implementation is selected at runtime, see cpu.h.
+ */
+
+static size_t
+fnv_batch_min_len (const size_t * lens, unsigned int n)
+{
+  size_t min_len = lens[0];
+  unsigned int i;
+
+  for (i = 1; i < n; i++) {
+    if (lens[i] < min_len)
+      min_len = lens[i];
+  }
+
+  return min_len;
+}
+
+/* Finishes the hashes of @n keys, with the hashes of the first @offset
+ * bytes of each key in @h. Groups of 4 keys are interleaved up to the
+ * length of the shortest of them, the remaining bytes of each key are
+ * hashed one by one. */
+static void
+fnv1a_32_batch_finish (const uint8_t ** keys, const size_t * lens,
+    unsigned int n, size_t offset, uint32_t * h)
+{
+  size_t i, min_len;
+  uint32_t h0, h1, h2, h3;
+  uint64_t tmp;
+  unsigned int g, l;
+
+  for (g = 0; g + 4 <= n; g += 4) {
+    min_len = fnv_batch_min_len (lens + g, 4);
+
+    h0 = h[g];
+    h1 = h[g + 1];
+    h2 = h[g + 2];
+    h3 = h[g + 3];
+    for (i = offset; i < min_len; i++) {
+      h0 = (h0 ^ keys[g][i]) * FNV_prime_32;
+      h1 = (h1 ^ keys[g + 1][i]) * FNV_prime_32;
+      h2 = (h2 ^ keys[g + 2][i]) * FNV_prime_32;
+      h3 = (h3 ^ keys[g + 3][i]) * FNV_prime_32;
+    }
+    h[g] = h0;
+    h[g + 1] = h1;
+    h[g + 2] = h2;
+    h[g + 3] = h3;
+
+    for (l = g; l < g + 4; l++) {
+      tmp = h[l];
+      fnv1a_32_update (&tmp, keys[l] + min_len, lens[l] - min_len);
+      h[l] = tmp;
+    }
+  }
+
+  for (l = g; l < n; l++) {
+    tmp = h[l];
+    fnv1a_32_update (&tmp, keys[l] + offset, lens[l] - offset);
+    h[l] = tmp;
+  }
+}
+
+static void
+fnv1a_64_batch_finish (const uint8_t ** keys, const size_t * lens,
+    unsigned int n, size_t offset, uint64_t * h)
+{
+  size_t i, min_len;
+  uint64_t h0, h1, h2, h3;
+  unsigned int g, l;
+
+  for (g = 0; g + 4 <= n; g += 4) {
+    min_len = fnv_batch_min_len (lens + g, 4);
+
+    h0 = h[g];
+    h1 = h[g + 1];
+    h2 = h[g + 2];
+    h3 = h[g + 3];
+    for (i = offset; i < min_len; i++) {
+      h0 = (h0 ^ keys[g][i]) * FNV_prime_64;
+      h1 = (h1 ^ keys[g + 1][i]) * FNV_prime_64;
+      h2 = (h2 ^ keys[g + 2][i]) * FNV_prime_64;
+      h3 = (h3 ^ keys[g + 3][i]) * FNV_prime_64;
+    }
+    h[g] = h0;
+    h[g + 1] = h1;
+    h[g + 2] = h2;
+    h[g + 3] = h3;
+
+    for (l = g; l < g + 4; l++)
+      fnv1a_64_update (&h[l], keys[l] + min_len, lens[l] - min_len);
+  }
+
+  for (l = g; l < n; l++)
+    fnv1a_64_update (&h[l], keys[l] + offset, lens[l] - offset);
+}
+
+static void
+fnv1a_32_batch4_scalar (const uint8_t ** keys, const size_t * lens,
+    uint32_t * out)
+{
+  out[0] = out[1] = out[2] = out[3] = FNV_offset_32;
+  fnv1a_32_batch_finish (keys, lens, 4, 0, out);
+}
+
+static void
+fnv1a_64_batch4_scalar (const uint8_t ** keys, const size_t * lens,
+    uint64_t * out)
+{
+  out[0] = out[1] = out[2] = out[3] = FNV_offset_64;
+  fnv1a_64_batch_finish (keys, lens, 4, 0, out);
+}
+
+#ifdef HAVE_X86_SIMD_DISPATCH
+/* The SIMD implementations keep four registers of keys in flight to
+ * hide the latency of the multiplications */
+
+/* 8 keys. The 32 bit hashes are calculated in 64 bit lanes, the lower
+ * 32 bits of the 32x32 bit multiplication are all that is needed and
+ * it is faster than a 32 bit multiplication. This also allows loading
+ * 8 bytes of every key at once */
+static SNIPPETS_TARGET_SSE42 void
+fnv1a_32_batch8_sse42 (const uint8_t ** keys, const size_t * lens,
+    uint32_t * out)
+{
+  size_t i, min_len = fnv_batch_min_len (lens, 8) & ~(size_t) 7;
+  const __m128i mask = _mm_set1_epi64x (0xff);
+  const __m128i prime = _mm_set1_epi64x (FNV_prime_32);
+  __m128i h[4], d[4];
+  uint64_t w[8];
+  unsigned int j, l, r;
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    h[r] = _mm_set1_epi64x (FNV_offset_32);
+  for (i = 0; i < min_len; i += 8) {
+    for (l = 0; l < 8; l++)
+      memcpy (&w[l], keys[l] + i, 8);
+#pragma GCC unroll 4
+    for (r = 0; r < 4; r++)
+      d[r] = _mm_loadu_si128 ((const __m128i *) & w[2 * r]);
+
+    /* Little endian, so the lowest byte comes first */
+#pragma GCC unroll 8
+    for (j = 0; j < 8; j++) {
+#pragma GCC unroll 4
+      for (r = 0; r < 4; r++) {
+        h[r] = _mm_mul_epu32 (_mm_xor_si128 (h[r],
+                _mm_and_si128 (d[r], mask)), prime);
+        d[r] = _mm_srli_epi64 (d[r], 8);
+      }
+    }
+  }
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    _mm_storeu_si128 ((__m128i *) & w[2 * r], h[r]);
+  for (l = 0; l < 8; l++)
+    out[l] = w[l];
+  fnv1a_32_batch_finish (keys, lens, 8, min_len, out);
+}
+
+/* x * (2^40 + 0x1b3) with 32x32 bit multiplications */
+static inline SNIPPETS_TARGET_AVX2 __m256i
+fnv_mul_64_avx2 (__m256i x)
+{
+  const __m256i c = _mm256_set1_epi32 (0x1b3);
+  __m256i lo, hi;
+
+  lo = _mm256_mul_epu32 (x, c);
+  hi = _mm256_mul_epu32 (_mm256_srli_epi64 (x, 32), c);
+
+  return _mm256_add_epi64 (_mm256_add_epi64 (lo, _mm256_slli_epi64 (hi, 32)),
+      _mm256_slli_epi64 (x, 40));
+}
+
+/* 16 keys, with 32 bit hashes in 64 bit lanes like for SSE4.2 */
+static SNIPPETS_TARGET_AVX2 void
+fnv1a_32_batch16_avx2 (const uint8_t ** keys, const size_t * lens,
+    uint32_t * out)
+{
+  size_t i, min_len = fnv_batch_min_len (lens, 16) & ~(size_t) 7;
+  const __m256i mask = _mm256_set1_epi64x (0xff);
+  const __m256i prime = _mm256_set1_epi64x (FNV_prime_32);
+  __m256i h[4], d[4];
+  uint64_t w[16];
+  unsigned int j, l, r;
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    h[r] = _mm256_set1_epi64x (FNV_offset_32);
+  for (i = 0; i < min_len; i += 8) {
+    for (l = 0; l < 16; l++)
+      memcpy (&w[l], keys[l] + i, 8);
+#pragma GCC unroll 4
+    for (r = 0; r < 4; r++)
+      d[r] = _mm256_loadu_si256 ((const __m256i *) & w[4 * r]);
+
+    /* Little endian, so the lowest byte comes first */
+#pragma GCC unroll 8
+    for (j = 0; j < 8; j++) {
+#pragma GCC unroll 4
+      for (r = 0; r < 4; r++) {
+        h[r] = _mm256_mul_epu32 (_mm256_xor_si256 (h[r],
+                _mm256_and_si256 (d[r], mask)), prime);
+        d[r] = _mm256_srli_epi64 (d[r], 8);
+      }
+    }
+  }
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    _mm256_storeu_si256 ((__m256i *) & w[4 * r], h[r]);
+  for (l = 0; l < 16; l++)
+    out[l] = w[l];
+  fnv1a_32_batch_finish (keys, lens, 16, min_len, out);
+}
+
+/* 16 keys */
+static SNIPPETS_TARGET_AVX2 void
+fnv1a_64_batch16_avx2 (const uint8_t ** keys, const size_t * lens,
+    uint64_t * out)
+{
+  size_t i, min_len = fnv_batch_min_len (lens, 16) & ~(size_t) 7;
+  const __m256i mask = _mm256_set1_epi64x (0xff);
+  __m256i h[4], d[4];
+  uint64_t w[16];
+  unsigned int j, l, r;
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    h[r] = _mm256_set1_epi64x (FNV_offset_64);
+  for (i = 0; i < min_len; i += 8) {
+    for (l = 0; l < 16; l++)
+      memcpy (&w[l], keys[l] + i, 8);
+#pragma GCC unroll 4
+    for (r = 0; r < 4; r++)
+      d[r] = _mm256_loadu_si256 ((const __m256i *) & w[4 * r]);
+
+    /* Little endian, so the lowest byte comes first */
+#pragma GCC unroll 8
+    for (j = 0; j < 8; j++) {
+#pragma GCC unroll 4
+      for (r = 0; r < 4; r++) {
+        h[r] = fnv_mul_64_avx2 (_mm256_xor_si256 (h[r],
+                _mm256_and_si256 (d[r], mask)));
+        d[r] = _mm256_srli_epi64 (d[r], 8);
+      }
+    }
+  }
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    _mm256_storeu_si256 ((__m256i *) & out[4 * r], h[r]);
+  fnv1a_64_batch_finish (keys, lens, 16, min_len, out);
+}
+
+/* 32 keys, with 32 bit hashes in 64 bit lanes like for SSE4.2. The
+ * zero-masked operations are used because the unmasked ones trigger bogus
+ * uninitialized warnings with gcc 12 */
+static SNIPPETS_TARGET_AVX512 void
+fnv1a_32_batch32_avx512 (const uint8_t ** keys, const size_t * lens,
+    uint32_t * out)
+{
+  size_t i, min_len = fnv_batch_min_len (lens, 32) & ~(size_t) 7;
+  const __m512i mask = _mm512_set1_epi64 (0xff);
+  const __m512i prime = _mm512_set1_epi64 (FNV_prime_32);
+  __m512i h[4], d[4];
+  uint64_t w[32];
+  unsigned int j, l, r;
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    h[r] = _mm512_set1_epi64 (FNV_offset_32);
+  for (i = 0; i < min_len; i += 8) {
+    for (l = 0; l < 32; l++)
+      memcpy (&w[l], keys[l] + i, 8);
+#pragma GCC unroll 4
+    for (r = 0; r < 4; r++)
+      d[r] = _mm512_loadu_si512 (&w[8 * r]);
+
+    /* Little endian, so the lowest byte comes first */
+#pragma GCC unroll 8
+    for (j = 0; j < 8; j++) {
+#pragma GCC unroll 4
+      for (r = 0; r < 4; r++) {
+        h[r] = _mm512_maskz_mul_epu32 (0xff, _mm512_xor_si512 (h[r],
+                _mm512_and_si512 (d[r], mask)), prime);
+        d[r] = _mm512_maskz_srli_epi64 (0xff, d[r], 8);
+      }
+    }
+  }
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    _mm512_storeu_si512 (&w[8 * r], h[r]);
+  for (l = 0; l < 32; l++)
+    out[l] = w[l];
+  fnv1a_32_batch_finish (keys, lens, 32, min_len, out);
+}
+
+/* 32 keys, with a native 64 bit multiplication */
+static SNIPPETS_TARGET_AVX512 void
+fnv1a_64_batch32_avx512 (const uint8_t ** keys, const size_t * lens,
+    uint64_t * out)
+{
+  size_t i, min_len = fnv_batch_min_len (lens, 32) & ~(size_t) 7;
+  const __m512i mask = _mm512_set1_epi64 (0xff);
+  const __m512i prime = _mm512_set1_epi64 (FNV_prime_64);
+  __m512i h[4], d[4];
+  uint64_t w[32];
+  unsigned int j, l, r;
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    h[r] = _mm512_set1_epi64 (FNV_offset_64);
+  for (i = 0; i < min_len; i += 8) {
+    for (l = 0; l < 32; l++)
+      memcpy (&w[l], keys[l] + i, 8);
+#pragma GCC unroll 4
+    for (r = 0; r < 4; r++)
+      d[r] = _mm512_loadu_si512 (&w[8 * r]);
+
+    /* Little endian, so the lowest byte comes first */
+#pragma GCC unroll 8
+    for (j = 0; j < 8; j++) {
+#pragma GCC unroll 4
+      for (r = 0; r < 4; r++) {
+        h[r] = _mm512_mullo_epi64 (_mm512_xor_si512 (h[r],
+                _mm512_and_si512 (d[r], mask)), prime);
+        d[r] = _mm512_maskz_srli_epi64 (0xff, d[r], 8);
+      }
+    }
+  }
+
+#pragma GCC unroll 4
+  for (r = 0; r < 4; r++)
+    _mm512_storeu_si512 (&out[8 * r], h[r]);
+  fnv1a_64_batch_finish (keys, lens, 32, min_len, out);
+}
+#endif
+
+/* Implementations for the different SIMD levels, indexed by
+ * SnippetsCpuLevel and selected on first use. With SSE4.2 the emulated
+ * 64 bit multiplication is slower than the scalar one */
+typedef struct
+{
+  unsigned int n_32;
+  void (*batch_32) (const uint8_t ** keys, const size_t * lens,
+      uint32_t * out);
+  unsigned int n_64;
+  void (*batch_64) (const uint8_t ** keys, const size_t * lens,
+      uint64_t * out);
+} FnvBatchImpl;
+
+static const FnvBatchImpl fnv_batch_impls[] = {
+  {4, fnv1a_32_batch4_scalar, 4, fnv1a_64_batch4_scalar},
+#ifdef HAVE_X86_SIMD_DISPATCH
+  {8, fnv1a_32_batch8_sse42, 4, fnv1a_64_batch4_scalar},
+  {16, fnv1a_32_batch16_avx2, 16, fnv1a_64_batch16_avx2},
+  {32, fnv1a_32_batch32_avx512, 32, fnv1a_64_batch32_avx512},
+#endif
+};
+
+static const FnvBatchImpl *
+fnv_batch_impl (void)
+{
+  static const FnvBatchImpl *impl = NULL;
+  unsigned int level;
+
+  if (!impl) {
+    level = _snippets_cpu_level ();
+    if (level >= sizeof (fnv_batch_impls) / sizeof (fnv_batch_impls[0]))
+      level = 0;
+    impl = &fnv_batch_impls[level];
+  }
+
+  return impl;
+}
+
+void
+snippets_fnv1a_32_batch (const uint8_t ** keys, const size_t * lens, size_t n,
+    uint32_t * out)
+{
+  const FnvBatchImpl *impl = fnv_batch_impl ();
+  uint64_t tmp;
+  size_t i = 0;
+
+  assert (n == 0 || (keys != NULL && lens != NULL && out != NULL));
+
+  for (; i + impl->n_32 <= n; i += impl->n_32)
+    impl->batch_32 (keys + i, lens + i, out + i);
+  for (; i + 4 <= n; i += 4)
+    fnv1a_32_batch4_scalar (keys + i, lens + i, out + i);
+  for (; i < n; i++) {
+    tmp = FNV_offset_32;
+    fnv1a_32_update (&tmp, keys[i], lens[i]);
+    out[i] = tmp;
+  }
+}
+
+void
+snippets_fnv1a_64_batch (const uint8_t ** keys, const size_t * lens, size_t n,
+    uint64_t * out)
+{
+  const FnvBatchImpl *impl = fnv_batch_impl ();
+  uint64_t tmp;
+  size_t i = 0;
+
+  assert (n == 0 || (keys != NULL && lens != NULL && out != NULL));
+
+  for (; i + impl->n_64 <= n; i += impl->n_64)
+    impl->batch_64 (keys + i, lens + i, out + i);
+  for (; i + 4 <= n; i += 4)
+    fnv1a_64_batch4_scalar (keys + i, lens + i, out + i);
+  for (; i < n; i++) {
+    tmp = FNV_offset_64;
+    fnv1a_64_update (&tmp, keys[i], lens[i]);
+    out[i] = tmp;
+  }
 }
 
 /* 128 bit prime  =             309485009821345068724781371 = 0x0000000001000000000000000000013b
  * 128 bit offset = 144066263297769815596495629667062367629 = 0x6c62272e07bb014262b821756295c58d
  */
-void
-snippets_fnv1_128 (const uint8_t * data, size_t len, uint8_t hash[16])
+
+/* 128 bit offset, 32 bit per field, highest 32 bit first */
+static const uint64_t FNV_offset_128[4] = {
+  0x6c62272e, 0x07bb0142, 0x62b82175, 0x6295c58d
+};
+
+#ifdef HAVE_UNSIGNED___INT128
+static void
+fnv1_128_update (uint64_t * state, const uint8_t * data, size_t len)
+{
+  fnv_update_int128 (state, data, len, FALSE, 2, 88, 0x13b);
+}
+
+static void
+fnv1a_128_update (uint64_t * state, const uint8_t * data, size_t len)
+{
+  fnv_update_int128 (state, data, len, TRUE, 2, 88, 0x13b);
+}
+#else
+static void
+fnv1_128_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
   uint64_t tmp[4], tmp2[4];
 
-  /* 128 bit number, 32 bit per field, highest 32 bit first */
-  tmp[0] = 0x6c62272e;
-  tmp[1] = 0x07bb0142;
-  tmp[2] = 0x62b82175;
-  tmp[3] = 0x6295c58d;
+  memcpy (tmp, state, sizeof (tmp));
 
   for (i = 0; i < len; i++) {
     /* Multiplication */
@@ -164,43 +1010,26 @@ snippets_fnv1_128 (const uint8_t * data, size_t len, uint8_t hash[16])
     data++;
   }
 
-  hash[0] = (tmp[0] >> 24) & 0xff;
-  hash[1] = (tmp[0] >> 16) & 0xff;
-  hash[2] = (tmp[0] >> 8) & 0xff;
-  hash[3] = (tmp[0] >> 0) & 0xff;
-  hash[4] = (tmp[1] >> 24) & 0xff;
-  hash[5] = (tmp[1] >> 16) & 0xff;
-  hash[6] = (tmp[1] >> 8) & 0xff;
-  hash[7] = (tmp[1] >> 0) & 0xff;
-  hash[8] = (tmp[2] >> 24) & 0xff;
-  hash[9] = (tmp[2] >> 16) & 0xff;
-  hash[10] = (tmp[2] >> 8) & 0xff;
-  hash[11] = (tmp[2] >> 0) & 0xff;
-  hash[12] = (tmp[3] >> 24) & 0xff;
-  hash[13] = (tmp[3] >> 16) & 0xff;
-  hash[14] = (tmp[3] >> 8) & 0xff;
-  hash[15] = (tmp[3] >> 0) & 0xff;
+  memcpy (state, tmp, sizeof (tmp));
 }
 
-void
-snippets_fnv1a_128 (const uint8_t * data, size_t len, uint8_t hash[16])
+static void
+fnv1a_128_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
   uint64_t tmp[4], tmp2[4];
 
-  /* 128 bit number, 32 bit per field, highest 32 bit first */
-  tmp[0] = 0x6c62272e;
-  tmp[1] = 0x07bb0142;
-  tmp[2] = 0x62b82175;
-  tmp[3] = 0x6295c58d;
+  memcpy (tmp, state, sizeof (tmp));
 
   for (i = 0; i < len; i++) {
+    tmp[3] ^= *data;
+
     /* Multiplication */
 
     /* lowest 32 bits */
 
     /* multiply and keep carries forward */
-    tmp2[3] = (*data ^ tmp[3]) * 0x0000013b;
+    tmp2[3] = tmp[3] * 0x0000013b;
     tmp2[2] = tmp[2] * 0x0000013b + (tmp2[3] >> 32);
     tmp2[1] = tmp[1] * 0x0000013b + (tmp2[2] >> 32);
     tmp2[0] = tmp[0] * 0x0000013b + (tmp2[1] >> 32);
@@ -224,25 +1053,71 @@ snippets_fnv1a_128 (const uint8_t * data, size_t len, uint8_t hash[16])
     tmp[1] = tmp2[1];
     tmp[0] = tmp2[0];
 
-    data++;
-  }
+    data++;
+  }
+
+  memcpy (state, tmp, sizeof (tmp));
+}
+#endif
+
+void
+snippets_fnv1_128 (const uint8_t * data, size_t len, uint8_t hash[16])
+{
+  uint64_t tmp[4];
+
+  memcpy (tmp, FNV_offset_128, sizeof (tmp));
+  fnv1_128_update (tmp, data, len);
+  fnv_final (tmp, 128, hash);
+}
+
+void
+snippets_fnv1_128_words (const uint8_t * data, size_t len, uint32_t hash[4])
+{
+  uint64_t tmp[4];
+
+  memcpy (tmp, FNV_offset_128, sizeof (tmp));
+  fnv1_128_update (tmp, data, len);
+  fnv_final_words (tmp, 128, hash);
+}
+
+void
+snippets_fnv1_128_iov (const struct iovec *iov, int n, uint8_t hash[16])
+{
+  uint64_t tmp[4];
+
+  memcpy (tmp, FNV_offset_128, sizeof (tmp));
+  fnv_update_iov (fnv1_128_update, tmp, iov, n);
+  fnv_final (tmp, 128, hash);
+}
+
+void
+snippets_fnv1a_128 (const uint8_t * data, size_t len, uint8_t hash[16])
+{
+  uint64_t tmp[4];
+
+  memcpy (tmp, FNV_offset_128, sizeof (tmp));
+  fnv1a_128_update (tmp, data, len);
+  fnv_final (tmp, 128, hash);
+}
+
+void
+snippets_fnv1a_128_words (const uint8_t * data, size_t len, uint32_t hash[4])
+{
+  uint64_t tmp[4];
+
+  memcpy (tmp, FNV_offset_128, sizeof (tmp));
+  fnv1a_128_update (tmp, data, len);
+  fnv_final_words (tmp, 128, hash);
+}
 
-  hash[0] = (tmp[0] >> 24) & 0xff;
-  hash[1] = (tmp[0] >> 16) & 0xff;
-  hash[2] = (tmp[0] >> 8) & 0xff;
-  hash[3] = (tmp[0] >> 0) & 0xff;
-  hash[4] = (tmp[1] >> 24) & 0xff;
-  hash[5] = (tmp[1] >> 16) & 0xff;
-  hash[6] = (tmp[1] >> 8) & 0xff;
-  hash[7] = (tmp[1] >> 0) & 0xff;
-  hash[8] = (tmp[2] >> 24) & 0xff;
-  hash[9] = (tmp[2] >> 16) & 0xff;
-  hash[10] = (tmp[2] >> 8) & 0xff;
-  hash[11] = (tmp[2] >> 0) & 0xff;
-  hash[12] = (tmp[3] >> 24) & 0xff;
-  hash[13] = (tmp[3] >> 16) & 0xff;
-  hash[14] = (tmp[3] >> 8) & 0xff;
-  hash[15] = (tmp[3] >> 0) & 0xff;
+void
+snippets_fnv1a_128_iov (const struct iovec *iov, int n, uint8_t hash[16])
+{
+  uint64_t tmp[4];
+
+  memcpy (tmp, FNV_offset_128, sizeof (tmp));
+  fnv_update_iov (fnv1a_128_update, tmp, iov, n);
+  fnv_final (tmp, 128, hash);
 }
 
 /* 256 bit prime  =                             374144419156711147060143317175368453031918731002211
@@ -250,21 +1125,33 @@ snippets_fnv1a_128 (const uint8_t * data, size_t len, uint8_t hash[16])
  * 256 bit offset = 100029257958052580907070968620625704837092796014241193945225284501741471925557
  *                = 0xdd268dbcaac550362d98c384c4e576ccc8b1536847b6bbb31023b4c8caee0535
  */
-void
-snippets_fnv1_256 (const uint8_t * data, size_t len, uint8_t hash[32])
+
+/* 256 bit offset, 32 bit per field, highest 32 bit first */
+static const uint64_t FNV_offset_256[8] = {
+  0xdd268dbc, 0xaac55036, 0x2d98c384, 0xc4e576cc,
+  0xc8b15368, 0x47b6bbb3, 0x1023b4c8, 0xcaee0535
+};
+
+#ifdef HAVE_UNSIGNED___INT128
+static void
+fnv1_256_update (uint64_t * state, const uint8_t * data, size_t len)
+{
+  fnv_update_int128 (state, data, len, FALSE, 4, 168, 0x163);
+}
+
+static void
+fnv1a_256_update (uint64_t * state, const uint8_t * data, size_t len)
+{
+  fnv_update_int128 (state, data, len, TRUE, 4, 168, 0x163);
+}
+#else
+static void
+fnv1_256_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
   uint64_t tmp[8], tmp2[8];
 
-  /* 256 bit number, 32 bit per field, highest 32 bit first */
-  tmp[0] = 0xdd268dbc;
-  tmp[1] = 0xaac55036;
-  tmp[2] = 0x2d98c384;
-  tmp[3] = 0xc4e576cc;
-  tmp[4] = 0xc8b15368;
-  tmp[5] = 0x47b6bbb3;
-  tmp[6] = 0x1023b4c8;
-  tmp[7] = 0xcaee0535;
+  memcpy (tmp, state, sizeof (tmp));
 
   for (i = 0; i < len; i++) {
     /* Multiplication */
@@ -313,63 +1200,26 @@ snippets_fnv1_256 (const uint8_t * data, size_t len, uint8_t hash[32])
     data++;
   }
 
-  hash[0] = (tmp[0] >> 24) & 0xff;
-  hash[1] = (tmp[0] >> 16) & 0xff;
-  hash[2] = (tmp[0] >> 8) & 0xff;
-  hash[3] = (tmp[0] >> 0) & 0xff;
-  hash[4] = (tmp[1] >> 24) & 0xff;
-  hash[5] = (tmp[1] >> 16) & 0xff;
-  hash[6] = (tmp[1] >> 8) & 0xff;
-  hash[7] = (tmp[1] >> 0) & 0xff;
-  hash[8] = (tmp[2] >> 24) & 0xff;
-  hash[9] = (tmp[2] >> 16) & 0xff;
-  hash[10] = (tmp[2] >> 8) & 0xff;
-  hash[11] = (tmp[2] >> 0) & 0xff;
-  hash[12] = (tmp[3] >> 24) & 0xff;
-  hash[13] = (tmp[3] >> 16) & 0xff;
-  hash[14] = (tmp[3] >> 8) & 0xff;
-  hash[15] = (tmp[3] >> 0) & 0xff;
-  hash[16] = (tmp[4] >> 24) & 0xff;
-  hash[17] = (tmp[4] >> 16) & 0xff;
-  hash[18] = (tmp[4] >> 8) & 0xff;
-  hash[19] = (tmp[4] >> 0) & 0xff;
-  hash[20] = (tmp[5] >> 24) & 0xff;
-  hash[21] = (tmp[5] >> 16) & 0xff;
-  hash[22] = (tmp[5] >> 8) & 0xff;
-  hash[23] = (tmp[5] >> 0) & 0xff;
-  hash[24] = (tmp[6] >> 24) & 0xff;
-  hash[25] = (tmp[6] >> 16) & 0xff;
-  hash[26] = (tmp[6] >> 8) & 0xff;
-  hash[27] = (tmp[6] >> 0) & 0xff;
-  hash[28] = (tmp[7] >> 24) & 0xff;
-  hash[29] = (tmp[7] >> 16) & 0xff;
-  hash[30] = (tmp[7] >> 8) & 0xff;
-  hash[31] = (tmp[7] >> 0) & 0xff;
+  memcpy (state, tmp, sizeof (tmp));
 }
 
-void
-snippets_fnv1a_256 (const uint8_t * data, size_t len, uint8_t hash[32])
+static void
+fnv1a_256_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
   uint64_t tmp[8], tmp2[8];
 
-  /* 256 bit number, 32 bit per field, highest 32 bit first */
-  tmp[0] = 0xdd268dbc;
-  tmp[1] = 0xaac55036;
-  tmp[2] = 0x2d98c384;
-  tmp[3] = 0xc4e576cc;
-  tmp[4] = 0xc8b15368;
-  tmp[5] = 0x47b6bbb3;
-  tmp[6] = 0x1023b4c8;
-  tmp[7] = 0xcaee0535;
+  memcpy (tmp, state, sizeof (tmp));
 
   for (i = 0; i < len; i++) {
+    tmp[7] ^= *data;
+
     /* Multiplication */
 
     /* lowest 32 bits */
 
     /* multiply and keep carries forward */
-    tmp2[7] = (tmp[7] ^ *data) * 0x00000163;
+    tmp2[7] = tmp[7] * 0x00000163;
     tmp2[6] = tmp[6] * 0x00000163 + (tmp2[7] >> 32);
     tmp2[5] = tmp[5] * 0x00000163 + (tmp2[6] >> 32);
     tmp2[4] = tmp[4] * 0x00000163 + (tmp2[5] >> 32);
@@ -411,38 +1261,68 @@ snippets_fnv1a_256 (const uint8_t * data, size_t len, uint8_t hash[32])
     data++;
   }
 
-  hash[0] = (tmp[0] >> 24) & 0xff;
-  hash[1] = (tmp[0] >> 16) & 0xff;
-  hash[2] = (tmp[0] >> 8) & 0xff;
-  hash[3] = (tmp[0] >> 0) & 0xff;
-  hash[4] = (tmp[1] >> 24) & 0xff;
-  hash[5] = (tmp[1] >> 16) & 0xff;
-  hash[6] = (tmp[1] >> 8) & 0xff;
-  hash[7] = (tmp[1] >> 0) & 0xff;
-  hash[8] = (tmp[2] >> 24) & 0xff;
-  hash[9] = (tmp[2] >> 16) & 0xff;
-  hash[10] = (tmp[2] >> 8) & 0xff;
-  hash[11] = (tmp[2] >> 0) & 0xff;
-  hash[12] = (tmp[3] >> 24) & 0xff;
-  hash[13] = (tmp[3] >> 16) & 0xff;
-  hash[14] = (tmp[3] >> 8) & 0xff;
-  hash[15] = (tmp[3] >> 0) & 0xff;
-  hash[16] = (tmp[4] >> 24) & 0xff;
-  hash[17] = (tmp[4] >> 16) & 0xff;
-  hash[18] = (tmp[4] >> 8) & 0xff;
-  hash[19] = (tmp[4] >> 0) & 0xff;
-  hash[20] = (tmp[5] >> 24) & 0xff;
-  hash[21] = (tmp[5] >> 16) & 0xff;
-  hash[22] = (tmp[5] >> 8) & 0xff;
-  hash[23] = (tmp[5] >> 0) & 0xff;
-  hash[24] = (tmp[6] >> 24) & 0xff;
-  hash[25] = (tmp[6] >> 16) & 0xff;
-  hash[26] = (tmp[6] >> 8) & 0xff;
-  hash[27] = (tmp[6] >> 0) & 0xff;
-  hash[28] = (tmp[7] >> 24) & 0xff;
-  hash[29] = (tmp[7] >> 16) & 0xff;
-  hash[30] = (tmp[7] >> 8) & 0xff;
-  hash[31] = (tmp[7] >> 0) & 0xff;
+  memcpy (state, tmp, sizeof (tmp));
+}
+#endif
+
+void
+snippets_fnv1_256 (const uint8_t * data, size_t len, uint8_t hash[32])
+{
+  uint64_t tmp[8];
+
+  memcpy (tmp, FNV_offset_256, sizeof (tmp));
+  fnv1_256_update (tmp, data, len);
+  fnv_final (tmp, 256, hash);
+}
+
+void
+snippets_fnv1_256_words (const uint8_t * data, size_t len, uint32_t hash[8])
+{
+  uint64_t tmp[8];
+
+  memcpy (tmp, FNV_offset_256, sizeof (tmp));
+  fnv1_256_update (tmp, data, len);
+  fnv_final_words (tmp, 256, hash);
+}
+
+void
+snippets_fnv1_256_iov (const struct iovec *iov, int n, uint8_t hash[32])
+{
+  uint64_t tmp[8];
+
+  memcpy (tmp, FNV_offset_256, sizeof (tmp));
+  fnv_update_iov (fnv1_256_update, tmp, iov, n);
+  fnv_final (tmp, 256, hash);
+}
+
+void
+snippets_fnv1a_256 (const uint8_t * data, size_t len, uint8_t hash[32])
+{
+  uint64_t tmp[8];
+
+  memcpy (tmp, FNV_offset_256, sizeof (tmp));
+  fnv1a_256_update (tmp, data, len);
+  fnv_final (tmp, 256, hash);
+}
+
+void
+snippets_fnv1a_256_words (const uint8_t * data, size_t len, uint32_t hash[8])
+{
+  uint64_t tmp[8];
+
+  memcpy (tmp, FNV_offset_256, sizeof (tmp));
+  fnv1a_256_update (tmp, data, len);
+  fnv_final_words (tmp, 256, hash);
+}
+
+void
+snippets_fnv1a_256_iov (const struct iovec *iov, int n, uint8_t hash[32])
+{
+  uint64_t tmp[8];
+
+  memcpy (tmp, FNV_offset_256, sizeof (tmp));
+  fnv_update_iov (fnv1a_256_update, tmp, iov, n);
+  fnv_final (tmp, 256, hash);
 }
 
 /* 512 bit prime  = 3583591587484486736891907648909510844994632795575439255839
@@ -456,29 +1336,35 @@ snippets_fnv1a_256 (const uint8_t * data, size_t len, uint8_t hash[32])
  *                  00000d21e948f68a34c192f62ea79bc942dbe7ce182036415f56e34bac
  *                  982aac4afe9fd9
  */
-void
-snippets_fnv1_512 (const uint8_t * data, size_t len, uint8_t hash[64])
+
+/* 512 bit offset, 32 bit per field, highest 32 bit first */
+static const uint64_t FNV_offset_512[16] = {
+  0xb86db0b1, 0x171f4416, 0xdca1e50f, 0x309990ac,
+  0xac87d059, 0xc9000000, 0x00000000, 0x00000d21,
+  0xe948f68a, 0x34c192f6, 0x2ea79bc9, 0x42dbe7ce,
+  0x18203641, 0x5f56e34b, 0xac982aac, 0x4afe9fd9
+};
+
+#ifdef HAVE_UNSIGNED___INT128
+static void
+fnv1_512_update (uint64_t * state, const uint8_t * data, size_t len)
+{
+  fnv_update_int128 (state, data, len, FALSE, 8, 344, 0x157);
+}
+
+static void
+fnv1a_512_update (uint64_t * state, const uint8_t * data, size_t len)
+{
+  fnv_update_int128 (state, data, len, TRUE, 8, 344, 0x157);
+}
+#else
+static void
+fnv1_512_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
   uint64_t tmp[16], tmp2[16];
 
-  /* 512 bit number, 32 bit per field, highest 32 bit first */
-  tmp[0] = 0xb86db0b1;
-  tmp[1] = 0x171f4416;
-  tmp[2] = 0xdca1e50f;
-  tmp[3] = 0x309990ac;
-  tmp[4] = 0xac87d059;
-  tmp[5] = 0xc9000000;
-  tmp[6] = 0x00000000;
-  tmp[7] = 0x00000d21;
-  tmp[8] = 0xe948f68a;
-  tmp[9] = 0x34c192f6;
-  tmp[10] = 0x2ea79bc9;
-  tmp[11] = 0x42dbe7ce;
-  tmp[12] = 0x18203641;
-  tmp[13] = 0x5f56e34b;
-  tmp[14] = 0xac982aac;
-  tmp[15] = 0x4afe9fd9;
+  memcpy (tmp, state, sizeof (tmp));
 
   for (i = 0; i < len; i++) {
     /* Multiplication */
@@ -557,104 +1443,26 @@ snippets_fnv1_512 (const uint8_t * data, size_t len, uint8_t hash[64])
     data++;
   }
 
-  hash[0] = (tmp[0] >> 24) & 0xff;
-  hash[1] = (tmp[0] >> 16) & 0xff;
-  hash[2] = (tmp[0] >> 8) & 0xff;
-  hash[3] = (tmp[0] >> 0) & 0xff;
-  hash[4] = (tmp[1] >> 24) & 0xff;
-  hash[5] = (tmp[1] >> 16) & 0xff;
-  hash[6] = (tmp[1] >> 8) & 0xff;
-  hash[7] = (tmp[1] >> 0) & 0xff;
-  hash[8] = (tmp[2] >> 24) & 0xff;
-  hash[9] = (tmp[2] >> 16) & 0xff;
-  hash[10] = (tmp[2] >> 8) & 0xff;
-  hash[11] = (tmp[2] >> 0) & 0xff;
-  hash[12] = (tmp[3] >> 24) & 0xff;
-  hash[13] = (tmp[3] >> 16) & 0xff;
-  hash[14] = (tmp[3] >> 8) & 0xff;
-  hash[15] = (tmp[3] >> 0) & 0xff;
-  hash[16] = (tmp[4] >> 24) & 0xff;
-  hash[17] = (tmp[4] >> 16) & 0xff;
-  hash[18] = (tmp[4] >> 8) & 0xff;
-  hash[19] = (tmp[4] >> 0) & 0xff;
-  hash[20] = (tmp[5] >> 24) & 0xff;
-  hash[21] = (tmp[5] >> 16) & 0xff;
-  hash[22] = (tmp[5] >> 8) & 0xff;
-  hash[23] = (tmp[5] >> 0) & 0xff;
-  hash[24] = (tmp[6] >> 24) & 0xff;
-  hash[25] = (tmp[6] >> 16) & 0xff;
-  hash[26] = (tmp[6] >> 8) & 0xff;
-  hash[27] = (tmp[6] >> 0) & 0xff;
-  hash[28] = (tmp[7] >> 24) & 0xff;
-  hash[29] = (tmp[7] >> 16) & 0xff;
-  hash[30] = (tmp[7] >> 8) & 0xff;
-  hash[31] = (tmp[7] >> 0) & 0xff;
-
-  hash[32] = (tmp[8] >> 24) & 0xff;
-  hash[33] = (tmp[8] >> 16) & 0xff;
-  hash[34] = (tmp[8] >> 8) & 0xff;
-  hash[35] = (tmp[8] >> 0) & 0xff;
-  hash[36] = (tmp[9] >> 24) & 0xff;
-  hash[37] = (tmp[9] >> 16) & 0xff;
-  hash[38] = (tmp[9] >> 8) & 0xff;
-  hash[39] = (tmp[9] >> 0) & 0xff;
-  hash[40] = (tmp[10] >> 24) & 0xff;
-  hash[41] = (tmp[10] >> 16) & 0xff;
-  hash[42] = (tmp[10] >> 8) & 0xff;
-  hash[43] = (tmp[10] >> 0) & 0xff;
-  hash[44] = (tmp[11] >> 24) & 0xff;
-  hash[45] = (tmp[11] >> 16) & 0xff;
-  hash[46] = (tmp[11] >> 8) & 0xff;
-  hash[47] = (tmp[11] >> 0) & 0xff;
-  hash[48] = (tmp[12] >> 24) & 0xff;
-  hash[49] = (tmp[12] >> 16) & 0xff;
-  hash[50] = (tmp[12] >> 8) & 0xff;
-  hash[51] = (tmp[12] >> 0) & 0xff;
-  hash[52] = (tmp[13] >> 24) & 0xff;
-  hash[53] = (tmp[13] >> 16) & 0xff;
-  hash[54] = (tmp[13] >> 8) & 0xff;
-  hash[55] = (tmp[13] >> 0) & 0xff;
-  hash[56] = (tmp[14] >> 24) & 0xff;
-  hash[57] = (tmp[14] >> 16) & 0xff;
-  hash[58] = (tmp[14] >> 8) & 0xff;
-  hash[59] = (tmp[14] >> 0) & 0xff;
-  hash[60] = (tmp[15] >> 24) & 0xff;
-  hash[61] = (tmp[15] >> 16) & 0xff;
-  hash[62] = (tmp[15] >> 8) & 0xff;
-  hash[63] = (tmp[15] >> 0) & 0xff;
+  memcpy (state, tmp, sizeof (tmp));
 }
 
-void
-snippets_fnv1a_512 (const uint8_t * data, size_t len, uint8_t hash[64])
+static void
+fnv1a_512_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
   uint64_t tmp[16], tmp2[16];
 
-  /* 512 bit number, 32 bit per field, highest 32 bit first */
-  tmp[0] = 0xb86db0b1;
-  tmp[1] = 0x171f4416;
-  tmp[2] = 0xdca1e50f;
-  tmp[3] = 0x309990ac;
-  tmp[4] = 0xac87d059;
-  tmp[5] = 0xc9000000;
-  tmp[6] = 0x00000000;
-  tmp[7] = 0x00000d21;
-  tmp[8] = 0xe948f68a;
-  tmp[9] = 0x34c192f6;
-  tmp[10] = 0x2ea79bc9;
-  tmp[11] = 0x42dbe7ce;
-  tmp[12] = 0x18203641;
-  tmp[13] = 0x5f56e34b;
-  tmp[14] = 0xac982aac;
-  tmp[15] = 0x4afe9fd9;
+  memcpy (tmp, state, sizeof (tmp));
 
   for (i = 0; i < len; i++) {
+    tmp[15] ^= *data;
+
     /* Multiplication */
 
     /* lowest 32 bits */
 
     /* multiply and keep carries forward */
-    tmp2[15] = (*data ^ tmp[15]) * 0x00000157;
+    tmp2[15] = tmp[15] * 0x00000157;
     tmp2[14] = tmp[14] * 0x00000157 + (tmp2[15] >> 32);
     tmp2[13] = tmp[13] * 0x00000157 + (tmp2[14] >> 32);
     tmp2[12] = tmp[12] * 0x00000157 + (tmp2[13] >> 32);
@@ -725,71 +1533,68 @@ snippets_fnv1a_512 (const uint8_t * data, size_t len, uint8_t hash[64])
     data++;
   }
 
-  hash[0] = (tmp[0] >> 24) & 0xff;
-  hash[1] = (tmp[0] >> 16) & 0xff;
-  hash[2] = (tmp[0] >> 8) & 0xff;
-  hash[3] = (tmp[0] >> 0) & 0xff;
-  hash[4] = (tmp[1] >> 24) & 0xff;
-  hash[5] = (tmp[1] >> 16) & 0xff;
-  hash[6] = (tmp[1] >> 8) & 0xff;
-  hash[7] = (tmp[1] >> 0) & 0xff;
-  hash[8] = (tmp[2] >> 24) & 0xff;
-  hash[9] = (tmp[2] >> 16) & 0xff;
-  hash[10] = (tmp[2] >> 8) & 0xff;
-  hash[11] = (tmp[2] >> 0) & 0xff;
-  hash[12] = (tmp[3] >> 24) & 0xff;
-  hash[13] = (tmp[3] >> 16) & 0xff;
-  hash[14] = (tmp[3] >> 8) & 0xff;
-  hash[15] = (tmp[3] >> 0) & 0xff;
-  hash[16] = (tmp[4] >> 24) & 0xff;
-  hash[17] = (tmp[4] >> 16) & 0xff;
-  hash[18] = (tmp[4] >> 8) & 0xff;
-  hash[19] = (tmp[4] >> 0) & 0xff;
-  hash[20] = (tmp[5] >> 24) & 0xff;
-  hash[21] = (tmp[5] >> 16) & 0xff;
-  hash[22] = (tmp[5] >> 8) & 0xff;
-  hash[23] = (tmp[5] >> 0) & 0xff;
-  hash[24] = (tmp[6] >> 24) & 0xff;
-  hash[25] = (tmp[6] >> 16) & 0xff;
-  hash[26] = (tmp[6] >> 8) & 0xff;
-  hash[27] = (tmp[6] >> 0) & 0xff;
-  hash[28] = (tmp[7] >> 24) & 0xff;
-  hash[29] = (tmp[7] >> 16) & 0xff;
-  hash[30] = (tmp[7] >> 8) & 0xff;
-  hash[31] = (tmp[7] >> 0) & 0xff;
-
-  hash[32] = (tmp[8] >> 24) & 0xff;
-  hash[33] = (tmp[8] >> 16) & 0xff;
-  hash[34] = (tmp[8] >> 8) & 0xff;
-  hash[35] = (tmp[8] >> 0) & 0xff;
-  hash[36] = (tmp[9] >> 24) & 0xff;
-  hash[37] = (tmp[9] >> 16) & 0xff;
-  hash[38] = (tmp[9] >> 8) & 0xff;
-  hash[39] = (tmp[9] >> 0) & 0xff;
-  hash[40] = (tmp[10] >> 24) & 0xff;
-  hash[41] = (tmp[10] >> 16) & 0xff;
-  hash[42] = (tmp[10] >> 8) & 0xff;
-  hash[43] = (tmp[10] >> 0) & 0xff;
-  hash[44] = (tmp[11] >> 24) & 0xff;
-  hash[45] = (tmp[11] >> 16) & 0xff;
-  hash[46] = (tmp[11] >> 8) & 0xff;
-  hash[47] = (tmp[11] >> 0) & 0xff;
-  hash[48] = (tmp[12] >> 24) & 0xff;
-  hash[49] = (tmp[12] >> 16) & 0xff;
-  hash[50] = (tmp[12] >> 8) & 0xff;
-  hash[51] = (tmp[12] >> 0) & 0xff;
-  hash[52] = (tmp[13] >> 24) & 0xff;
-  hash[53] = (tmp[13] >> 16) & 0xff;
-  hash[54] = (tmp[13] >> 8) & 0xff;
-  hash[55] = (tmp[13] >> 0) & 0xff;
-  hash[56] = (tmp[14] >> 24) & 0xff;
-  hash[57] = (tmp[14] >> 16) & 0xff;
-  hash[58] = (tmp[14] >> 8) & 0xff;
-  hash[59] = (tmp[14] >> 0) & 0xff;
-  hash[60] = (tmp[15] >> 24) & 0xff;
-  hash[61] = (tmp[15] >> 16) & 0xff;
-  hash[62] = (tmp[15] >> 8) & 0xff;
-  hash[63] = (tmp[15] >> 0) & 0xff;
+  memcpy (state, tmp, sizeof (tmp));
+}
+#endif
+
+void
+snippets_fnv1_512 (const uint8_t * data, size_t len, uint8_t hash[64])
+{
+  uint64_t tmp[16];
+
+  memcpy (tmp, FNV_offset_512, sizeof (tmp));
+  fnv1_512_update (tmp, data, len);
+  fnv_final (tmp, 512, hash);
+}
+
+void
+snippets_fnv1_512_words (const uint8_t * data, size_t len, uint32_t hash[16])
+{
+  uint64_t tmp[16];
+
+  memcpy (tmp, FNV_offset_512, sizeof (tmp));
+  fnv1_512_update (tmp, data, len);
+  fnv_final_words (tmp, 512, hash);
+}
+
+void
+snippets_fnv1_512_iov (const struct iovec *iov, int n, uint8_t hash[64])
+{
+  uint64_t tmp[16];
+
+  memcpy (tmp, FNV_offset_512, sizeof (tmp));
+  fnv_update_iov (fnv1_512_update, tmp, iov, n);
+  fnv_final (tmp, 512, hash);
+}
+
+void
+snippets_fnv1a_512 (const uint8_t * data, size_t len, uint8_t hash[64])
+{
+  uint64_t tmp[16];
+
+  memcpy (tmp, FNV_offset_512, sizeof (tmp));
+  fnv1a_512_update (tmp, data, len);
+  fnv_final (tmp, 512, hash);
+}
+
+void
+snippets_fnv1a_512_words (const uint8_t * data, size_t len, uint32_t hash[16])
+{
+  uint64_t tmp[16];
+
+  memcpy (tmp, FNV_offset_512, sizeof (tmp));
+  fnv1a_512_update (tmp, data, len);
+  fnv_final_words (tmp, 512, hash);
+}
+
+void
+snippets_fnv1a_512_iov (const struct iovec *iov, int n, uint8_t hash[64])
+{
+  uint64_t tmp[16];
+
+  memcpy (tmp, FNV_offset_512, sizeof (tmp));
+  fnv_update_iov (fnv1a_512_update, tmp, iov, n);
+  fnv_final (tmp, 512, hash);
 }
 
 /* 1024 bit prime  = 501645651011311865543459881103527895503076534540479074
@@ -812,45 +1617,39 @@ snippets_fnv1a_512 (const uint8_t * data, size_t len, uint8_t hash[64])
  *                   0000000004c6d7eb6e73802734510a555f256cc005ae556bde8cc9
  *                   c6a93b21aff4b16c71ee90b3
  */
-void
-snippets_fnv1_1024 (const uint8_t * data, size_t len, uint8_t hash[128])
+
+/* 1024 bit offset, 32 bit per field, highest 32 bit first */
+static const uint64_t FNV_offset_1024[32] = {
+  0x00000000, 0x00000000, 0x005f7a76, 0x758ecc4d,
+  0x32e56d5a, 0x591028b7, 0x4b29fc42, 0x23fdada1,
+  0x6c3bf34e, 0xda3674da, 0x9a21d900, 0x00000000,
+  0x00000000, 0x00000000, 0x00000000, 0x00000000,
+  0x00000000, 0x00000000, 0x00000000, 0x00000000,
+  0x00000000, 0x00000000, 0x00000000, 0x0004c6d7,
+  0xeb6e7380, 0x2734510a, 0x555f256c, 0xc005ae55,
+  0x6bde8cc9, 0xc6a93b21, 0xaff4b16c, 0x71ee90b3
+};
+
+#ifdef HAVE_UNSIGNED___INT128
+static void
+fnv1_1024_update (uint64_t * state, const uint8_t * data, size_t len)
+{
+  fnv_update_int128 (state, data, len, FALSE, 16, 680, 0x18d);
+}
+
+static void
+fnv1a_1024_update (uint64_t * state, const uint8_t * data, size_t len)
+{
+  fnv_update_int128 (state, data, len, TRUE, 16, 680, 0x18d);
+}
+#else
+static void
+fnv1_1024_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
   uint64_t tmp[32], tmp2[32];
 
-  /* 1024 bit number, 32 bit per field, highest 32 bit first */
-  tmp[0] = 0x00000000;
-  tmp[1] = 0x00000000;
-  tmp[2] = 0x005f7a76;
-  tmp[3] = 0x758ecc4d;
-  tmp[4] = 0x32e56d5a;
-  tmp[5] = 0x591028b7;
-  tmp[6] = 0x4b29fc42;
-  tmp[7] = 0x23fdada1;
-  tmp[8] = 0x6c3bf34e;
-  tmp[9] = 0xda3674da;
-  tmp[10] = 0x9a21d900;
-  tmp[11] = 0x00000000;
-  tmp[12] = 0x00000000;
-  tmp[13] = 0x00000000;
-  tmp[14] = 0x00000000;
-  tmp[15] = 0x00000000;
-  tmp[16] = 0x00000000;
-  tmp[17] = 0x00000000;
-  tmp[18] = 0x00000000;
-  tmp[19] = 0x00000000;
-  tmp[20] = 0x00000000;
-  tmp[21] = 0x00000000;
-  tmp[22] = 0x00000000;
-  tmp[23] = 0x0004c6d7;
-  tmp[24] = 0xeb6e7380;
-  tmp[25] = 0x2734510a;
-  tmp[26] = 0x555f256c;
-  tmp[27] = 0xc005ae55;
-  tmp[28] = 0x6bde8cc9;
-  tmp[29] = 0xc6a93b21;
-  tmp[30] = 0xaff4b16c;
-  tmp[31] = 0x71ee90b3;
+  memcpy (tmp, state, sizeof (tmp));
 
   for (i = 0; i < len; i++) {
     /* Multiplication */
@@ -987,186 +1786,26 @@ snippets_fnv1_1024 (const uint8_t * data, size_t len, uint8_t hash[128])
     data++;
   }
 
-  hash[0] = (tmp[0] >> 24) & 0xff;
-  hash[1] = (tmp[0] >> 16) & 0xff;
-  hash[2] = (tmp[0] >> 8) & 0xff;
-  hash[3] = (tmp[0] >> 0) & 0xff;
-  hash[4] = (tmp[1] >> 24) & 0xff;
-  hash[5] = (tmp[1] >> 16) & 0xff;
-  hash[6] = (tmp[1] >> 8) & 0xff;
-  hash[7] = (tmp[1] >> 0) & 0xff;
-  hash[8] = (tmp[2] >> 24) & 0xff;
-  hash[9] = (tmp[2] >> 16) & 0xff;
-  hash[10] = (tmp[2] >> 8) & 0xff;
-  hash[11] = (tmp[2] >> 0) & 0xff;
-  hash[12] = (tmp[3] >> 24) & 0xff;
-  hash[13] = (tmp[3] >> 16) & 0xff;
-  hash[14] = (tmp[3] >> 8) & 0xff;
-  hash[15] = (tmp[3] >> 0) & 0xff;
-  hash[16] = (tmp[4] >> 24) & 0xff;
-  hash[17] = (tmp[4] >> 16) & 0xff;
-  hash[18] = (tmp[4] >> 8) & 0xff;
-  hash[19] = (tmp[4] >> 0) & 0xff;
-  hash[20] = (tmp[5] >> 24) & 0xff;
-  hash[21] = (tmp[5] >> 16) & 0xff;
-  hash[22] = (tmp[5] >> 8) & 0xff;
-  hash[23] = (tmp[5] >> 0) & 0xff;
-  hash[24] = (tmp[6] >> 24) & 0xff;
-  hash[25] = (tmp[6] >> 16) & 0xff;
-  hash[26] = (tmp[6] >> 8) & 0xff;
-  hash[27] = (tmp[6] >> 0) & 0xff;
-  hash[28] = (tmp[7] >> 24) & 0xff;
-  hash[29] = (tmp[7] >> 16) & 0xff;
-  hash[30] = (tmp[7] >> 8) & 0xff;
-  hash[31] = (tmp[7] >> 0) & 0xff;
-
-  hash[32] = (tmp[8] >> 24) & 0xff;
-  hash[33] = (tmp[8] >> 16) & 0xff;
-  hash[34] = (tmp[8] >> 8) & 0xff;
-  hash[35] = (tmp[8] >> 0) & 0xff;
-  hash[36] = (tmp[9] >> 24) & 0xff;
-  hash[37] = (tmp[9] >> 16) & 0xff;
-  hash[38] = (tmp[9] >> 8) & 0xff;
-  hash[39] = (tmp[9] >> 0) & 0xff;
-  hash[40] = (tmp[10] >> 24) & 0xff;
-  hash[41] = (tmp[10] >> 16) & 0xff;
-  hash[42] = (tmp[10] >> 8) & 0xff;
-  hash[43] = (tmp[10] >> 0) & 0xff;
-  hash[44] = (tmp[11] >> 24) & 0xff;
-  hash[45] = (tmp[11] >> 16) & 0xff;
-  hash[46] = (tmp[11] >> 8) & 0xff;
-  hash[47] = (tmp[11] >> 0) & 0xff;
-  hash[48] = (tmp[12] >> 24) & 0xff;
-  hash[49] = (tmp[12] >> 16) & 0xff;
-  hash[50] = (tmp[12] >> 8) & 0xff;
-  hash[51] = (tmp[12] >> 0) & 0xff;
-  hash[52] = (tmp[13] >> 24) & 0xff;
-  hash[53] = (tmp[13] >> 16) & 0xff;
-  hash[54] = (tmp[13] >> 8) & 0xff;
-  hash[55] = (tmp[13] >> 0) & 0xff;
-  hash[56] = (tmp[14] >> 24) & 0xff;
-  hash[57] = (tmp[14] >> 16) & 0xff;
-  hash[58] = (tmp[14] >> 8) & 0xff;
-  hash[59] = (tmp[14] >> 0) & 0xff;
-  hash[60] = (tmp[15] >> 24) & 0xff;
-  hash[61] = (tmp[15] >> 16) & 0xff;
-  hash[62] = (tmp[15] >> 8) & 0xff;
-  hash[63] = (tmp[15] >> 0) & 0xff;
-
-  hash[64] = (tmp[16] >> 24) & 0xff;
-  hash[65] = (tmp[16] >> 16) & 0xff;
-  hash[66] = (tmp[16] >> 8) & 0xff;
-  hash[67] = (tmp[16] >> 0) & 0xff;
-  hash[68] = (tmp[17] >> 24) & 0xff;
-  hash[69] = (tmp[17] >> 16) & 0xff;
-  hash[70] = (tmp[17] >> 8) & 0xff;
-  hash[71] = (tmp[17] >> 0) & 0xff;
-  hash[72] = (tmp[18] >> 24) & 0xff;
-  hash[73] = (tmp[18] >> 16) & 0xff;
-  hash[74] = (tmp[18] >> 8) & 0xff;
-  hash[75] = (tmp[18] >> 0) & 0xff;
-  hash[76] = (tmp[19] >> 24) & 0xff;
-  hash[77] = (tmp[19] >> 16) & 0xff;
-  hash[78] = (tmp[19] >> 8) & 0xff;
-  hash[79] = (tmp[19] >> 0) & 0xff;
-  hash[80] = (tmp[20] >> 24) & 0xff;
-  hash[81] = (tmp[20] >> 16) & 0xff;
-  hash[82] = (tmp[20] >> 8) & 0xff;
-  hash[83] = (tmp[20] >> 0) & 0xff;
-  hash[84] = (tmp[21] >> 24) & 0xff;
-  hash[85] = (tmp[21] >> 16) & 0xff;
-  hash[86] = (tmp[21] >> 8) & 0xff;
-  hash[87] = (tmp[21] >> 0) & 0xff;
-  hash[88] = (tmp[22] >> 24) & 0xff;
-  hash[89] = (tmp[22] >> 16) & 0xff;
-  hash[90] = (tmp[22] >> 8) & 0xff;
-  hash[91] = (tmp[22] >> 0) & 0xff;
-  hash[92] = (tmp[23] >> 24) & 0xff;
-  hash[93] = (tmp[23] >> 16) & 0xff;
-  hash[94] = (tmp[23] >> 8) & 0xff;
-  hash[95] = (tmp[23] >> 0) & 0xff;
-
-  hash[96] = (tmp[24] >> 24) & 0xff;
-  hash[97] = (tmp[24] >> 16) & 0xff;
-  hash[98] = (tmp[24] >> 8) & 0xff;
-  hash[99] = (tmp[24] >> 0) & 0xff;
-  hash[100] = (tmp[25] >> 24) & 0xff;
-  hash[101] = (tmp[25] >> 16) & 0xff;
-  hash[102] = (tmp[25] >> 8) & 0xff;
-  hash[103] = (tmp[25] >> 0) & 0xff;
-  hash[104] = (tmp[26] >> 24) & 0xff;
-  hash[105] = (tmp[26] >> 16) & 0xff;
-  hash[106] = (tmp[26] >> 8) & 0xff;
-  hash[107] = (tmp[26] >> 0) & 0xff;
-  hash[108] = (tmp[27] >> 24) & 0xff;
-  hash[109] = (tmp[27] >> 16) & 0xff;
-  hash[110] = (tmp[27] >> 8) & 0xff;
-  hash[111] = (tmp[27] >> 0) & 0xff;
-  hash[112] = (tmp[28] >> 24) & 0xff;
-  hash[113] = (tmp[28] >> 16) & 0xff;
-  hash[114] = (tmp[28] >> 8) & 0xff;
-  hash[115] = (tmp[28] >> 0) & 0xff;
-  hash[116] = (tmp[29] >> 24) & 0xff;
-  hash[117] = (tmp[29] >> 16) & 0xff;
-  hash[118] = (tmp[29] >> 8) & 0xff;
-  hash[119] = (tmp[29] >> 0) & 0xff;
-  hash[120] = (tmp[30] >> 24) & 0xff;
-  hash[121] = (tmp[30] >> 16) & 0xff;
-  hash[122] = (tmp[30] >> 8) & 0xff;
-  hash[123] = (tmp[30] >> 0) & 0xff;
-  hash[124] = (tmp[31] >> 24) & 0xff;
-  hash[125] = (tmp[31] >> 16) & 0xff;
-  hash[126] = (tmp[31] >> 8) & 0xff;
-  hash[127] = (tmp[31] >> 0) & 0xff;
+  memcpy (state, tmp, sizeof (tmp));
 }
 
-void
-snippets_fnv1a_1024 (const uint8_t * data, size_t len, uint8_t hash[128])
+static void
+fnv1a_1024_update (uint64_t * state, const uint8_t * data, size_t len)
 {
   size_t i;
   uint64_t tmp[32], tmp2[32];
 
-  /* 1024 bit number, 32 bit per field, highest 32 bit first */
-  tmp[0] = 0x00000000;
-  tmp[1] = 0x00000000;
-  tmp[2] = 0x005f7a76;
-  tmp[3] = 0x758ecc4d;
-  tmp[4] = 0x32e56d5a;
-  tmp[5] = 0x591028b7;
-  tmp[6] = 0x4b29fc42;
-  tmp[7] = 0x23fdada1;
-  tmp[8] = 0x6c3bf34e;
-  tmp[9] = 0xda3674da;
-  tmp[10] = 0x9a21d900;
-  tmp[11] = 0x00000000;
-  tmp[12] = 0x00000000;
-  tmp[13] = 0x00000000;
-  tmp[14] = 0x00000000;
-  tmp[15] = 0x00000000;
-  tmp[16] = 0x00000000;
-  tmp[17] = 0x00000000;
-  tmp[18] = 0x00000000;
-  tmp[19] = 0x00000000;
-  tmp[20] = 0x00000000;
-  tmp[21] = 0x00000000;
-  tmp[22] = 0x00000000;
-  tmp[23] = 0x0004c6d7;
-  tmp[24] = 0xeb6e7380;
-  tmp[25] = 0x2734510a;
-  tmp[26] = 0x555f256c;
-  tmp[27] = 0xc005ae55;
-  tmp[28] = 0x6bde8cc9;
-  tmp[29] = 0xc6a93b21;
-  tmp[30] = 0xaff4b16c;
-  tmp[31] = 0x71ee90b3;
+  memcpy (tmp, state, sizeof (tmp));
 
   for (i = 0; i < len; i++) {
+    tmp[31] ^= *data;
+
     /* Multiplication */
 
     /* lowest 32 bits */
 
     /* multiply and keep carries forward */
-    tmp2[31] = (*data ^ tmp[31]) * 0x0000018d;
+    tmp2[31] = tmp[31] * 0x0000018d;
     tmp2[30] = tmp[30] * 0x0000018d + (tmp2[31] >> 32);
     tmp2[29] = tmp[29] * 0x0000018d + (tmp2[30] >> 32);
     tmp2[28] = tmp[28] * 0x0000018d + (tmp2[29] >> 32);
@@ -1295,135 +1934,499 @@ snippets_fnv1a_1024 (const uint8_t * data, size_t len, uint8_t hash[128])
     data++;
   }
 
-  hash[0] = (tmp[0] >> 24) & 0xff;
-  hash[1] = (tmp[0] >> 16) & 0xff;
-  hash[2] = (tmp[0] >> 8) & 0xff;
-  hash[3] = (tmp[0] >> 0) & 0xff;
-  hash[4] = (tmp[1] >> 24) & 0xff;
-  hash[5] = (tmp[1] >> 16) & 0xff;
-  hash[6] = (tmp[1] >> 8) & 0xff;
-  hash[7] = (tmp[1] >> 0) & 0xff;
-  hash[8] = (tmp[2] >> 24) & 0xff;
-  hash[9] = (tmp[2] >> 16) & 0xff;
-  hash[10] = (tmp[2] >> 8) & 0xff;
-  hash[11] = (tmp[2] >> 0) & 0xff;
-  hash[12] = (tmp[3] >> 24) & 0xff;
-  hash[13] = (tmp[3] >> 16) & 0xff;
-  hash[14] = (tmp[3] >> 8) & 0xff;
-  hash[15] = (tmp[3] >> 0) & 0xff;
-  hash[16] = (tmp[4] >> 24) & 0xff;
-  hash[17] = (tmp[4] >> 16) & 0xff;
-  hash[18] = (tmp[4] >> 8) & 0xff;
-  hash[19] = (tmp[4] >> 0) & 0xff;
-  hash[20] = (tmp[5] >> 24) & 0xff;
-  hash[21] = (tmp[5] >> 16) & 0xff;
-  hash[22] = (tmp[5] >> 8) & 0xff;
-  hash[23] = (tmp[5] >> 0) & 0xff;
-  hash[24] = (tmp[6] >> 24) & 0xff;
-  hash[25] = (tmp[6] >> 16) & 0xff;
-  hash[26] = (tmp[6] >> 8) & 0xff;
-  hash[27] = (tmp[6] >> 0) & 0xff;
-  hash[28] = (tmp[7] >> 24) & 0xff;
-  hash[29] = (tmp[7] >> 16) & 0xff;
-  hash[30] = (tmp[7] >> 8) & 0xff;
-  hash[31] = (tmp[7] >> 0) & 0xff;
-
-  hash[32] = (tmp[8] >> 24) & 0xff;
-  hash[33] = (tmp[8] >> 16) & 0xff;
-  hash[34] = (tmp[8] >> 8) & 0xff;
-  hash[35] = (tmp[8] >> 0) & 0xff;
-  hash[36] = (tmp[9] >> 24) & 0xff;
-  hash[37] = (tmp[9] >> 16) & 0xff;
-  hash[38] = (tmp[9] >> 8) & 0xff;
-  hash[39] = (tmp[9] >> 0) & 0xff;
-  hash[40] = (tmp[10] >> 24) & 0xff;
-  hash[41] = (tmp[10] >> 16) & 0xff;
-  hash[42] = (tmp[10] >> 8) & 0xff;
-  hash[43] = (tmp[10] >> 0) & 0xff;
-  hash[44] = (tmp[11] >> 24) & 0xff;
-  hash[45] = (tmp[11] >> 16) & 0xff;
-  hash[46] = (tmp[11] >> 8) & 0xff;
-  hash[47] = (tmp[11] >> 0) & 0xff;
-  hash[48] = (tmp[12] >> 24) & 0xff;
-  hash[49] = (tmp[12] >> 16) & 0xff;
-  hash[50] = (tmp[12] >> 8) & 0xff;
-  hash[51] = (tmp[12] >> 0) & 0xff;
-  hash[52] = (tmp[13] >> 24) & 0xff;
-  hash[53] = (tmp[13] >> 16) & 0xff;
-  hash[54] = (tmp[13] >> 8) & 0xff;
-  hash[55] = (tmp[13] >> 0) & 0xff;
-  hash[56] = (tmp[14] >> 24) & 0xff;
-  hash[57] = (tmp[14] >> 16) & 0xff;
-  hash[58] = (tmp[14] >> 8) & 0xff;
-  hash[59] = (tmp[14] >> 0) & 0xff;
-  hash[60] = (tmp[15] >> 24) & 0xff;
-  hash[61] = (tmp[15] >> 16) & 0xff;
-  hash[62] = (tmp[15] >> 8) & 0xff;
-  hash[63] = (tmp[15] >> 0) & 0xff;
-
-  hash[64] = (tmp[16] >> 24) & 0xff;
-  hash[65] = (tmp[16] >> 16) & 0xff;
-  hash[66] = (tmp[16] >> 8) & 0xff;
-  hash[67] = (tmp[16] >> 0) & 0xff;
-  hash[68] = (tmp[17] >> 24) & 0xff;
-  hash[69] = (tmp[17] >> 16) & 0xff;
-  hash[70] = (tmp[17] >> 8) & 0xff;
-  hash[71] = (tmp[17] >> 0) & 0xff;
-  hash[72] = (tmp[18] >> 24) & 0xff;
-  hash[73] = (tmp[18] >> 16) & 0xff;
-  hash[74] = (tmp[18] >> 8) & 0xff;
-  hash[75] = (tmp[18] >> 0) & 0xff;
-  hash[76] = (tmp[19] >> 24) & 0xff;
-  hash[77] = (tmp[19] >> 16) & 0xff;
-  hash[78] = (tmp[19] >> 8) & 0xff;
-  hash[79] = (tmp[19] >> 0) & 0xff;
-  hash[80] = (tmp[20] >> 24) & 0xff;
-  hash[81] = (tmp[20] >> 16) & 0xff;
-  hash[82] = (tmp[20] >> 8) & 0xff;
-  hash[83] = (tmp[20] >> 0) & 0xff;
-  hash[84] = (tmp[21] >> 24) & 0xff;
-  hash[85] = (tmp[21] >> 16) & 0xff;
-  hash[86] = (tmp[21] >> 8) & 0xff;
-  hash[87] = (tmp[21] >> 0) & 0xff;
-  hash[88] = (tmp[22] >> 24) & 0xff;
-  hash[89] = (tmp[22] >> 16) & 0xff;
-  hash[90] = (tmp[22] >> 8) & 0xff;
-  hash[91] = (tmp[22] >> 0) & 0xff;
-  hash[92] = (tmp[23] >> 24) & 0xff;
-  hash[93] = (tmp[23] >> 16) & 0xff;
-  hash[94] = (tmp[23] >> 8) & 0xff;
-  hash[95] = (tmp[23] >> 0) & 0xff;
-
-  hash[96] = (tmp[24] >> 24) & 0xff;
-  hash[97] = (tmp[24] >> 16) & 0xff;
-  hash[98] = (tmp[24] >> 8) & 0xff;
-  hash[99] = (tmp[24] >> 0) & 0xff;
-  hash[100] = (tmp[25] >> 24) & 0xff;
-  hash[101] = (tmp[25] >> 16) & 0xff;
-  hash[102] = (tmp[25] >> 8) & 0xff;
-  hash[103] = (tmp[25] >> 0) & 0xff;
-  hash[104] = (tmp[26] >> 24) & 0xff;
-  hash[105] = (tmp[26] >> 16) & 0xff;
-  hash[106] = (tmp[26] >> 8) & 0xff;
-  hash[107] = (tmp[26] >> 0) & 0xff;
-  hash[108] = (tmp[27] >> 24) & 0xff;
-  hash[109] = (tmp[27] >> 16) & 0xff;
-  hash[110] = (tmp[27] >> 8) & 0xff;
-  hash[111] = (tmp[27] >> 0) & 0xff;
-  hash[112] = (tmp[28] >> 24) & 0xff;
-  hash[113] = (tmp[28] >> 16) & 0xff;
-  hash[114] = (tmp[28] >> 8) & 0xff;
-  hash[115] = (tmp[28] >> 0) & 0xff;
-  hash[116] = (tmp[29] >> 24) & 0xff;
-  hash[117] = (tmp[29] >> 16) & 0xff;
-  hash[118] = (tmp[29] >> 8) & 0xff;
-  hash[119] = (tmp[29] >> 0) & 0xff;
-  hash[120] = (tmp[30] >> 24) & 0xff;
-  hash[121] = (tmp[30] >> 16) & 0xff;
-  hash[122] = (tmp[30] >> 8) & 0xff;
-  hash[123] = (tmp[30] >> 0) & 0xff;
-  hash[124] = (tmp[31] >> 24) & 0xff;
-  hash[125] = (tmp[31] >> 16) & 0xff;
-  hash[126] = (tmp[31] >> 8) & 0xff;
-  hash[127] = (tmp[31] >> 0) & 0xff;
+  memcpy (state, tmp, sizeof (tmp));
+}
+#endif
+
+void
+snippets_fnv1_1024 (const uint8_t * data, size_t len, uint8_t hash[128])
+{
+  uint64_t tmp[32];
+
+  memcpy (tmp, FNV_offset_1024, sizeof (tmp));
+  fnv1_1024_update (tmp, data, len);
+  fnv_final (tmp, 1024, hash);
+}
+
+void
+snippets_fnv1_1024_words (const uint8_t * data, size_t len, uint32_t hash[32])
+{
+  uint64_t tmp[32];
+
+  memcpy (tmp, FNV_offset_1024, sizeof (tmp));
+  fnv1_1024_update (tmp, data, len);
+  fnv_final_words (tmp, 1024, hash);
+}
+
+void
+snippets_fnv1_1024_iov (const struct iovec *iov, int n, uint8_t hash[128])
+{
+  uint64_t tmp[32];
+
+  memcpy (tmp, FNV_offset_1024, sizeof (tmp));
+  fnv_update_iov (fnv1_1024_update, tmp, iov, n);
+  fnv_final (tmp, 1024, hash);
+}
+
+void
+snippets_fnv1a_1024 (const uint8_t * data, size_t len, uint8_t hash[128])
+{
+  uint64_t tmp[32];
+
+  memcpy (tmp, FNV_offset_1024, sizeof (tmp));
+  fnv1a_1024_update (tmp, data, len);
+  fnv_final (tmp, 1024, hash);
+}
+
+void
+snippets_fnv1a_1024_words (const uint8_t * data, size_t len, uint32_t hash[32])
+{
+  uint64_t tmp[32];
+
+  memcpy (tmp, FNV_offset_1024, sizeof (tmp));
+  fnv1a_1024_update (tmp, data, len);
+  fnv_final_words (tmp, 1024, hash);
+}
+
+void
+snippets_fnv1a_1024_iov (const struct iovec *iov, int n, uint8_t hash[128])
+{
+  uint64_t tmp[32];
+
+  memcpy (tmp, FNV_offset_1024, sizeof (tmp));
+  fnv_update_iov (fnv1a_1024_update, tmp, iov, n);
+  fnv_final (tmp, 1024, hash);
+}
+
+/* The hash value is stored in 32 bit fields, highest 32 bit first,
+ * except for the 32 and 64 bit variants which only use tmp[0] */
+void
+_snippets_fnv1a_iov_words (unsigned int width, const uint64_t * seed,
+    const struct iovec *iov, int n, uint32_t * hash)
+{
+  void (*update) (uint64_t * state, const uint8_t * data, size_t len);
+  uint64_t tmp[32];
+
+  switch (width) {
+    case 64:
+      tmp[0] = FNV_offset_64;
+      update = fnv1a_64_update;
+      break;
+    case 128:
+      memcpy (tmp, FNV_offset_128, sizeof (FNV_offset_128));
+      update = fnv1a_128_update;
+      break;
+    case 256:
+      memcpy (tmp, FNV_offset_256, sizeof (FNV_offset_256));
+      update = fnv1a_256_update;
+      break;
+    case 512:
+      memcpy (tmp, FNV_offset_512, sizeof (FNV_offset_512));
+      update = fnv1a_512_update;
+      break;
+    case 1024:
+      memcpy (tmp, FNV_offset_1024, sizeof (FNV_offset_1024));
+      update = fnv1a_1024_update;
+      break;
+    default:
+      assert (0 && "Unsupported FNV width");
+      return;
+  }
+
+  if (seed)
+    fnv_seed (tmp, width, seed);
+  fnv_update_iov (update, tmp, iov, n);
+  if (seed)
+    fnv_seed_final (tmp, width, seed, tmp);
+
+  if (width == 64) {
+    hash[0] = tmp[0] >> 32;
+    hash[1] = tmp[0] & 0xffffffff;
+  } else {
+    fnv_final_words (tmp, width, hash);
+  }
+}
+
+struct _SnippetsFnvState
+{
+  SnippetsFnvVariant variant;
+  unsigned int width;
+
+  void (*update) (uint64_t * state, const uint8_t * data, size_t len);
+  uint64_t tmp[32];
+
+  int seeded;
+  uint64_t seed[2];
+};
+
+SnippetsFnvState *
+snippets_fnv_state_new (SnippetsFnvVariant variant, unsigned int width)
+{
+  SnippetsFnvState *state;
+
+  assert (variant == SNIPPETS_FNV_VARIANT_1
+      || variant == SNIPPETS_FNV_VARIANT_1A);
+
+  state = calloc (sizeof (SnippetsFnvState), 1);
+  state->variant = variant;
+  state->width = width;
+
+  switch (width) {
+    case 32:
+      state->update = (variant == SNIPPETS_FNV_VARIANT_1) ?
+          fnv1_32_update : fnv1a_32_update;
+      break;
+    case 64:
+      state->update = (variant == SNIPPETS_FNV_VARIANT_1) ?
+          fnv1_64_update : fnv1a_64_update;
+      break;
+    case 128:
+      state->update = (variant == SNIPPETS_FNV_VARIANT_1) ?
+          fnv1_128_update : fnv1a_128_update;
+      break;
+    case 256:
+      state->update = (variant == SNIPPETS_FNV_VARIANT_1) ?
+          fnv1_256_update : fnv1a_256_update;
+      break;
+    case 512:
+      state->update = (variant == SNIPPETS_FNV_VARIANT_1) ?
+          fnv1_512_update : fnv1a_512_update;
+      break;
+    case 1024:
+      state->update = (variant == SNIPPETS_FNV_VARIANT_1) ?
+          fnv1_1024_update : fnv1a_1024_update;
+      break;
+    default:
+      assert (0 && "Unsupported FNV width");
+      free (state);
+      return NULL;
+  }
+
+  snippets_fnv_state_init (state);
+
+  return state;
+}
+
+SnippetsFnvState *
+snippets_fnv_state_new_seeded (SnippetsFnvVariant variant, unsigned int width,
+    const uint64_t seed[2])
+{
+  SnippetsFnvState *state;
+
+  assert (seed != NULL);
+
+  state = snippets_fnv_state_new (variant, width);
+  if (!state)
+    return NULL;
+
+  state->seeded = TRUE;
+  state->seed[0] = seed[0];
+  state->seed[1] = seed[1];
+  snippets_fnv_state_init (state);
+
+  return state;
+}
+
+void
+snippets_fnv_state_free (SnippetsFnvState * state)
+{
+  assert (state != NULL);
+
+  free (state);
+}
+
+void
+snippets_fnv_state_init (SnippetsFnvState * state)
+{
+  assert (state != NULL);
+
+  switch (state->width) {
+    case 32:
+      state->tmp[0] = FNV_offset_32;
+      break;
+    case 64:
+      state->tmp[0] = FNV_offset_64;
+      break;
+    case 128:
+      memcpy (state->tmp, FNV_offset_128, sizeof (FNV_offset_128));
+      break;
+    case 256:
+      memcpy (state->tmp, FNV_offset_256, sizeof (FNV_offset_256));
+      break;
+    case 512:
+      memcpy (state->tmp, FNV_offset_512, sizeof (FNV_offset_512));
+      break;
+    case 1024:
+      memcpy (state->tmp, FNV_offset_1024, sizeof (FNV_offset_1024));
+      break;
+  }
+
+  if (state->seeded)
+    fnv_seed (state->tmp, state->width, state->seed);
+}
+
+void
+snippets_fnv_state_update (SnippetsFnvState * state, const uint8_t * data,
+    size_t len)
+{
+  assert (state != NULL);
+  assert (data != NULL || len == 0);
+
+  state->update (state->tmp, data, len);
+}
+
+void
+snippets_fnv_state_final (const SnippetsFnvState * state, uint8_t * hash)
+{
+  uint64_t tmp[32];
+
+  assert (state != NULL);
+  assert (hash != NULL);
+
+  if (state->seeded) {
+    fnv_seed_final (state->tmp, state->width, state->seed, tmp);
+    fnv_final (tmp, state->width, hash);
+  } else {
+    fnv_final (state->tmp, state->width, hash);
+  }
+}
+
+SnippetsFnvVariant
+snippets_fnv_state_variant (const SnippetsFnvState * state)
+{
+  assert (state != NULL);
+
+  return state->variant;
+}
+
+unsigned int
+snippets_fnv_state_width (const SnippetsFnvState * state)
+{
+  assert (state != NULL);
+
+  return state->width;
+}
+
+/* FNV tree mode: Every chunk is hashed on its own into the digests
+ * array, which is then hashed together with the total length. Each
+ * thread handles a contiguous range of chunks. */
+typedef struct
+{
+  SnippetsFnvVariant variant;
+  unsigned int width;
+  size_t chunk_size;
+  const uint8_t *data;
+  size_t len;
+  size_t first_chunk, n_chunks;
+  uint8_t *digests;
+} FnvTreeJob;
+
+static void *
+fnv_tree_hash_chunks (void *user_data)
+{
+  FnvTreeJob *job = user_data;
+  SnippetsFnvState *state;
+  size_t i, offset, len;
+
+  state = snippets_fnv_state_new (job->variant, job->width);
+
+  for (i = job->first_chunk; i < job->first_chunk + job->n_chunks; i++) {
+    offset = i * job->chunk_size;
+    len = job->len - offset;
+    if (len > job->chunk_size)
+      len = job->chunk_size;
+
+    snippets_fnv_state_init (state);
+    snippets_fnv_state_update (state, job->data + offset, len);
+    snippets_fnv_state_final (state, job->digests + i * (job->width / 8));
+  }
+
+  snippets_fnv_state_free (state);
+
+  return NULL;
+}
+
+void
+snippets_fnv_tree (SnippetsFnvVariant variant, unsigned int width,
+    size_t chunk_size, unsigned int n_threads, const uint8_t * data,
+    size_t len, uint8_t * hash)
+{
+  SnippetsFnvState *state;
+  FnvTreeJob *jobs;
+  uint8_t *digests;
+  uint8_t len_bytes[8];
+  size_t n_chunks, first_chunk;
+  unsigned int i;
+#ifdef HAVE_PTHREAD
+  pthread_t *threads;
+  int *started;
+#endif
+
+  assert (chunk_size > 0);
+  assert (n_threads > 0);
+  assert (data != NULL || len == 0);
+  assert (hash != NULL);
+
+  n_chunks = len / chunk_size + (len % chunk_size != 0);
+  if (n_threads > n_chunks)
+    n_threads = n_chunks;
+#ifndef HAVE_PTHREAD
+  if (n_threads > 1)
+    n_threads = 1;
+#endif
+
+  digests = malloc (n_chunks * (width / 8) + 1);
+  jobs = calloc (n_threads + 1, sizeof (FnvTreeJob));
+
+  first_chunk = 0;
+  for (i = 0; i < n_threads; i++) {
+    jobs[i].variant = variant;
+    jobs[i].width = width;
+    jobs[i].chunk_size = chunk_size;
+    jobs[i].data = data;
+    jobs[i].len = len;
+    jobs[i].first_chunk = first_chunk;
+    jobs[i].n_chunks = n_chunks / n_threads + (i < n_chunks % n_threads);
+    jobs[i].digests = digests;
+    first_chunk += jobs[i].n_chunks;
+  }
+
+#ifdef HAVE_PTHREAD
+  /* The first range is handled by the calling thread, and if a thread
+   * can't be started its range is handled here too */
+  threads = calloc (n_threads + 1, sizeof (pthread_t));
+  started = calloc (n_threads + 1, sizeof (int));
+
+  for (i = 1; i < n_threads; i++)
+    started[i] =
+        (pthread_create (&threads[i], NULL, fnv_tree_hash_chunks,
+            &jobs[i]) == 0);
+  if (n_threads > 0)
+    fnv_tree_hash_chunks (&jobs[0]);
+  for (i = 1; i < n_threads; i++) {
+    if (started[i])
+      pthread_join (threads[i], NULL);
+    else
+      fnv_tree_hash_chunks (&jobs[i]);
+  }
+
+  free (started);
+  free (threads);
+#else
+  if (n_threads > 0)
+    fnv_tree_hash_chunks (&jobs[0]);
+#endif
+
+  for (i = 0; i < 8; i++)
+    len_bytes[i] = ((uint64_t) len >> (56 - 8 * i)) & 0xff;
+
+  state = snippets_fnv_state_new (variant, width);
+  snippets_fnv_state_update (state, digests, n_chunks * (width / 8));
+  snippets_fnv_state_update (state, len_bytes, 8);
+  snippets_fnv_state_final (state, hash);
+  snippets_fnv_state_free (state);
+
+  free (jobs);
+  free (digests);
+}
+
+/* File hashing: Regular files are mapped into memory and hashed in one
+ * go, with a hint to the kernel to read ahead aggressively. Everything
+ * that can't be mapped is read in large, page aligned blocks. */
+#define FNV_FILE_BLOCK_SIZE (1024 * 1024)
+
+#if defined (HAVE_SYS_MMAN_H) && defined (HAVE_MMAP)
+static int
+fnv_hash_fd_mmap (SnippetsFnvState * state, int fd, size_t size)
+{
+  uint8_t *map;
+
+  map = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
+    return FALSE;
+
+#ifdef HAVE_MADVISE
+  madvise (map, size, MADV_SEQUENTIAL);
+  madvise (map, size, MADV_WILLNEED);
+#endif
+
+  snippets_fnv_state_update (state, map, size);
+
+  munmap (map, size);
+
+  return TRUE;
+}
+#endif
+
+static int
+fnv_hash_fd_read (SnippetsFnvState * state, int fd)
+{
+  uint8_t *buffer;
+  ssize_t n;
+  int ret = TRUE;
+
+#ifdef HAVE_POSIX_MEMALIGN
+  if (posix_memalign ((void **) &buffer, 4096, FNV_FILE_BLOCK_SIZE) != 0)
+    return FALSE;
+#else
+  buffer = malloc (FNV_FILE_BLOCK_SIZE);
+  if (!buffer)
+    return FALSE;
+#endif
+
+  for (;;) {
+    n = read (fd, buffer, FNV_FILE_BLOCK_SIZE);
+    if (n == 0) {
+      break;
+    } else if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      ret = FALSE;
+      break;
+    }
+
+    snippets_fnv_state_update (state, buffer, n);
+  }
+
+  free (buffer);
+
+  return ret;
+}
+
+int
+snippets_fnv_hash_file (const char *path, SnippetsFnvVariant variant,
+    unsigned int width, uint8_t * hash)
+{
+  SnippetsFnvState *state;
+#if defined (HAVE_SYS_MMAN_H) && defined (HAVE_MMAP)
+  struct stat st;
+#endif
+  int fd, ret = FALSE;
+
+  assert (path != NULL);
+  assert (hash != NULL);
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return FALSE;
+
+  state = snippets_fnv_state_new (variant, width);
+
+#if defined (HAVE_SYS_MMAN_H) && defined (HAVE_MMAP)
+  if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode) && st.st_size > 0
+      && (uint64_t) st.st_size <= (size_t) - 1)
+    ret = fnv_hash_fd_mmap (state, fd, st.st_size);
+#endif
+
+  /* Not mappable or mmap failed */
+  if (!ret)
+    ret = fnv_hash_fd_read (state, fd);
+
+  if (ret)
+    snippets_fnv_state_final (state, hash);
+
+  snippets_fnv_state_free (state);
+  close (fd);
+
+  return ret;
 }
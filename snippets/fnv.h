@@ -22,6 +22,8 @@
 
 #include <snippets/utils.h>
 
+#include <sys/uio.h>
+
 SNIPPETS_BEGIN_DECLS
 
 /** fnv1_32:
@@ -34,6 +36,25 @@ SNIPPETS_BEGIN_DECLS
  */
 void snippets_fnv1_32 (const uint8_t *data, size_t len, uint8_t hash[4]);
 
+/** fnv1_32_uint32:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *
+ *  Calculates the FNV1 32 bit hash from @data and returns
+ *  it as an integer in host byte order.
+ */
+uint32_t snippets_fnv1_32_uint32 (const uint8_t *data, size_t len);
+
+/** fnv1_32_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *
+ *  Calculates the FNV1 32 bit hash from the concatenation of
+ *  the @n buffers of @iov and returns it as an integer in host
+ *  byte order.
+ */
+uint32_t snippets_fnv1_32_iov (const struct iovec *iov, int n);
+
 /** fnv1a_32:
  *  @data: Data to be hashed
  *  @len: Length of @data in bytes
@@ -42,7 +63,41 @@ void snippets_fnv1_32 (const uint8_t *data, size_t len, uint8_t hash[4]);
  *  Calculates the FNV1A 32 bit hash from @data and puts it
  *  into @hash.
  */
-void snippets_fnv1a_32 (const uint8_t *data, size_t len, uint8_t hash[8]);
+void snippets_fnv1a_32 (const uint8_t *data, size_t len, uint8_t hash[4]);
+
+/** fnv1a_32_uint32:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *
+ *  Calculates the FNV1A 32 bit hash from @data and returns
+ *  it as an integer in host byte order.
+ */
+uint32_t snippets_fnv1a_32_uint32 (const uint8_t *data, size_t len);
+
+/** fnv1a_32_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *
+ *  Calculates the FNV1A 32 bit hash from the concatenation of
+ *  the @n buffers of @iov and returns it as an integer in host
+ *  byte order.
+ */
+uint32_t snippets_fnv1a_32_iov (const struct iovec *iov, int n);
+
+/** fnv1a_32_seeded:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @seed: 128 bit secret seed
+ *
+ *  Calculates a seeded FNV1A 32 bit hash from @data and returns
+ *  it as an integer in host byte order.
+ *
+ *  The seed is mixed into the offset basis and the finalization of the
+ *  hash, which makes it hard to construct colliding keys for hash
+ *  indexed structures without knowing the seed. This is a mitigation
+ *  against collision floods, not a cryptographic guarantee.
+ */
+uint32_t snippets_fnv1a_32_seeded (const uint8_t *data, size_t len, const uint64_t seed[2]);
 
 /** fnv1_64:
  *  @data: Data to be hashed
@@ -52,7 +107,26 @@ void snippets_fnv1a_32 (const uint8_t *data, size_t len, uint8_t hash[8]);
  *  Calculates the FNV1 64 bit hash from @data and puts it
  *  into @hash.
  */
-void snippets_fnv1_64 (const uint8_t *data, size_t len, uint8_t hash[4]);
+void snippets_fnv1_64 (const uint8_t *data, size_t len, uint8_t hash[8]);
+
+/** fnv1_64_uint64:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *
+ *  Calculates the FNV1 64 bit hash from @data and returns
+ *  it as an integer in host byte order.
+ */
+uint64_t snippets_fnv1_64_uint64 (const uint8_t *data, size_t len);
+
+/** fnv1_64_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *
+ *  Calculates the FNV1 64 bit hash from the concatenation of
+ *  the @n buffers of @iov and returns it as an integer in host
+ *  byte order.
+ */
+uint64_t snippets_fnv1_64_iov (const struct iovec *iov, int n);
 
 /** fnv1a_64:
  *  @data: Data to be hashed
@@ -64,6 +138,35 @@ void snippets_fnv1_64 (const uint8_t *data, size_t len, uint8_t hash[4]);
  */
 void snippets_fnv1a_64 (const uint8_t *data, size_t len, uint8_t hash[8]);
 
+/** fnv1a_64_uint64:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *
+ *  Calculates the FNV1A 64 bit hash from @data and returns
+ *  it as an integer in host byte order.
+ */
+uint64_t snippets_fnv1a_64_uint64 (const uint8_t *data, size_t len);
+
+/** fnv1a_64_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *
+ *  Calculates the FNV1A 64 bit hash from the concatenation of
+ *  the @n buffers of @iov and returns it as an integer in host
+ *  byte order.
+ */
+uint64_t snippets_fnv1a_64_iov (const struct iovec *iov, int n);
+
+/** fnv1a_64_seeded:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @seed: 128 bit secret seed
+ *
+ *  Calculates a seeded FNV1A 64 bit hash from @data and returns
+ *  it as an integer in host byte order. See snippets_fnv1a_32_seeded().
+ */
+uint64_t snippets_fnv1a_64_seeded (const uint8_t *data, size_t len, const uint64_t seed[2]);
+
 /** fnv1_128:
  *  @data: Data to be hashed
  *  @len: Length of @data in bytes
@@ -74,6 +177,27 @@ void snippets_fnv1a_64 (const uint8_t *data, size_t len, uint8_t hash[8]);
  */
 void snippets_fnv1_128 (const uint8_t *data, size_t len, uint8_t hash[16]);
 
+/** fnv1_128_words:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @hash: Pointer to a 4 word array for the calculated hash
+ *
+ *  Calculates the FNV1 128 bit hash from @data and puts it
+ *  into @hash as 32 bit integers in host byte order, highest
+ *  word first.
+ */
+void snippets_fnv1_128_words (const uint8_t *data, size_t len, uint32_t hash[4]);
+
+/** fnv1_128_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *  @hash: Pointer to a 16 byte array for the calculated hash
+ *
+ *  Calculates the FNV1 128 bit hash from the concatenation of
+ *  the @n buffers of @iov and puts it into @hash.
+ */
+void snippets_fnv1_128_iov (const struct iovec *iov, int n, uint8_t hash[16]);
+
 /** fnv1a_128:
  *  @data: Data to be hashed
  *  @len: Length of @data in bytes
@@ -84,6 +208,27 @@ void snippets_fnv1_128 (const uint8_t *data, size_t len, uint8_t hash[16]);
  */
 void snippets_fnv1a_128 (const uint8_t *data, size_t len, uint8_t hash[16]);
 
+/** fnv1a_128_words:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @hash: Pointer to a 4 word array for the calculated hash
+ *
+ *  Calculates the FNV1A 128 bit hash from @data and puts it
+ *  into @hash as 32 bit integers in host byte order, highest
+ *  word first.
+ */
+void snippets_fnv1a_128_words (const uint8_t *data, size_t len, uint32_t hash[4]);
+
+/** fnv1a_128_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *  @hash: Pointer to a 16 byte array for the calculated hash
+ *
+ *  Calculates the FNV1A 128 bit hash from the concatenation of
+ *  the @n buffers of @iov and puts it into @hash.
+ */
+void snippets_fnv1a_128_iov (const struct iovec *iov, int n, uint8_t hash[16]);
+
 /** fnv1_256:
  *  @data: Data to be hashed
  *  @len: Length of @data in bytes
@@ -94,6 +239,27 @@ void snippets_fnv1a_128 (const uint8_t *data, size_t len, uint8_t hash[16]);
  */
 void snippets_fnv1_256 (const uint8_t *data, size_t len, uint8_t hash[32]);
 
+/** fnv1_256_words:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @hash: Pointer to a 8 word array for the calculated hash
+ *
+ *  Calculates the FNV1 256 bit hash from @data and puts it
+ *  into @hash as 32 bit integers in host byte order, highest
+ *  word first.
+ */
+void snippets_fnv1_256_words (const uint8_t *data, size_t len, uint32_t hash[8]);
+
+/** fnv1_256_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *  @hash: Pointer to a 32 byte array for the calculated hash
+ *
+ *  Calculates the FNV1 256 bit hash from the concatenation of
+ *  the @n buffers of @iov and puts it into @hash.
+ */
+void snippets_fnv1_256_iov (const struct iovec *iov, int n, uint8_t hash[32]);
+
 /** fnv1a_256:
  *  @data: Data to be hashed
  *  @len: Length of @data in bytes
@@ -104,6 +270,27 @@ void snippets_fnv1_256 (const uint8_t *data, size_t len, uint8_t hash[32]);
  */
 void snippets_fnv1a_256 (const uint8_t *data, size_t len, uint8_t hash[32]);
 
+/** fnv1a_256_words:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @hash: Pointer to a 8 word array for the calculated hash
+ *
+ *  Calculates the FNV1A 256 bit hash from @data and puts it
+ *  into @hash as 32 bit integers in host byte order, highest
+ *  word first.
+ */
+void snippets_fnv1a_256_words (const uint8_t *data, size_t len, uint32_t hash[8]);
+
+/** fnv1a_256_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *  @hash: Pointer to a 32 byte array for the calculated hash
+ *
+ *  Calculates the FNV1A 256 bit hash from the concatenation of
+ *  the @n buffers of @iov and puts it into @hash.
+ */
+void snippets_fnv1a_256_iov (const struct iovec *iov, int n, uint8_t hash[32]);
+
 /** fnv1_512:
  *  @data: Data to be hashed
  *  @len: Length of @data in bytes
@@ -114,6 +301,27 @@ void snippets_fnv1a_256 (const uint8_t *data, size_t len, uint8_t hash[32]);
  */
 void snippets_fnv1_512 (const uint8_t *data, size_t len, uint8_t hash[64]);
 
+/** fnv1_512_words:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @hash: Pointer to a 16 word array for the calculated hash
+ *
+ *  Calculates the FNV1 512 bit hash from @data and puts it
+ *  into @hash as 32 bit integers in host byte order, highest
+ *  word first.
+ */
+void snippets_fnv1_512_words (const uint8_t *data, size_t len, uint32_t hash[16]);
+
+/** fnv1_512_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *  @hash: Pointer to a 64 byte array for the calculated hash
+ *
+ *  Calculates the FNV1 512 bit hash from the concatenation of
+ *  the @n buffers of @iov and puts it into @hash.
+ */
+void snippets_fnv1_512_iov (const struct iovec *iov, int n, uint8_t hash[64]);
+
 /** fnv1a_512:
  *  @data: Data to be hashed
  *  @len: Length of @data in bytes
@@ -124,6 +332,27 @@ void snippets_fnv1_512 (const uint8_t *data, size_t len, uint8_t hash[64]);
  */
 void snippets_fnv1a_512 (const uint8_t *data, size_t len, uint8_t hash[64]);
 
+/** fnv1a_512_words:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @hash: Pointer to a 16 word array for the calculated hash
+ *
+ *  Calculates the FNV1A 512 bit hash from @data and puts it
+ *  into @hash as 32 bit integers in host byte order, highest
+ *  word first.
+ */
+void snippets_fnv1a_512_words (const uint8_t *data, size_t len, uint32_t hash[16]);
+
+/** fnv1a_512_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *  @hash: Pointer to a 64 byte array for the calculated hash
+ *
+ *  Calculates the FNV1A 512 bit hash from the concatenation of
+ *  the @n buffers of @iov and puts it into @hash.
+ */
+void snippets_fnv1a_512_iov (const struct iovec *iov, int n, uint8_t hash[64]);
+
 /** fnv1_1024:
  *  @data: Data to be hashed
  *  @len: Length of @data in bytes
@@ -134,6 +363,27 @@ void snippets_fnv1a_512 (const uint8_t *data, size_t len, uint8_t hash[64]);
  */
 void snippets_fnv1_1024 (const uint8_t *data, size_t len, uint8_t hash[128]);
 
+/** fnv1_1024_words:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @hash: Pointer to a 32 word array for the calculated hash
+ *
+ *  Calculates the FNV1 1024 bit hash from @data and puts it
+ *  into @hash as 32 bit integers in host byte order, highest
+ *  word first.
+ */
+void snippets_fnv1_1024_words (const uint8_t *data, size_t len, uint32_t hash[32]);
+
+/** fnv1_1024_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *  @hash: Pointer to a 128 byte array for the calculated hash
+ *
+ *  Calculates the FNV1 1024 bit hash from the concatenation of
+ *  the @n buffers of @iov and puts it into @hash.
+ */
+void snippets_fnv1_1024_iov (const struct iovec *iov, int n, uint8_t hash[128]);
+
 /** fnv1a_1024:
  *  @data: Data to be hashed
  *  @len: Length of @data in bytes
@@ -144,6 +394,190 @@ void snippets_fnv1_1024 (const uint8_t *data, size_t len, uint8_t hash[128]);
  */
 void snippets_fnv1a_1024 (const uint8_t *data, size_t len, uint8_t hash[128]);
 
+/** fnv1a_1024_words:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @hash: Pointer to a 32 word array for the calculated hash
+ *
+ *  Calculates the FNV1A 1024 bit hash from @data and puts it
+ *  into @hash as 32 bit integers in host byte order, highest
+ *  word first.
+ */
+void snippets_fnv1a_1024_words (const uint8_t *data, size_t len, uint32_t hash[32]);
+
+/** fnv1a_1024_iov:
+ *  @iov: Buffers to be hashed
+ *  @n: Number of buffers in @iov
+ *  @hash: Pointer to a 128 byte array for the calculated hash
+ *
+ *  Calculates the FNV1A 1024 bit hash from the concatenation of
+ *  the @n buffers of @iov and puts it into @hash.
+ */
+void snippets_fnv1a_1024_iov (const struct iovec *iov, int n, uint8_t hash[128]);
+
+/** fnv1a_32_batch:
+ *  @keys: Array of @n pointers to the data to be hashed
+ *  @lens: Array of the @n lengths of @keys in bytes
+ *  @n: Number of keys
+ *  @out: Array for the @n calculated hashes
+ *
+ *  Calculates the FNV1A 32 bit hashes of @n independent keys.
+ *  @out[i] is the hash of @keys[i] as calculated by snippets_fnv1a_32(),
+ *  as an integer in host byte order.
+ *
+ *  Multiple keys are hashed at once in SIMD registers if possible,
+ *  which is considerably faster for many short keys than hashing
+ *  them one after another.
+ */
+void snippets_fnv1a_32_batch (const uint8_t **keys, const size_t *lens, size_t n, uint32_t *out);
+
+/** fnv1a_64_batch:
+ *  @keys: Array of @n pointers to the data to be hashed
+ *  @lens: Array of the @n lengths of @keys in bytes
+ *  @n: Number of keys
+ *  @out: Array for the @n calculated hashes
+ *
+ *  Calculates the FNV1A 64 bit hashes of @n independent keys.
+ *  @out[i] is the hash of @keys[i] as calculated by snippets_fnv1a_64(),
+ *  as an integer in host byte order.
+ *
+ *  Multiple keys are hashed at once in SIMD registers if possible,
+ *  which is considerably faster for many short keys than hashing
+ *  them one after another.
+ */
+void snippets_fnv1a_64_batch (const uint8_t **keys, const size_t *lens, size_t n, uint64_t *out);
+
+/** SnippetsFnvVariant:
+ *  @SNIPPETS_FNV_VARIANT_1: FNV1, multiply before XOR
+ *  @SNIPPETS_FNV_VARIANT_1A: FNV1A, XOR before multiply
+ *
+ *  The FNV variant used by a #SnippetsFnvState.
+ */
+typedef enum {
+  SNIPPETS_FNV_VARIANT_1,
+  SNIPPETS_FNV_VARIANT_1A
+} SnippetsFnvVariant;
+
+typedef struct _SnippetsFnvState SnippetsFnvState;
+
+/** fnv_state_new:
+ *  @variant: FNV variant
+ *  @width: Hash width in bits, one of 32, 64, 128, 256, 512 or 1024
+ *
+ *  Creates a new, initialized state for calculating the FNV hash of
+ *  data that is not available in a single contiguous buffer.
+ *
+ *  Feeding all data to snippets_fnv_state_update() and then calling
+ *  snippets_fnv_state_final() gives exactly the same hash as the
+ *  corresponding one-shot function over the concatenated data.
+ */
+SnippetsFnvState * snippets_fnv_state_new (SnippetsFnvVariant variant, unsigned int width);
+
+/** fnv_state_new_seeded:
+ *  @variant: FNV variant
+ *  @width: Hash width in bits, one of 32, 64, 128, 256, 512 or 1024
+ *  @seed: 128 bit secret seed
+ *
+ *  Like snippets_fnv_state_new() but the resulting hash is seeded
+ *  with @seed. For the 32 and 64 bit FNV1A variants this gives the same
+ *  hash as snippets_fnv1a_32_seeded() and snippets_fnv1a_64_seeded().
+ *
+ *  The seed is kept over snippets_fnv_state_init().
+ */
+SnippetsFnvState * snippets_fnv_state_new_seeded (SnippetsFnvVariant variant, unsigned int width, const uint64_t seed[2]);
+
+/** fnv_state_free:
+ *  @state: State to free
+ *
+ *  Frees @state.
+ */
+void snippets_fnv_state_free (SnippetsFnvState *state);
+
+/** fnv_state_init:
+ *  @state: State to initialize
+ *
+ *  Resets @state to the FNV offset basis, so it can be reused for
+ *  hashing new data without allocating a new state.
+ */
+void snippets_fnv_state_init (SnippetsFnvState *state);
+
+/** fnv_state_update:
+ *  @state: State to update
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *
+ *  Feeds the next @len bytes of @data into @state.
+ */
+void snippets_fnv_state_update (SnippetsFnvState *state, const uint8_t *data, size_t len);
+
+/** fnv_state_final:
+ *  @state: State to finalize
+ *  @hash: Pointer to a width / 8 byte array for the calculated hash
+ *
+ *  Puts the hash of all data passed to @state since the last
+ *  initialization into @hash. @state is not modified and can
+ *  be updated further afterwards.
+ */
+void snippets_fnv_state_final (const SnippetsFnvState *state, uint8_t *hash);
+
+/** fnv_state_variant:
+ *  @state: State to query
+ *
+ *  Returns the FNV variant that @state was created for.
+ */
+SnippetsFnvVariant snippets_fnv_state_variant (const SnippetsFnvState *state);
+
+/** fnv_state_width:
+ *  @state: State to query
+ *
+ *  Returns the hash width in bits that @state was created for, which
+ *  is the size of the hash written by snippets_fnv_state_final() times 8.
+ */
+unsigned int snippets_fnv_state_width (const SnippetsFnvState *state);
+
+/** fnv_tree:
+ *  @variant: FNV variant to use
+ *  @width: Hash width in bits, 32, 64, 128, 256, 512 or 1024
+ *  @chunk_size: Size of the chunks in bytes
+ *  @n_threads: Number of threads to use
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @hash: Pointer to a @width / 8 byte array for the calculated hash
+ *
+ *  Calculates the FNV-tree hash of @data, which can use multiple
+ *  threads for hashing large amounts of data. This is not the same
+ *  as the plain FNV hash of @data.
+ *
+ *  @data is split into chunks of @chunk_size bytes, with the last
+ *  chunk being shorter if necessary. Each chunk is hashed with the
+ *  selected FNV variant and width. The result is the FNV hash of the
+ *  concatenation of all chunk hashes, followed by @len as 64 bit
+ *  big endian integer.
+ *
+ *  Up to @n_threads chunks are hashed in parallel if threads are
+ *  supported. The result only depends on @chunk_size, never on
+ *  @n_threads.
+ */
+void snippets_fnv_tree (SnippetsFnvVariant variant, unsigned int width, size_t chunk_size, unsigned int n_threads, const uint8_t *data, size_t len, uint8_t *hash);
+
+/** fnv_hash_file:
+ *  @path: Path of the file to be hashed
+ *  @variant: FNV variant to use
+ *  @width: Hash width in bits, 32, 64, 128, 256, 512 or 1024
+ *  @hash: Pointer to a @width / 8 byte array for the calculated hash
+ *
+ *  Calculates the FNV hash of the complete content of the file at
+ *  @path and puts it into @hash. The result is the same as hashing
+ *  the content with the one-shot functions.
+ *
+ *  Regular files are memory mapped if possible, everything else
+ *  like pipes is read in large blocks.
+ *
+ *  Returns %TRUE on success or %FALSE if the file could not be
+ *  opened or read.
+ */
+int snippets_fnv_hash_file (const char *path, SnippetsFnvVariant variant, unsigned int width, uint8_t *hash);
+
 SNIPPETS_END_DECLS
 
 #endif /* __SNIPPETS_FNV_H__ */
@@ -0,0 +1,219 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Polynomials over GF(2) for jumping ahead in the linear engines,
+ * see "Efficient Jump Ahead for F2-Linear Random Number Generators"
+ * by Hiroshi Haramoto, Makoto Matsumoto, Takuji Nishimura, François
+ * Panneton and Pierre L'Ecuyer.
+ *
+ * Polynomials are arrays of 64 bit words, bit i being the coefficient
+ * of x^i. The characteristic polynomial of an engine is calculated
+ * with the Berlekamp-Massey algorithm from a bit sequence it generates,
+ * x^(2^k) is then calculated modulo it by repeated squaring. Jumping
+ * ahead 2^k steps is the sum of the states after i steps for every
+ * coefficient i that is set in the result.
+ */
+
+#define GF2_WORDS(bits) (((bits) + 63) / 64)
+
+typedef struct
+{
+  /* Degree of the monic polynomial */
+  unsigned int degree;
+  /* Exponents of the terms below x^degree */
+  unsigned int *terms;
+  unsigned int n_terms;
+} Gf2Poly;
+
+static inline int
+gf2_get (const uint64_t * p, size_t i)
+{
+  return (p[i / 64] >> (i % 64)) & 1;
+}
+
+/* Returns 64 bits starting at bit @i, a word after them must exist */
+static inline uint64_t
+gf2_get64 (const uint64_t * p, size_t i)
+{
+  size_t w = i / 64;
+  unsigned int s = i % 64;
+
+  return s ? (p[w] >> s) | (p[w + 1] << (64 - s)) : p[w];
+}
+
+/* XORs the lower @n bits of @v into @p starting at bit @i */
+static inline void
+gf2_xor64 (uint64_t * p, size_t i, uint64_t v, unsigned int n)
+{
+  size_t w = i / 64;
+  unsigned int s = i % 64;
+
+  if (n < 64)
+    v &= (((uint64_t) 1) << n) - 1;
+  p[w] ^= v << s;
+  if (s && s + n > 64)
+    p[w + 1] ^= v >> (64 - s);
+}
+
+static inline unsigned int
+gf2_parity (uint64_t v)
+{
+  v ^= v >> 32;
+  v ^= v >> 16;
+  v ^= v >> 8;
+  v ^= v >> 4;
+  v ^= v >> 2;
+  v ^= v >> 1;
+
+  return v & 1;
+}
+
+/* Calculates the minimal polynomial of the @len bits of @seq and
+ * multiplies it with x^@shift. @len has to be at least twice the
+ * degree of the polynomial */
+static void
+gf2_poly_from_sequence (Gf2Poly * poly, const uint64_t * seq, size_t len,
+    unsigned int shift)
+{
+  size_t words = GF2_WORDS (len) + 2;
+  uint64_t *rev, *c, *b, *t;
+  unsigned int l = 0, lb = 0, m = 1;
+  size_t n, i, w;
+  uint64_t acc;
+
+  rev = calloc (words, sizeof (uint64_t));
+  c = calloc (words, sizeof (uint64_t));
+  b = calloc (words, sizeof (uint64_t));
+  t = calloc (words, sizeof (uint64_t));
+
+  /* Reversed sequence, so that the discrepancy is a word-wise
+   * dot product with the connection polynomial */
+  for (i = 0; i < len; i++) {
+    if (gf2_get (seq, i))
+      gf2_xor64 (rev, len - 1 - i, 1, 1);
+  }
+
+  c[0] = b[0] = 1;
+  for (n = 0; n < len; n++) {
+    acc = 0;
+    for (w = 0; w <= l / 64; w++)
+      acc ^= c[w] & gf2_get64 (rev, len - 1 - n + 64 * w);
+
+    if (!gf2_parity (acc)) {
+      m++;
+    } else if (2 * l <= n) {
+      memcpy (t, c, words * sizeof (uint64_t));
+      for (w = 0; w <= lb / 64; w++)
+        gf2_xor64 (c, 64 * w + m, b[w], 64);
+      lb = l;
+      l = n + 1 - l;
+      memcpy (b, t, words * sizeof (uint64_t));
+      m = 1;
+    } else {
+      for (w = 0; w <= lb / 64; w++)
+        gf2_xor64 (c, 64 * w + m, b[w], 64);
+      m++;
+    }
+  }
+
+  /* The characteristic polynomial is the reciprocal of the connection
+   * polynomial, x^l is the leading term */
+  poly->degree = l + shift;
+  poly->terms = malloc (l * sizeof (unsigned int));
+  poly->n_terms = 0;
+  for (i = 1; i <= l; i++) {
+    if (gf2_get (c, i))
+      poly->terms[poly->n_terms++] = l - i + shift;
+  }
+
+  free (rev);
+  free (c);
+  free (b);
+  free (t);
+}
+
+/* Spreads the 32 bits of @x to the even bits of the result */
+static inline uint64_t
+gf2_spread (uint64_t x)
+{
+  x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+  x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+  x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  x = (x | (x << 2)) & 0x3333333333333333ULL;
+  x = (x | (x << 1)) & 0x5555555555555555ULL;
+
+  return x;
+}
+
+/* Calculates x^(2^@k) modulo @poly into @q, which has
+ * GF2_WORDS (@poly->degree) words */
+static void
+gf2_poly_pow2_mod (const Gf2Poly * poly, unsigned int k, uint64_t * q)
+{
+  unsigned int d = poly->degree, gap, max_term = 0;
+  size_t qwords = GF2_WORDS (d), words = GF2_WORDS (2 * d) + 2;
+  uint64_t *tmp, chunk;
+  size_t i, top, lo, w;
+  unsigned int j, n;
+
+  for (j = 0; j < poly->n_terms; j++) {
+    if (poly->terms[j] > max_term)
+      max_term = poly->terms[j];
+  }
+  /* Reducing up to gap bits at once never sets bits at or above the
+   * ones that are reduced */
+  gap = d - max_term;
+  if (gap > 64)
+    gap = 64;
+
+  tmp = malloc (words * sizeof (uint64_t));
+
+  /* x modulo the polynomial, all engines have a degree above 1 */
+  assert (d > 1);
+  memset (q, 0, qwords * sizeof (uint64_t));
+  q[0] = 2;
+
+  for (i = 0; i < k; i++) {
+    memset (tmp, 0, words * sizeof (uint64_t));
+    for (w = 0; w < qwords; w++) {
+      tmp[2 * w] = gf2_spread (q[w] & 0xffffffff);
+      tmp[2 * w + 1] = gf2_spread (q[w] >> 32);
+    }
+
+    for (top = 2 * d - 2; top >= d;) {
+      n = top - d + 1 < gap ? top - d + 1 : gap;
+      lo = top - n + 1;
+      chunk = gf2_get64 (tmp, lo);
+      if (n < 64)
+        chunk &= (((uint64_t) 1) << n) - 1;
+      if (chunk) {
+        gf2_xor64 (tmp, lo, chunk, n);
+        for (j = 0; j < poly->n_terms; j++)
+          gf2_xor64 (tmp, lo - d + poly->terms[j], chunk, n);
+      }
+      top = lo - 1;
+    }
+
+    memcpy (q, tmp, qwords * sizeof (uint64_t));
+    if (d % 64)
+      q[qwords - 1] &= (((uint64_t) 1) << (d % 64)) - 1;
+  }
+
+  free (tmp);
+}
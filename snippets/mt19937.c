@@ -42,18 +42,254 @@
 */
 
 /* Period parameters */
+#define N 624
 #define M 397
 #define MATRIX_A 0x9908b0dfUL   /* constant vector a */
 #define UPPER_MASK 0x80000000UL /* most significant w-r bits */
 #define LOWER_MASK 0x7fffffffUL /* least significant r bits */
 
-/* initializes mt[N] with a seed */
+typedef struct
+{
+  uint32_t mt[N];
+  unsigned int mti;
+
+  /* Tempered output of the current state */
+  uint32_t out[N];
+
+  void (*generate) (uint32_t * mt, uint32_t * out);
+} MT19937State;
+
+/* Tempering of a single word */
+static inline uint32_t
+mt19937_temper (uint32_t y)
+{
+  y ^= (y >> 11);
+  y ^= (y << 7) & 0x9d2c5680UL;
+  y ^= (y << 15) & 0xefc60000UL;
+  y ^= (y >> 18);
+
+  return y;
+}
+
+/* Regenerates mt[N] and puts the tempered words into out[N] */
+static void
+mt19937_generate_scalar (uint32_t * mt, uint32_t * out)
+{
+  static const uint32_t mag01[2] = { 0x0UL, MATRIX_A };
+  uint32_t y;
+  int kk;
+
+  /* mag01[x] = x * MATRIX_A  for x=0,1 */
+
+  for (kk = 0; kk < N - M; kk++) {
+    y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
+    mt[kk] = mt[kk + M] ^ (y >> 1) ^ mag01[y & 0x1UL];
+  }
+  for (; kk < N - 1; kk++) {
+    y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
+    mt[kk] = mt[kk + (M - N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
+  }
+  y = (mt[N - 1] & UPPER_MASK) | (mt[0] & LOWER_MASK);
+  mt[N - 1] = mt[M - 1] ^ (y >> 1) ^ mag01[y & 0x1UL];
+
+  for (kk = 0; kk < N; kk++)
+    out[kk] = mt19937_temper (mt[kk]);
+}
+
+#ifdef HAVE_X86_SIMD_DISPATCH
+/* Vectorized regeneration of the state. Every word only depends on the
+ * old values of the next word and of the word M ahead, or on the new
+ * value of the word N - M back, so blocks of up to N - M words can be
+ * calculated at once. The blocks don't cross the N - M boundary, the
+ * words before it and the last word are calculated one by one.
+ *
+ * Afterwards the whole block is tempered at once, N is a multiple of
+ * all vector sizes. */
+static inline void
+mt19937_generate_one (uint32_t * mt, int kk)
+{
+  uint32_t y;
+
+  y = (mt[kk] & UPPER_MASK) | (mt[(kk + 1) % N] & LOWER_MASK);
+  mt[kk] = mt[(kk + M) % N] ^ (y >> 1) ^ ((0 - (y & 0x1UL)) & MATRIX_A);
+}
+
+static SNIPPETS_TARGET_SSE42 void
+mt19937_generate_sse42 (uint32_t * mt, uint32_t * out)
+{
+  const __m128i upper = _mm_set1_epi32 (UPPER_MASK);
+  const __m128i lower = _mm_set1_epi32 (LOWER_MASK);
+  const __m128i matrix = _mm_set1_epi32 (MATRIX_A);
+  const __m128i one = _mm_set1_epi32 (1);
+  const __m128i temper_b = _mm_set1_epi32 (0x9d2c5680UL);
+  const __m128i temper_c = _mm_set1_epi32 (0xefc60000UL);
+  __m128i y, mag;
+  int kk;
+
+  for (kk = 0; kk + 4 <= N - M; kk += 4) {
+    y = _mm_or_si128 (_mm_and_si128 (_mm_loadu_si128 ((__m128i *) & mt[kk]),
+            upper), _mm_and_si128 (_mm_loadu_si128 ((__m128i *) & mt[kk + 1]),
+            lower));
+    mag = _mm_and_si128 (_mm_cmpeq_epi32 (_mm_and_si128 (y, one), one), matrix);
+    _mm_storeu_si128 ((__m128i *) & mt[kk],
+        _mm_xor_si128 (_mm_xor_si128 (_mm_loadu_si128 ((__m128i *) & mt[kk +
+                        M]), _mm_srli_epi32 (y, 1)), mag));
+  }
+  for (; kk < N - M; kk++)
+    mt19937_generate_one (mt, kk);
+  for (; kk + 4 <= N - 1; kk += 4) {
+    y = _mm_or_si128 (_mm_and_si128 (_mm_loadu_si128 ((__m128i *) & mt[kk]),
+            upper), _mm_and_si128 (_mm_loadu_si128 ((__m128i *) & mt[kk + 1]),
+            lower));
+    mag = _mm_and_si128 (_mm_cmpeq_epi32 (_mm_and_si128 (y, one), one), matrix);
+    _mm_storeu_si128 ((__m128i *) & mt[kk],
+        _mm_xor_si128 (_mm_xor_si128 (_mm_loadu_si128 ((__m128i *) & mt[kk +
+                        (M - N)]), _mm_srli_epi32 (y, 1)), mag));
+  }
+  for (; kk < N; kk++)
+    mt19937_generate_one (mt, kk);
+
+  for (kk = 0; kk < N; kk += 4) {
+    y = _mm_loadu_si128 ((__m128i *) & mt[kk]);
+    y = _mm_xor_si128 (y, _mm_srli_epi32 (y, 11));
+    y = _mm_xor_si128 (y, _mm_and_si128 (_mm_slli_epi32 (y, 7), temper_b));
+    y = _mm_xor_si128 (y, _mm_and_si128 (_mm_slli_epi32 (y, 15), temper_c));
+    y = _mm_xor_si128 (y, _mm_srli_epi32 (y, 18));
+    _mm_storeu_si128 ((__m128i *) & out[kk], y);
+  }
+}
+
+static SNIPPETS_TARGET_AVX2 void
+mt19937_generate_avx2 (uint32_t * mt, uint32_t * out)
+{
+  const __m256i upper = _mm256_set1_epi32 (UPPER_MASK);
+  const __m256i lower = _mm256_set1_epi32 (LOWER_MASK);
+  const __m256i matrix = _mm256_set1_epi32 (MATRIX_A);
+  const __m256i one = _mm256_set1_epi32 (1);
+  const __m256i temper_b = _mm256_set1_epi32 (0x9d2c5680UL);
+  const __m256i temper_c = _mm256_set1_epi32 (0xefc60000UL);
+  __m256i y, mag;
+  int kk;
+
+  for (kk = 0; kk + 8 <= N - M; kk += 8) {
+    y = _mm256_or_si256 (_mm256_and_si256 (_mm256_loadu_si256 ((__m256i *) &
+                mt[kk]), upper),
+        _mm256_and_si256 (_mm256_loadu_si256 ((__m256i *) & mt[kk + 1]),
+            lower));
+    mag = _mm256_and_si256 (_mm256_cmpeq_epi32 (_mm256_and_si256 (y, one),
+            one), matrix);
+    _mm256_storeu_si256 ((__m256i *) & mt[kk],
+        _mm256_xor_si256 (_mm256_xor_si256 (_mm256_loadu_si256 ((__m256i *) &
+                    mt[kk + M]), _mm256_srli_epi32 (y, 1)), mag));
+  }
+  for (; kk < N - M; kk++)
+    mt19937_generate_one (mt, kk);
+  for (; kk + 8 <= N - 1; kk += 8) {
+    y = _mm256_or_si256 (_mm256_and_si256 (_mm256_loadu_si256 ((__m256i *) &
+                mt[kk]), upper),
+        _mm256_and_si256 (_mm256_loadu_si256 ((__m256i *) & mt[kk + 1]),
+            lower));
+    mag = _mm256_and_si256 (_mm256_cmpeq_epi32 (_mm256_and_si256 (y, one),
+            one), matrix);
+    _mm256_storeu_si256 ((__m256i *) & mt[kk],
+        _mm256_xor_si256 (_mm256_xor_si256 (_mm256_loadu_si256 ((__m256i *) &
+                    mt[kk + (M - N)]), _mm256_srli_epi32 (y, 1)), mag));
+  }
+  for (; kk < N; kk++)
+    mt19937_generate_one (mt, kk);
+
+  for (kk = 0; kk < N; kk += 8) {
+    y = _mm256_loadu_si256 ((__m256i *) & mt[kk]);
+    y = _mm256_xor_si256 (y, _mm256_srli_epi32 (y, 11));
+    y = _mm256_xor_si256 (y, _mm256_and_si256 (_mm256_slli_epi32 (y, 7),
+            temper_b));
+    y = _mm256_xor_si256 (y, _mm256_and_si256 (_mm256_slli_epi32 (y, 15),
+            temper_c));
+    y = _mm256_xor_si256 (y, _mm256_srli_epi32 (y, 18));
+    _mm256_storeu_si256 ((__m256i *) & out[kk], y);
+  }
+}
+
+/* The zero-masked shifts are used because the unmasked ones trigger
+ * bogus uninitialized warnings with gcc 12 */
+static SNIPPETS_TARGET_AVX512 void
+mt19937_generate_avx512 (uint32_t * mt, uint32_t * out)
+{
+  const __m512i upper = _mm512_set1_epi32 (UPPER_MASK);
+  const __m512i lower = _mm512_set1_epi32 (LOWER_MASK);
+  const __m512i matrix = _mm512_set1_epi32 (MATRIX_A);
+  const __m512i one = _mm512_set1_epi32 (1);
+  const __m512i temper_b = _mm512_set1_epi32 (0x9d2c5680UL);
+  const __m512i temper_c = _mm512_set1_epi32 (0xefc60000UL);
+  __m512i y, mag;
+  int kk;
+
+  for (kk = 0; kk + 16 <= N - M; kk += 16) {
+    y = _mm512_or_si512 (_mm512_and_si512 (_mm512_loadu_si512 (&mt[kk]),
+            upper), _mm512_and_si512 (_mm512_loadu_si512 (&mt[kk + 1]),
+            lower));
+    mag = _mm512_maskz_mov_epi32 (_mm512_test_epi32_mask (y, one), matrix);
+    _mm512_storeu_si512 (&mt[kk],
+        _mm512_xor_si512 (_mm512_xor_si512 (_mm512_loadu_si512 (&mt[kk + M]),
+                _mm512_maskz_srli_epi32 (0xffff, y, 1)), mag));
+  }
+  for (; kk < N - M; kk++)
+    mt19937_generate_one (mt, kk);
+  for (; kk + 16 <= N - 1; kk += 16) {
+    y = _mm512_or_si512 (_mm512_and_si512 (_mm512_loadu_si512 (&mt[kk]),
+            upper), _mm512_and_si512 (_mm512_loadu_si512 (&mt[kk + 1]),
+            lower));
+    mag = _mm512_maskz_mov_epi32 (_mm512_test_epi32_mask (y, one), matrix);
+    _mm512_storeu_si512 (&mt[kk],
+        _mm512_xor_si512 (_mm512_xor_si512 (_mm512_loadu_si512 (&mt[kk + (M -
+                            N)]), _mm512_maskz_srli_epi32 (0xffff, y, 1)), mag));
+  }
+  for (; kk < N; kk++)
+    mt19937_generate_one (mt, kk);
+
+  for (kk = 0; kk < N; kk += 16) {
+    y = _mm512_loadu_si512 (&mt[kk]);
+    y = _mm512_xor_si512 (y, _mm512_maskz_srli_epi32 (0xffff, y, 11));
+    y = _mm512_xor_si512 (y,
+        _mm512_and_si512 (_mm512_maskz_slli_epi32 (0xffff, y, 7), temper_b));
+    y = _mm512_xor_si512 (y,
+        _mm512_and_si512 (_mm512_maskz_slli_epi32 (0xffff, y, 15), temper_c));
+    y = _mm512_xor_si512 (y, _mm512_maskz_srli_epi32 (0xffff, y, 18));
+    _mm512_storeu_si512 (&out[kk], y);
+  }
+}
+#endif
+
+/* Implementations for the different SIMD levels, indexed by
+ * SnippetsCpuLevel */
+static void (*const mt19937_generate_impls[]) (uint32_t * mt, uint32_t * out) = {
+  mt19937_generate_scalar,
+#ifdef HAVE_X86_SIMD_DISPATCH
+  mt19937_generate_sse42,
+  mt19937_generate_avx2,
+  mt19937_generate_avx512,
+#endif
+};
+
 static void
-mt19937_init (SnippetsRand * rand, uint32_t s)
+mt19937_init_generate (MT19937State * state)
 {
-  uint32_t *mt = rand->mt;
+  unsigned int level = _snippets_cpu_level ();
+
+  if (level >= sizeof (mt19937_generate_impls) /
+      sizeof (mt19937_generate_impls[0]))
+    level = 0;
+  state->generate = mt19937_generate_impls[level];
+}
+
+static void
+mt19937_init (MT19937State * state, uint32_t s)
+{
+  uint32_t *mt = state->mt;
   unsigned int mti;
 
+  mt19937_init_generate (state);
+
   mt[0] = s & 0xffffffffUL;
   for (mti = 1; mti < N; mti++) {
     mt[mti] = (1812433253UL * (mt[mti - 1] ^ (mt[mti - 1] >> 30)) + mti);
@@ -64,46 +300,185 @@ mt19937_init (SnippetsRand * rand, uint32_t s)
     mt[mti] &= 0xffffffffUL;
     /* for >32 bit machines */
   }
-  rand->mti = mti;
+  state->mti = mti;
+}
+
+/* initialize by an array with array-length */
+/* init_key is the array for initializing keys */
+/* key_length is its length */
+static void
+mt19937_init_by_array (MT19937State * state, const uint32_t * init_key,
+    size_t key_length)
+{
+  uint32_t *mt = state->mt;
+  size_t i, j, k;
+
+  mt19937_init (state, 19650218UL);
+  i = 1;
+  j = 0;
+  k = (N > key_length ? N : key_length);
+  for (; k; k--) {
+    mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 30)) * 1664525UL))
+        + init_key[j] + j;      /* non linear */
+    mt[i] &= 0xffffffffUL;      /* for WORDSIZE > 32 machines */
+    i++;
+    j++;
+    if (i >= N) {
+      mt[0] = mt[N - 1];
+      i = 1;
+    }
+    if (j >= key_length)
+      j = 0;
+  }
+  for (k = N - 1; k; k--) {
+    mt[i] = (mt[i] ^ ((mt[i - 1] ^ (mt[i - 1] >> 30)) * 1566083941UL))
+        - i;                    /* non linear */
+    mt[i] &= 0xffffffffUL;      /* for WORDSIZE > 32 machines */
+    i++;
+    if (i >= N) {
+      mt[0] = mt[N - 1];
+      i = 1;
+    }
+  }
+
+  mt[0] = 0x80000000UL;         /* MSB is 1; assuring non-zero initial array */
 }
 
 /* generates a random number on [0,0xffffffff]-interval */
 static uint32_t
-mt19937_genrand_uint32 (SnippetsRand * rand)
+mt19937_genrand_uint32 (MT19937State * state)
 {
-  static const uint32_t mag01[2] = { 0x0UL, MATRIX_A };
   uint32_t y;
-  uint32_t *mt = rand->mt;
-  unsigned int mti = rand->mti;
+  uint32_t *mt = state->mt;
+  unsigned int mti = state->mti;
 
-  /* mag01[x] = x * MATRIX_A  for x=0,1 */
+  if (mti >= N) {               /* generate and temper N words at one time */
+    state->generate (mt, state->out);
+
+    mti = 0;
+  }
 
-  if (mti >= N) {               /* generate N words at one time */
-    int kk;
+  y = state->out[mti++];
 
-    for (kk = 0; kk < N - M; kk++) {
-      y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
-      mt[kk] = mt[kk + M] ^ (y >> 1) ^ mag01[y & 0x1UL];
-    }
-    for (; kk < N - 1; kk++) {
-      y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
-      mt[kk] = mt[kk + (M - N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
-    }
-    y = (mt[N - 1] & UPPER_MASK) | (mt[0] & LOWER_MASK);
-    mt[N - 1] = mt[M - 1] ^ (y >> 1) ^ mag01[y & 0x1UL];
+  state->mti = mti;
 
-    mti = 0;
+  return y;
+}
+
+/* Puts the next @n numbers on [0,0xffffffff]-interval into @buf. Full
+ * blocks are generated and tempered directly into @buf */
+static void
+mt19937_fill_uint32 (MT19937State * state, uint32_t * buf, size_t n)
+{
+  size_t m;
+
+  m = N - state->mti;
+  if (m > n)
+    m = n;
+  memcpy (buf, state->out + state->mti, m * sizeof (uint32_t));
+  state->mti += m;
+  buf += m;
+  n -= m;
+
+  while (n >= N) {
+    state->generate (state->mt, buf);
+    buf += N;
+    n -= N;
   }
 
-  y = mt[mti++];
+  if (n > 0) {
+    state->generate (state->mt, state->out);
+    memcpy (buf, state->out, n * sizeof (uint32_t));
+    state->mti = n;
+  }
+}
 
-  /* Tempering */
-  y ^= (y >> 11);
-  y ^= (y << 7) & 0x9d2c5680UL;
-  y ^= (y << 15) & 0xefc60000UL;
-  y ^= (y >> 18);
+/* One step of the recurrence on the last N words in a ring buffer
+ * starting at @p, replaces the oldest word */
+static inline void
+mt19937_step (uint32_t * ring, unsigned int p)
+{
+  unsigned int p1 = p + 1 < N ? p + 1 : 0;
+  unsigned int pm = p + M < N ? p + M : p + M - N;
+  uint32_t y;
+
+  y = (ring[p] & UPPER_MASK) | (ring[p1] & LOWER_MASK);
+  ring[p] = ring[pm] ^ (y >> 1) ^ ((0 - (y & 0x1UL)) & MATRIX_A);
+}
 
-  rand->mti = mti;
+/* Minimal polynomial of the state transition: the characteristic
+ * polynomial of degree 19937, times x because the lower bits of the
+ * oldest word don't influence the next state */
+static Gf2Poly mt19937_poly;
 
-  return y;
+static void
+mt19937_poly_init (void)
+{
+  size_t len = 2 * (N * 32 - 31) + 64, i;
+  MT19937State state;
+  uint64_t *seq;
+  unsigned int p = 0;
+
+  mt19937_init (&state, 5489);
+  seq = calloc (GF2_WORDS (len), sizeof (uint64_t));
+  for (i = 0; i < len; i++) {
+    mt19937_step (state.mt, p);
+    if (state.mt[p] & UPPER_MASK)
+      gf2_xor64 (seq, i, 1, 1);
+    p = p + 1 < N ? p + 1 : 0;
+  }
+
+  gf2_poly_from_sequence (&mt19937_poly, seq, len, 1);
+  assert (mt19937_poly.degree == N * 32 - 31 + 1);
+  free (seq);
+}
+
+/* Returns x^(2^k) modulo the minimal polynomial, to be freed */
+static uint64_t *
+mt19937_jump_poly (unsigned int k)
+{
+#ifdef HAVE_PTHREAD
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  uint64_t *q;
+
+  pthread_once (&once, mt19937_poly_init);
+#else
+  uint64_t *q;
+
+  if (!mt19937_poly.terms)
+    mt19937_poly_init ();
+#endif
+
+  q = malloc (GF2_WORDS (mt19937_poly.degree) * sizeof (uint64_t));
+  gf2_poly_pow2_mod (&mt19937_poly, k, q);
+
+  return q;
+}
+
+/* Advances the state by the steps of the jump polynomial @q. mt[N] are
+ * the last N words of the sequence whatever the position in the
+ * current block is, so the same position in the block is kept */
+static void
+mt19937_jump (MT19937State * state, const uint64_t * q)
+{
+  uint32_t ring[N], result[N];
+  unsigned int i, j, p = 0;
+
+  memcpy (ring, state->mt, sizeof (ring));
+  memset (result, 0, sizeof (result));
+
+  for (i = 0; i < mt19937_poly.degree; i++) {
+    if (gf2_get (q, i)) {
+      for (j = 0; j < N - p; j++)
+        result[j] ^= ring[p + j];
+      for (; j < N; j++)
+        result[j] ^= ring[p + j - N];
+    }
+    mt19937_step (ring, p);
+    p = p + 1 < N ? p + 1 : 0;
+  }
+
+  memcpy (state->mt, result, sizeof (result));
+  for (j = 0; j < N; j++)
+    state->out[j] = mt19937_temper (result[j]);
 }
@@ -0,0 +1,146 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* PCG64 (XSL RR 128/64) by Melissa O'Neill, see
+ *
+ * http://www.pcg-random.org/
+ *
+ * 128 bit LCG state and increment, period 2^128. Uses unsigned
+ * __int128 if available and otherwise calculates the 128 bit
+ * arithmetic with pairs of 64 bit integers.
+ */
+
+#define PCG64_MULT_HIGH 2549297995355413924ULL
+#define PCG64_MULT_LOW 4865540595714422341ULL
+
+typedef struct
+{
+  uint64_t state_high, state_low;
+  uint64_t inc_high, inc_low;
+} Pcg64State;
+
+/* r = a * b + c modulo 2^128 */
+static inline void
+pcg64_muladd (uint64_t a_high, uint64_t a_low, uint64_t b_high,
+    uint64_t b_low, uint64_t c_high, uint64_t c_low, uint64_t * r_high,
+    uint64_t * r_low)
+{
+#ifdef HAVE_UNSIGNED___INT128
+  unsigned __int128 a = ((unsigned __int128) a_high << 64) | a_low;
+  unsigned __int128 b = ((unsigned __int128) b_high << 64) | b_low;
+  unsigned __int128 c = ((unsigned __int128) c_high << 64) | c_low;
+
+  a = a * b + c;
+  *r_high = a >> 64;
+  *r_low = (uint64_t) a;
+#else
+  uint64_t ha = a_low >> 32, hb = b_low >> 32;
+  uint64_t la = (uint32_t) a_low, lb = (uint32_t) b_low;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), carry = t < rl, lo, hi;
+
+  /* Full 64x64 bit product of the low halves, and the low 64 bits of
+   * the cross products */
+  lo = t + (rm1 << 32);
+  carry += lo < t;
+  hi = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+  hi += a_high * b_low + a_low * b_high;
+
+  *r_low = lo + c_low;
+  *r_high = hi + c_high + (*r_low < lo);
+#endif
+}
+
+static inline void
+pcg64_step (Pcg64State * state)
+{
+  pcg64_muladd (state->state_high, state->state_low, PCG64_MULT_HIGH,
+      PCG64_MULT_LOW, state->inc_high, state->inc_low, &state->state_high,
+      &state->state_low);
+}
+
+/* Advances the LCG by 2^k steps in O(k), see "Random Number Generation
+ * with Arbitrary Strides" by Forrest B. Brown. The period is 2^128 */
+static void
+pcg64_jump (Pcg64State * state, unsigned int k)
+{
+  uint64_t mult_high = PCG64_MULT_HIGH, mult_low = PCG64_MULT_LOW;
+  uint64_t plus_high = state->inc_high, plus_low = state->inc_low;
+  unsigned int i;
+
+  if (k >= 128)
+    return;
+
+  /* (mult, plus) of 2^i steps: plus' = (mult + 1) * plus,
+   * mult' = mult * mult */
+  for (i = 0; i < k; i++) {
+    uint64_t m1_high = mult_high + (mult_low + 1 == 0), m1_low = mult_low + 1;
+
+    pcg64_muladd (m1_high, m1_low, plus_high, plus_low, 0, 0, &plus_high,
+        &plus_low);
+    pcg64_muladd (mult_high, mult_low, mult_high, mult_low, 0, 0, &mult_high,
+        &mult_low);
+  }
+
+  pcg64_muladd (state->state_high, state->state_low, mult_high, mult_low,
+      plus_high, plus_low, &state->state_high, &state->state_low);
+}
+
+/* pcg64_srandom_r() with the 128 bit initial state in seed[0..1] and
+ * the 128 bit sequence in seed[2..3] */
+static void
+pcg64_seed (Pcg64State * state, const uint64_t seed[4])
+{
+  uint64_t init_high = seed[0], init_low = seed[1];
+
+  /* The increment must be odd */
+  state->inc_high = (seed[2] << 1) | (seed[3] >> 63);
+  state->inc_low = (seed[3] << 1) | 1;
+
+  state->state_high = state->state_low = 0;
+  pcg64_step (state);
+  state->state_low += init_low;
+  state->state_high += init_high + (state->state_low < init_low);
+  pcg64_step (state);
+}
+
+static void
+pcg64_init (Pcg64State * state, uint64_t seed)
+{
+  uint64_t s[4];
+  int i;
+
+  for (i = 0; i < 4; i++)
+    s[i] = splitmix64_next (&seed);
+
+  pcg64_seed (state, s);
+}
+
+static inline uint64_t
+pcg64_next (Pcg64State * state)
+{
+  uint64_t x, rot;
+
+  pcg64_step (state);
+
+  x = state->state_high ^ state->state_low;
+  rot = state->state_high >> 58;
+
+  return (x >> rot) | (x << ((-rot) & 63));
+}
@@ -0,0 +1,281 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <snippets/philox.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include "cpu.h"
+
+#ifdef HAVE_X86_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+/* Philox4x32-10 counter-based generator by John K. Salmon, Mark A.
+ * Moraes, Ron O. Dror and David E. Shaw, see "Parallel Random Numbers:
+ * As Easy as 1, 2, 3" and the Random123 library.
+ *
+ * Every round multiplies two of the counter words into 64 bit
+ * products and mixes their halves with the other two words and the
+ * key, the key is incremented by the Weyl constants between the
+ * rounds. The SIMD implementations calculate 4 or 8 consecutive
+ * blocks at once with one counter word per vector.
+ */
+
+#define PHILOX_M0 0xd2511f53UL
+#define PHILOX_M1 0xcd9e8d57UL
+#define PHILOX_W0 0x9e3779b9UL
+#define PHILOX_W1 0xbb67ae85UL
+#define PHILOX_ROUNDS 10
+
+static inline void
+philox_block (const uint32_t key[2], const uint32_t counter[4],
+    uint32_t out[4])
+{
+  uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+  uint32_t k0 = key[0], k1 = key[1];
+  uint64_t p0, p1;
+  int r;
+
+  for (r = 0; r < PHILOX_ROUNDS; r++) {
+    p0 = (uint64_t) PHILOX_M0 * c0;
+    p1 = (uint64_t) PHILOX_M1 * c2;
+    c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+    c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+    c1 = (uint32_t) p1;
+    c3 = (uint32_t) p0;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+/* Increments the 128 bit @counter by @n */
+static inline void
+philox_counter_add (uint32_t counter[4], uint32_t n)
+{
+  int i;
+
+  counter[0] += n;
+  if (counter[0] >= n)
+    return;
+  for (i = 1; i < 4 && ++counter[i] == 0; i++);
+}
+
+void
+snippets_philox4x32_10 (const uint32_t key[2], const uint32_t counter[4],
+    uint32_t out[4])
+{
+  assert (key != NULL);
+  assert (counter != NULL);
+  assert (out != NULL);
+
+  philox_block (key, counter, out);
+}
+
+/* Calculates @n_blocks blocks into @out and increments @counter */
+static void
+philox_blocks_scalar (const uint32_t key[2], uint32_t counter[4],
+    uint32_t * out, size_t n_blocks)
+{
+  for (; n_blocks > 0; n_blocks--, out += 4) {
+    philox_block (key, counter, out);
+    philox_counter_add (counter, 1);
+  }
+}
+
+#ifdef HAVE_X86_SIMD_DISPATCH
+/* Batches where the lowest counter word would wrap around are left to
+ * the scalar implementation, so the lanes only differ in that word */
+static SNIPPETS_TARGET_SSE42 void
+philox_blocks_sse42 (const uint32_t key[2], uint32_t counter[4],
+    uint32_t * out, size_t n_blocks)
+{
+  const __m128i m0 = _mm_set1_epi32 (PHILOX_M0);
+  const __m128i m1 = _mm_set1_epi32 (PHILOX_M1);
+  __m128i c0, c1, c2, c3, e, o, hi0, lo0, hi1, lo1, t0, t1, t2, t3;
+  uint32_t k0, k1;
+  int r;
+
+  for (; n_blocks >= 4; n_blocks -= 4, out += 16) {
+    if (counter[0] > 0xffffffffUL - 3) {
+      philox_blocks_scalar (key, counter, out, 4);
+      continue;
+    }
+
+    c0 = _mm_add_epi32 (_mm_set1_epi32 (counter[0]), _mm_setr_epi32 (0, 1, 2,
+            3));
+    c1 = _mm_set1_epi32 (counter[1]);
+    c2 = _mm_set1_epi32 (counter[2]);
+    c3 = _mm_set1_epi32 (counter[3]);
+    k0 = key[0];
+    k1 = key[1];
+
+    for (r = 0; r < PHILOX_ROUNDS; r++) {
+      /* 32x32->64 bit products of the even and the odd lanes */
+      e = _mm_mul_epu32 (c0, m0);
+      o = _mm_mul_epu32 (_mm_srli_epi64 (c0, 32), m0);
+      hi0 = _mm_blend_epi16 (_mm_srli_epi64 (e, 32), o, 0xcc);
+      lo0 = _mm_blend_epi16 (e, _mm_slli_epi64 (o, 32), 0xcc);
+      e = _mm_mul_epu32 (c2, m1);
+      o = _mm_mul_epu32 (_mm_srli_epi64 (c2, 32), m1);
+      hi1 = _mm_blend_epi16 (_mm_srli_epi64 (e, 32), o, 0xcc);
+      lo1 = _mm_blend_epi16 (e, _mm_slli_epi64 (o, 32), 0xcc);
+
+      c0 = _mm_xor_si128 (_mm_xor_si128 (hi1, c1), _mm_set1_epi32 (k0));
+      c2 = _mm_xor_si128 (_mm_xor_si128 (hi0, c3), _mm_set1_epi32 (k1));
+      c1 = lo1;
+      c3 = lo0;
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+    }
+
+    /* One block per lane to consecutive blocks */
+    t0 = _mm_unpacklo_epi32 (c0, c1);
+    t1 = _mm_unpacklo_epi32 (c2, c3);
+    t2 = _mm_unpackhi_epi32 (c0, c1);
+    t3 = _mm_unpackhi_epi32 (c2, c3);
+    _mm_storeu_si128 ((__m128i *) & out[0], _mm_unpacklo_epi64 (t0, t1));
+    _mm_storeu_si128 ((__m128i *) & out[4], _mm_unpackhi_epi64 (t0, t1));
+    _mm_storeu_si128 ((__m128i *) & out[8], _mm_unpacklo_epi64 (t2, t3));
+    _mm_storeu_si128 ((__m128i *) & out[12], _mm_unpackhi_epi64 (t2, t3));
+
+    philox_counter_add (counter, 4);
+  }
+
+  philox_blocks_scalar (key, counter, out, n_blocks);
+}
+
+static SNIPPETS_TARGET_AVX2 void
+philox_blocks_avx2 (const uint32_t key[2], uint32_t counter[4],
+    uint32_t * out, size_t n_blocks)
+{
+  const __m256i m0 = _mm256_set1_epi32 (PHILOX_M0);
+  const __m256i m1 = _mm256_set1_epi32 (PHILOX_M1);
+  __m256i c0, c1, c2, c3, e, o, hi0, lo0, hi1, lo1, t0, t1, t2, t3;
+  uint32_t k0, k1;
+  int r;
+
+  for (; n_blocks >= 8; n_blocks -= 8, out += 32) {
+    if (counter[0] > 0xffffffffUL - 7) {
+      philox_blocks_scalar (key, counter, out, 8);
+      continue;
+    }
+
+    c0 = _mm256_add_epi32 (_mm256_set1_epi32 (counter[0]),
+        _mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7));
+    c1 = _mm256_set1_epi32 (counter[1]);
+    c2 = _mm256_set1_epi32 (counter[2]);
+    c3 = _mm256_set1_epi32 (counter[3]);
+    k0 = key[0];
+    k1 = key[1];
+
+    for (r = 0; r < PHILOX_ROUNDS; r++) {
+      e = _mm256_mul_epu32 (c0, m0);
+      o = _mm256_mul_epu32 (_mm256_srli_epi64 (c0, 32), m0);
+      hi0 = _mm256_blend_epi32 (_mm256_srli_epi64 (e, 32), o, 0xaa);
+      lo0 = _mm256_blend_epi32 (e, _mm256_slli_epi64 (o, 32), 0xaa);
+      e = _mm256_mul_epu32 (c2, m1);
+      o = _mm256_mul_epu32 (_mm256_srli_epi64 (c2, 32), m1);
+      hi1 = _mm256_blend_epi32 (_mm256_srli_epi64 (e, 32), o, 0xaa);
+      lo1 = _mm256_blend_epi32 (e, _mm256_slli_epi64 (o, 32), 0xaa);
+
+      c0 = _mm256_xor_si256 (_mm256_xor_si256 (hi1, c1),
+          _mm256_set1_epi32 (k0));
+      c2 = _mm256_xor_si256 (_mm256_xor_si256 (hi0, c3),
+          _mm256_set1_epi32 (k1));
+      c1 = lo1;
+      c3 = lo0;
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+    }
+
+    /* Transposed per 128 bit lane, which gives blocks 0 and 4, 1 and 5
+     * and so on, then the lanes are combined */
+    t0 = _mm256_unpacklo_epi32 (c0, c1);
+    t1 = _mm256_unpacklo_epi32 (c2, c3);
+    t2 = _mm256_unpackhi_epi32 (c0, c1);
+    t3 = _mm256_unpackhi_epi32 (c2, c3);
+    c0 = _mm256_unpacklo_epi64 (t0, t1);
+    c1 = _mm256_unpackhi_epi64 (t0, t1);
+    c2 = _mm256_unpacklo_epi64 (t2, t3);
+    c3 = _mm256_unpackhi_epi64 (t2, t3);
+    _mm256_storeu_si256 ((__m256i *) & out[0],
+        _mm256_permute2x128_si256 (c0, c1, 0x20));
+    _mm256_storeu_si256 ((__m256i *) & out[8],
+        _mm256_permute2x128_si256 (c2, c3, 0x20));
+    _mm256_storeu_si256 ((__m256i *) & out[16],
+        _mm256_permute2x128_si256 (c0, c1, 0x31));
+    _mm256_storeu_si256 ((__m256i *) & out[24],
+        _mm256_permute2x128_si256 (c2, c3, 0x31));
+
+    philox_counter_add (counter, 8);
+  }
+
+  /* gcc doesn't clear the upper halves before the tail call, which
+   * makes the non-VEX SSE instructions very slow afterwards */
+  _mm256_zeroupper ();
+  philox_blocks_sse42 (key, counter, out, n_blocks);
+}
+#endif
+
+/* Implementations for the different SIMD levels, indexed by
+ * SnippetsCpuLevel. AVX-512 has no advantage over AVX2 here beyond the
+ * vector width and uses the AVX2 implementation */
+static void (*const philox_blocks_impls[]) (const uint32_t key[2],
+    uint32_t counter[4], uint32_t * out, size_t n_blocks) = {
+  philox_blocks_scalar,
+#ifdef HAVE_X86_SIMD_DISPATCH
+  philox_blocks_sse42,
+  philox_blocks_avx2,
+  philox_blocks_avx2,
+#endif
+};
+
+void
+snippets_philox4x32_10_fill (const uint32_t key[2], const uint32_t counter[4],
+    uint32_t * buf, size_t n)
+{
+  unsigned int level = _snippets_cpu_level ();
+  uint32_t ctr[4], last[4];
+
+  assert (key != NULL);
+  assert (counter != NULL);
+  assert (buf != NULL || n == 0);
+
+  if (level >= sizeof (philox_blocks_impls) / sizeof (philox_blocks_impls[0]))
+    level = 0;
+
+  memcpy (ctr, counter, sizeof (ctr));
+  philox_blocks_impls[level] (key, ctr, buf, n / 4);
+
+  if (n % 4) {
+    philox_block (key, ctr, last);
+    memcpy (buf + n - n % 4, last, (n % 4) * sizeof (uint32_t));
+  }
+}
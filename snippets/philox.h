@@ -0,0 +1,53 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SNIPPETS_PHILOX_H__
+#define __SNIPPETS_PHILOX_H__
+
+#include <snippets/utils.h>
+
+SNIPPETS_BEGIN_DECLS
+
+/** snippets_philox4x32_10:
+ *  @key: 64 bit key as two 32 bit words
+ *  @counter: 128 bit counter as four 32 bit words, lowest first
+ *  @out: Four 32 bit words for the random numbers
+ *
+ *  Calculates the Philox4x32-10 block for @counter with @key. The
+ *  result is a pure function of @key and @counter, so every thread can
+ *  calculate any part of the stream without shared state.
+ */
+void snippets_philox4x32_10 (const uint32_t key[2], const uint32_t counter[4], uint32_t out[4]);
+
+/** snippets_philox4x32_10_fill:
+ *  @key: 64 bit key as two 32 bit words
+ *  @counter: 128 bit counter of the first block
+ *  @buf: Buffer for @n words
+ *  @n: Number of 32 bit words
+ *
+ *  Fills @buf with the words of the blocks for @counter, @counter + 1
+ *  and so on, the last block possibly only partially. The counter is
+ *  incremented as a 128 bit number. Multiple blocks are calculated at
+ *  once with SIMD instructions if available.
+ */
+void snippets_philox4x32_10_fill (const uint32_t key[2], const uint32_t counter[4], uint32_t *buf, size_t n);
+
+SNIPPETS_END_DECLS
+
+#endif /* __SNIPPETS_PHILOX_H__ */
@@ -0,0 +1,155 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Philox4x32-10 as a SnippetsRand engine, see philox.c. The seed is
+ * the key and the counter starts at 0. Every block gives two 64 bit
+ * numbers, the first two words and the last two words with the
+ * lower one first, so the engine output is
+ * snippets_philox4x32_10_fill() with that key and counter 0 read as
+ * pairs of words. The period is 2^129 numbers.
+ */
+
+/* Number of blocks calculated at once, 8 for AVX2 */
+#define PHILOX4X32_BUFFER_BLOCKS 8
+#define PHILOX4X32_BUFFER_WORDS (4 * PHILOX4X32_BUFFER_BLOCKS)
+
+typedef struct
+{
+  uint32_t key[2];
+  /* Counter of the first buffered block */
+  uint32_t counter[4];
+  /* Buffered blocks and the next unused word in them */
+  uint32_t out[PHILOX4X32_BUFFER_WORDS];
+  unsigned int index;
+} Philox4x32State;
+
+/* Adds the 128 bit number @high:@low to the 128 bit @counter */
+static inline void
+philox4x32_counter_add (uint32_t counter[4], uint64_t high, uint64_t low)
+{
+  uint64_t l = counter[0] | ((uint64_t) counter[1] << 32);
+  uint64_t h = counter[2] | ((uint64_t) counter[3] << 32);
+
+  l += low;
+  h += high + (l < low);
+  counter[0] = (uint32_t) l;
+  counter[1] = l >> 32;
+  counter[2] = (uint32_t) h;
+  counter[3] = h >> 32;
+}
+
+/* Calculates the buffered blocks starting at the counter */
+static void
+philox4x32_refill (Philox4x32State * state)
+{
+  snippets_philox4x32_10_fill (state->key, state->counter, state->out,
+      PHILOX4X32_BUFFER_WORDS);
+  state->index = 0;
+}
+
+static void
+philox4x32_init (Philox4x32State * state, uint64_t seed)
+{
+  state->key[0] = (uint32_t) seed;
+  state->key[1] = seed >> 32;
+  memset (state->counter, 0, sizeof (state->counter));
+  philox4x32_refill (state);
+}
+
+static inline uint64_t
+philox4x32_next (Philox4x32State * state)
+{
+  uint64_t v;
+
+  if (state->index >= PHILOX4X32_BUFFER_WORDS) {
+    philox4x32_counter_add (state->counter, 0, PHILOX4X32_BUFFER_BLOCKS);
+    philox4x32_refill (state);
+  }
+
+  v = state->out[state->index] | ((uint64_t) state->out[state->index + 1] <<
+      32);
+  state->index += 2;
+
+  return v;
+}
+
+/* Puts the next @n words into @buf, full blocks after the buffered
+ * ones are calculated directly into @buf */
+static void
+philox4x32_fill (Philox4x32State * state, uint32_t * buf, size_t n)
+{
+  size_t n_blocks;
+
+  for (; n > 0 && state->index < PHILOX4X32_BUFFER_WORDS; n--)
+    *buf++ = state->out[state->index++];
+  if (n == 0)
+    return;
+
+  philox4x32_counter_add (state->counter, 0, PHILOX4X32_BUFFER_BLOCKS);
+  n_blocks = n / 4;
+  snippets_philox4x32_10_fill (state->key, state->counter, buf, n_blocks * 4);
+  philox4x32_counter_add (state->counter, 0, n_blocks);
+  buf += n_blocks * 4;
+  n -= n_blocks * 4;
+
+  philox4x32_refill (state);
+  memcpy (buf, state->out, n * sizeof (uint32_t));
+  state->index = n;
+}
+
+/* Counter of the block with the next word and the word in it */
+static void
+philox4x32_get_position (Philox4x32State * state, uint32_t counter[4],
+    unsigned int *index)
+{
+  memcpy (counter, state->counter, 4 * sizeof (uint32_t));
+  philox4x32_counter_add (counter, 0, state->index / 4);
+  *index = state->index % 4;
+}
+
+static void
+philox4x32_set_position (Philox4x32State * state, const uint32_t counter[4],
+    unsigned int index)
+{
+  memcpy (state->counter, counter, sizeof (state->counter));
+  philox4x32_refill (state);
+  state->index = index;
+}
+
+/* Advances by 2^k 64 bit numbers, which is 2^(k-1) blocks */
+static void
+philox4x32_jump (Philox4x32State * state, unsigned int k)
+{
+  uint32_t counter[4];
+  unsigned int index;
+
+  if (k == 0) {
+    philox4x32_next (state);
+    return;
+  }
+  if (k - 1 >= 128)
+    return;
+
+  philox4x32_get_position (state, counter, &index);
+  if (k - 1 < 64)
+    philox4x32_counter_add (counter, 0, ((uint64_t) 1) << (k - 1));
+  else
+    philox4x32_counter_add (counter, ((uint64_t) 1) << (k - 65), 0);
+  philox4x32_set_position (state, counter, index);
+}
@@ -0,0 +1,134 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SNIPPETS_RAND_INLINE_H__
+#define __SNIPPETS_RAND_INLINE_H__
+
+#include <snippets/utils.h>
+
+SNIPPETS_BEGIN_DECLS
+
+/* Inline access to the thread default generator.
+ *
+ * snippets_rand_thread_default() is a xoshiro256** generator. In hot
+ * loops the call and the argument checks of snippets_rand_uint32()
+ * and friends cost more than generating the number. The functions
+ * below work directly on the state returned by
+ * snippets_rand_thread_state() and give the same numbers as the
+ * corresponding snippets_rand_*() functions on
+ * snippets_rand_thread_default(), which can be mixed freely with
+ * them. The state must only be used by the thread that got it.
+ */
+
+/** SnippetsRandThreadState:
+ *
+ *  State of the thread default generator.
+ */
+typedef struct
+{
+  uint64_t s[4];
+} SnippetsRandThreadState;
+
+/** snippets_rand_thread_state:
+ *
+ *  Returns the state of snippets_rand_thread_default() for the calling
+ *  thread. It stays valid until the thread exits.
+ */
+SnippetsRandThreadState * snippets_rand_thread_state (void);
+
+/* See xoshiro256.c */
+#ifdef __GNUC__
+#define SNIPPETS_RAND_INLINE_OPAQUE(x) __asm__ ("" : "+r" (x))
+#else
+#define SNIPPETS_RAND_INLINE_OPAQUE(x) do { } while (0)
+#endif
+
+static inline uint64_t
+snippets_rand_thread_uint64 (SnippetsRandThreadState * state)
+{
+  uint64_t s0 = state->s[0], s1 = state->s[1];
+  uint64_t s2 = state->s[2], s3 = state->s[3];
+  uint64_t result, t;
+
+  SNIPPETS_RAND_INLINE_OPAQUE (s0);
+  SNIPPETS_RAND_INLINE_OPAQUE (s1);
+  SNIPPETS_RAND_INLINE_OPAQUE (s2);
+  SNIPPETS_RAND_INLINE_OPAQUE (s3);
+
+  t = s1 * 5;
+  result = ((t << 7) | (t >> 57)) * 9;
+  t = s1 << 17;
+
+  s2 ^= s0;
+  s3 ^= s1;
+  s1 ^= s2;
+  s0 ^= s3;
+
+  s2 ^= t;
+
+  s3 = (s3 << 45) | (s3 >> 19);
+
+  state->s[0] = s0;
+  state->s[1] = s1;
+  state->s[2] = s2;
+  state->s[3] = s3;
+
+  return result;
+}
+
+static inline uint32_t
+snippets_rand_thread_uint32 (SnippetsRandThreadState * state)
+{
+  return snippets_rand_thread_uint64 (state) >> 32;
+}
+
+/** snippets_rand_thread_uint32_range:
+ *  @state: the thread's state
+ *  @min: lower bound, inclusive
+ *  @max: upper bound, exclusive
+ *
+ *  Like snippets_rand_uint32_range(), without checking that @min is
+ *  not above @max.
+ */
+static inline uint32_t
+snippets_rand_thread_uint32_range (SnippetsRandThreadState * state,
+    uint32_t min, uint32_t max)
+{
+  uint32_t range = max - min, threshold;
+  uint64_t m = (uint64_t) snippets_rand_thread_uint32 (state) * range;
+
+  if ((uint32_t) m < range) {
+    threshold = (0 - range) % range;
+    while ((uint32_t) m < threshold)
+      m = (uint64_t) snippets_rand_thread_uint32 (state) * range;
+  }
+
+  return (m >> 32) + min;
+}
+
+static inline double
+snippets_rand_thread_double (SnippetsRandThreadState * state)
+{
+  return (snippets_rand_thread_uint64 (state) >> 11) *
+      1.1102230246251565404236316680908203125e-16;
+}
+
+SNIPPETS_END_DECLS
+
+#endif /* __SNIPPETS_RAND_INLINE_H__ */
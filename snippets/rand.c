@@ -22,29 +22,137 @@
 #endif
 
 #include <snippets/rand.h>
+#include <snippets/rand-inline.h>
+#include <snippets/philox.h>
 
 #include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
 
-#define N 624
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#if defined (HAVE_GETRANDOM) && defined (HAVE_SYS_RANDOM_H)
+#include <sys/random.h>
+#endif
+
+#include "cpu.h"
+
+#ifdef HAVE_X86_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+#include <stddef.h>
+
+#include "gf2poly.c"
+#include "mt19937.c"
+#include "splitmix64.c"
+#include "xoshiro256.c"
+#include "pcg64.c"
+#include "philox4x32.c"
 
 struct _SnippetsRand
 {
-  uint32_t mt[N];
-  unsigned int mti;
-};
+  SnippetsRandEngine engine;
 
-#include "mt19937.c"
+  /* Only the state of the selected engine is allocated */
+  union
+  {
+    MT19937State mt19937;
+    Xoshiro256State xoshiro256;
+    Pcg64State pcg64;
+    uint64_t splitmix64;
+    Philox4x32State philox4x32;
+  } state;
+};
 
 SnippetsRand *
 snippets_rand_new (uint32_t seed)
 {
-  SnippetsRand *rand = calloc (sizeof (SnippetsRand), 1);
+  return snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_MT19937, seed);
+}
 
-  mt19937_init (rand, seed);
+/* Size of the state of @engine, 0 if it's not supported */
+static size_t
+rand_state_size (SnippetsRandEngine engine)
+{
+  switch (engine) {
+    case SNIPPETS_RAND_ENGINE_MT19937:
+      return sizeof (MT19937State);
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS:
+      return sizeof (Xoshiro256State);
+    case SNIPPETS_RAND_ENGINE_PCG64:
+      return sizeof (Pcg64State);
+    case SNIPPETS_RAND_ENGINE_SPLITMIX64:
+      return sizeof (uint64_t);
+    case SNIPPETS_RAND_ENGINE_PHILOX4X32:
+      return sizeof (Philox4x32State);
+    default:
+      return 0;
+  }
+}
+
+SnippetsRand *
+snippets_rand_new_with_engine (SnippetsRandEngine engine, uint64_t seed)
+{
+  SnippetsRand *rand;
+  size_t size;
+
+  size = rand_state_size (engine);
+  if (size == 0) {
+    assert (0 && "Unsupported engine");
+    return NULL;
+  }
+
+  rand = calloc (offsetof (SnippetsRand, state) + size, 1);
+  rand->engine = engine;
+
+  switch (engine) {
+    case SNIPPETS_RAND_ENGINE_MT19937:
+      if (seed <= 0xffffffff) {
+        mt19937_init (&rand->state.mt19937, seed);
+      } else {
+        uint32_t key[2] = { (uint32_t) seed, seed >> 32 };
+
+        mt19937_init_by_array (&rand->state.mt19937, key, 2);
+      }
+      break;
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS:
+      xoshiro256_init (&rand->state.xoshiro256, seed);
+      break;
+    case SNIPPETS_RAND_ENGINE_PCG64:
+      pcg64_init (&rand->state.pcg64, seed);
+      break;
+    case SNIPPETS_RAND_ENGINE_SPLITMIX64:
+      rand->state.splitmix64 = seed;
+      break;
+    case SNIPPETS_RAND_ENGINE_PHILOX4X32:
+      philox4x32_init (&rand->state.philox4x32, seed);
+      break;
+  }
 
   return rand;
 }
 
+SnippetsRandEngine
+snippets_rand_get_engine (SnippetsRand * rand)
+{
+  assert (rand != NULL);
+
+  return rand->engine;
+}
+
 void
 snippets_rand_free (SnippetsRand * rand)
 {
@@ -52,28 +160,631 @@ snippets_rand_free (SnippetsRand * rand)
   free (rand);
 }
 
+/* Reads up to @len bytes from the entropy source of the system and
+ * returns how many it got */
+static size_t
+rand_entropy (uint8_t * buf, size_t len)
+{
+  size_t got = 0;
+  ssize_t r;
+
+#if defined (HAVE_GETRANDOM) && defined (HAVE_SYS_RANDOM_H)
+  while (got < len) {
+    r = getrandom (buf + got, len - got, 0);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      break;
+    got += r;
+  }
+#endif
+
+#if defined (HAVE_UNISTD_H) && defined (HAVE_FCNTL_H)
+  if (got < len) {
+    int fd = open ("/dev/urandom", O_RDONLY);
+
+    if (fd >= 0) {
+      while (got < len) {
+        r = read (fd, buf + got, len - got);
+        if (r < 0 && errno == EINTR)
+          continue;
+        if (r <= 0)
+          break;
+        got += r;
+      }
+      close (fd);
+    }
+  }
+#endif
+
+  return got;
+}
+
+/* Fills @seed with entropy from the system, mixed with the time and
+ * the thread so that two threads get different seeds even if there is
+ * no entropy source */
+static void
+rand_entropy_seed (uint64_t * seed, size_t n)
+{
+  uint64_t x = time (NULL), id = (uintptr_t) seed;
+  size_t i;
+
+  memset (seed, 0, n * sizeof (uint64_t));
+  rand_entropy ((uint8_t *) seed, n * sizeof (uint64_t));
+
+#ifdef HAVE_PTHREAD
+  {
+    pthread_t self = pthread_self ();
+
+    memcpy (&id, &self, sizeof (self) < sizeof (id) ? sizeof (self) :
+        sizeof (id));
+  }
+#endif
+
+  x = splitmix64_next (&x) ^ id;
+  x ^= (uint64_t) clock () << 32;
+  for (i = 0; i < n; i++)
+    seed[i] ^= splitmix64_next (&x);
+}
+
+SnippetsRand *
+snippets_rand_new_from_array (const uint32_t * key, size_t key_length)
+{
+  SnippetsRand *rand;
+
+  assert (key != NULL);
+  assert (key_length > 0);
+
+  rand = calloc (offsetof (SnippetsRand, state) + sizeof (MT19937State), 1);
+  rand->engine = SNIPPETS_RAND_ENGINE_MT19937;
+  mt19937_init_by_array (&rand->state.mt19937, key, key_length);
+
+  return rand;
+}
+
+SnippetsRand *
+snippets_rand_new_entropy (void)
+{
+  return snippets_rand_new_entropy_with_engine (SNIPPETS_RAND_ENGINE_MT19937);
+}
+
+SnippetsRand *
+snippets_rand_new_entropy_with_engine (SnippetsRandEngine engine)
+{
+  SnippetsRand *rand;
+  uint64_t seed[N / 2];
+  uint32_t key[N], counter[4];
+  Xoshiro256State *xoshiro256;
+
+  rand = snippets_rand_new_with_engine (engine, 0);
+  if (!rand)
+    return NULL;
+
+  /* The whole state comes from the entropy */
+  switch (engine) {
+    case SNIPPETS_RAND_ENGINE_MT19937:
+      rand_entropy_seed (seed, N / 2);
+      memcpy (key, seed, sizeof (key));
+      mt19937_init_by_array (&rand->state.mt19937, key, N);
+      break;
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS:
+      xoshiro256 = &rand->state.xoshiro256;
+      rand_entropy_seed (xoshiro256->s, 4);
+      /* The only state xoshiro256** can't leave */
+      if ((xoshiro256->s[0] | xoshiro256->s[1] | xoshiro256->s[2] |
+              xoshiro256->s[3]) == 0)
+        xoshiro256->s[0] = SPLITMIX64_GAMMA;
+      break;
+    case SNIPPETS_RAND_ENGINE_PCG64:
+      rand_entropy_seed (seed, 4);
+      pcg64_seed (&rand->state.pcg64, seed);
+      break;
+    case SNIPPETS_RAND_ENGINE_SPLITMIX64:
+      rand_entropy_seed (&rand->state.splitmix64, 1);
+      break;
+    case SNIPPETS_RAND_ENGINE_PHILOX4X32:
+      rand_entropy_seed (seed, 2);
+      philox4x32_init (&rand->state.philox4x32, seed[0]);
+      counter[0] = counter[1] = 0;
+      counter[2] = (uint32_t) seed[1];
+      counter[3] = seed[1] >> 32;
+      philox4x32_set_position (&rand->state.philox4x32, counter, 0);
+      break;
+  }
+
+  return rand;
+}
+
+static SnippetsRand *
+rand_thread_default_new (void)
+{
+  SnippetsRandEngine engine = SNIPPETS_RAND_ENGINE_XOSHIRO256SS;
+
+  return snippets_rand_new_entropy_with_engine (engine);
+}
+
+#ifdef HAVE_TLS
+static __thread SnippetsRand *rand_thread_default;
+#endif
+
+#ifdef HAVE_PTHREAD
+static pthread_key_t rand_thread_key;
+static pthread_once_t rand_thread_key_once = PTHREAD_ONCE_INIT;
+
+/* Calls from other destructors after this one create a new generator,
+ * which is registered again and freed in the next destructor pass */
+static void
+rand_thread_default_free (void *data)
+{
+#ifdef HAVE_TLS
+  rand_thread_default = NULL;
+#endif
+  snippets_rand_free (data);
+}
+
+static void
+rand_thread_key_init (void)
+{
+  pthread_key_create (&rand_thread_key, rand_thread_default_free);
+}
+
+/* The key is only used for freeing the generator when the thread
+ * exits, and for finding it if there is no __thread */
+static SnippetsRand *
+rand_thread_default_get (void)
+{
+  SnippetsRand *rand;
+
+  pthread_once (&rand_thread_key_once, rand_thread_key_init);
+
+  rand = pthread_getspecific (rand_thread_key);
+  if (rand == NULL) {
+    rand = rand_thread_default_new ();
+    pthread_setspecific (rand_thread_key, rand);
+  }
+
+  return rand;
+}
+#else
+static SnippetsRand *
+rand_thread_default_get (void)
+{
+  static SnippetsRand *rand = NULL;
+
+  if (rand == NULL)
+    rand = rand_thread_default_new ();
+
+  return rand;
+}
+#endif
+
+SnippetsRand *
+snippets_rand_thread_default (void)
+{
+#ifdef HAVE_TLS
+  if (rand_thread_default == NULL)
+    rand_thread_default = rand_thread_default_get ();
+
+  return rand_thread_default;
+#else
+  return rand_thread_default_get ();
+#endif
+}
+
+SnippetsRandThreadState *
+snippets_rand_thread_state (void)
+{
+  SnippetsRand *rand = snippets_rand_thread_default ();
+
+  return (SnippetsRandThreadState *) &rand->state.xoshiro256;
+}
+
+/* Jump distance of snippets_rand_split() for every engine, far below
+ * the periods. MT19937 and xoshiro256** jump by 2^128 like the
+ * reference jump() of the latter, PCG64 has a period of 2^128 itself,
+ * SplitMix64 one of 2^64 and Philox4x32 one of 2^129 */
+static const unsigned int rand_split_log2_steps[] = {
+  128, 128, 96, 48, 96
+};
+
+/* Precalculated jump for one of the engines */
+typedef struct
+{
+  SnippetsRandEngine engine;
+  unsigned int log2_steps;
+
+  /* Jump polynomials of the linear engines */
+  uint64_t *mt19937_q;
+  uint64_t xoshiro256_q[4];
+} RandJump;
+
+static void
+rand_jump_init (RandJump * jump, SnippetsRandEngine engine,
+    unsigned int log2_steps)
+{
+  jump->engine = engine;
+  jump->log2_steps = log2_steps;
+  jump->mt19937_q = NULL;
+
+  switch (engine) {
+    case SNIPPETS_RAND_ENGINE_MT19937:
+      jump->mt19937_q = mt19937_jump_poly (log2_steps);
+      break;
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS:
+      xoshiro256_jump_poly (log2_steps, jump->xoshiro256_q);
+      break;
+    default:
+      break;
+  }
+}
+
+static void
+rand_jump_apply (const RandJump * jump, SnippetsRand * rand)
+{
+  switch (jump->engine) {
+    case SNIPPETS_RAND_ENGINE_MT19937:
+      mt19937_jump (&rand->state.mt19937, jump->mt19937_q);
+      break;
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS:
+      xoshiro256_jump (&rand->state.xoshiro256, jump->xoshiro256_q);
+      break;
+    case SNIPPETS_RAND_ENGINE_PCG64:
+      pcg64_jump (&rand->state.pcg64, jump->log2_steps);
+      break;
+    case SNIPPETS_RAND_ENGINE_SPLITMIX64:
+      splitmix64_jump (&rand->state.splitmix64, jump->log2_steps);
+      break;
+    case SNIPPETS_RAND_ENGINE_PHILOX4X32:
+      philox4x32_jump (&rand->state.philox4x32, jump->log2_steps);
+      break;
+  }
+}
+
+static void
+rand_jump_clear (RandJump * jump)
+{
+  free (jump->mt19937_q);
+}
+
+void
+snippets_rand_jump (SnippetsRand * rand, unsigned int log2_steps)
+{
+  RandJump jump;
+
+  assert (rand != NULL);
+
+  rand_jump_init (&jump, rand->engine, log2_steps);
+  rand_jump_apply (&jump, rand);
+  rand_jump_clear (&jump);
+}
+
+void
+snippets_rand_split (SnippetsRand * rand, unsigned int n_streams,
+    SnippetsRand ** streams)
+{
+  RandJump jump;
+  size_t size;
+  unsigned int i;
+
+  assert (rand != NULL);
+  assert (streams != NULL || n_streams == 0);
+
+  if (n_streams == 0)
+    return;
+
+  size = offsetof (SnippetsRand, state) + rand_state_size (rand->engine);
+  rand_jump_init (&jump, rand->engine,
+      rand_split_log2_steps[rand->engine]);
+
+  /* Every stream starts where the previous one was jumped to, @rand
+   * continues after the last one */
+  for (i = 0; i < n_streams; i++) {
+    streams[i] = malloc (size);
+    memcpy (streams[i], rand, size);
+    rand_jump_apply (&jump, rand);
+  }
+
+  rand_jump_clear (&jump);
+}
+
+/* Serialized state: "SR", version, engine and the state words of the
+ * engine in little endian byte order. MT19937 has mti as a 32 bit word
+ * after the 624 words of mt[], out[] is the tempered mt[]. Philox4x32
+ * has the key, the counter of the block with the next word and the
+ * index of that word, the buffered blocks are recalculated */
+#define RAND_SAVE_VERSION 1
+#define RAND_SAVE_HEADER_SIZE 4
+
+static size_t
+rand_save_size (SnippetsRandEngine engine)
+{
+  switch (engine) {
+    case SNIPPETS_RAND_ENGINE_MT19937:
+      return RAND_SAVE_HEADER_SIZE + 4 * N + 4;
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS:
+    case SNIPPETS_RAND_ENGINE_PCG64:
+      return RAND_SAVE_HEADER_SIZE + 4 * 8;
+    case SNIPPETS_RAND_ENGINE_SPLITMIX64:
+      return RAND_SAVE_HEADER_SIZE + 8;
+    case SNIPPETS_RAND_ENGINE_PHILOX4X32:
+      return RAND_SAVE_HEADER_SIZE + 7 * 4;
+    default:
+      return 0;
+  }
+}
+
+static inline uint8_t *
+rand_write_uint32 (uint8_t * buf, uint32_t v)
+{
+  buf[0] = v;
+  buf[1] = v >> 8;
+  buf[2] = v >> 16;
+  buf[3] = v >> 24;
+
+  return buf + 4;
+}
+
+static inline uint8_t *
+rand_write_uint64 (uint8_t * buf, uint64_t v)
+{
+  buf = rand_write_uint32 (buf, (uint32_t) v);
+  return rand_write_uint32 (buf, v >> 32);
+}
+
+static inline uint32_t
+rand_read_uint32 (const uint8_t ** buf)
+{
+  const uint8_t *b = *buf;
+
+  *buf += 4;
+
+  return b[0] | (b[1] << 8) | ((uint32_t) b[2] << 16) | ((uint32_t) b[3] <<
+      24);
+}
+
+static inline uint64_t
+rand_read_uint64 (const uint8_t ** buf)
+{
+  uint64_t v = rand_read_uint32 (buf);
+
+  return v | ((uint64_t) rand_read_uint32 (buf) << 32);
+}
+
+size_t
+snippets_rand_get_save_size (SnippetsRand * rand)
+{
+  assert (rand != NULL);
+
+  return rand_save_size (rand->engine);
+}
+
+void
+snippets_rand_save (SnippetsRand * rand, uint8_t * buf)
+{
+  uint32_t counter[4];
+  unsigned int i, index;
+
+  assert (rand != NULL);
+  assert (buf != NULL);
+
+  *buf++ = 'S';
+  *buf++ = 'R';
+  *buf++ = RAND_SAVE_VERSION;
+  *buf++ = rand->engine;
+
+  switch (rand->engine) {
+    case SNIPPETS_RAND_ENGINE_MT19937:
+      for (i = 0; i < N; i++)
+        buf = rand_write_uint32 (buf, rand->state.mt19937.mt[i]);
+      rand_write_uint32 (buf, rand->state.mt19937.mti);
+      break;
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS:
+      for (i = 0; i < 4; i++)
+        buf = rand_write_uint64 (buf, rand->state.xoshiro256.s[i]);
+      break;
+    case SNIPPETS_RAND_ENGINE_PCG64:
+      buf = rand_write_uint64 (buf, rand->state.pcg64.state_high);
+      buf = rand_write_uint64 (buf, rand->state.pcg64.state_low);
+      buf = rand_write_uint64 (buf, rand->state.pcg64.inc_high);
+      rand_write_uint64 (buf, rand->state.pcg64.inc_low);
+      break;
+    case SNIPPETS_RAND_ENGINE_SPLITMIX64:
+      rand_write_uint64 (buf, rand->state.splitmix64);
+      break;
+    case SNIPPETS_RAND_ENGINE_PHILOX4X32:
+      philox4x32_get_position (&rand->state.philox4x32, counter, &index);
+      for (i = 0; i < 2; i++)
+        buf = rand_write_uint32 (buf, rand->state.philox4x32.key[i]);
+      for (i = 0; i < 4; i++)
+        buf = rand_write_uint32 (buf, counter[i]);
+      rand_write_uint32 (buf, index);
+      break;
+  }
+}
+
+SnippetsRand *
+snippets_rand_restore (const uint8_t * buf, size_t len)
+{
+  SnippetsRand *rand;
+  SnippetsRandEngine engine;
+  MT19937State *mt;
+  Xoshiro256State *xoshiro;
+  Pcg64State *pcg;
+  Philox4x32State *philox;
+  uint32_t counter[4];
+  unsigned int i, index;
+
+  assert (buf != NULL || len == 0);
+
+  /* Invalid data is not a programming error, just fail */
+  if (len < RAND_SAVE_HEADER_SIZE || buf[0] != 'S' || buf[1] != 'R'
+      || buf[2] != RAND_SAVE_VERSION)
+    return NULL;
+  engine = buf[3];
+  if (rand_state_size (engine) == 0 || len != rand_save_size (engine))
+    return NULL;
+  buf += RAND_SAVE_HEADER_SIZE;
+
+  rand = calloc (offsetof (SnippetsRand, state) + rand_state_size (engine),
+      1);
+  rand->engine = engine;
+
+  switch (engine) {
+    case SNIPPETS_RAND_ENGINE_MT19937:
+      mt = &rand->state.mt19937;
+      mt19937_init_generate (mt);
+      for (i = 0; i < N; i++) {
+        mt->mt[i] = rand_read_uint32 (&buf);
+        mt->out[i] = mt19937_temper (mt->mt[i]);
+      }
+      mt->mti = rand_read_uint32 (&buf);
+      if (mt->mti > N)
+        goto invalid;
+      break;
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS:
+      xoshiro = &rand->state.xoshiro256;
+      for (i = 0; i < 4; i++)
+        xoshiro->s[i] = rand_read_uint64 (&buf);
+      if (!(xoshiro->s[0] | xoshiro->s[1] | xoshiro->s[2] | xoshiro->s[3]))
+        goto invalid;
+      break;
+    case SNIPPETS_RAND_ENGINE_PCG64:
+      pcg = &rand->state.pcg64;
+      pcg->state_high = rand_read_uint64 (&buf);
+      pcg->state_low = rand_read_uint64 (&buf);
+      pcg->inc_high = rand_read_uint64 (&buf);
+      pcg->inc_low = rand_read_uint64 (&buf);
+      if (!(pcg->inc_low & 1))
+        goto invalid;
+      break;
+    case SNIPPETS_RAND_ENGINE_SPLITMIX64:
+      rand->state.splitmix64 = rand_read_uint64 (&buf);
+      break;
+    case SNIPPETS_RAND_ENGINE_PHILOX4X32:
+      philox = &rand->state.philox4x32;
+      for (i = 0; i < 2; i++)
+        philox->key[i] = rand_read_uint32 (&buf);
+      for (i = 0; i < 4; i++)
+        counter[i] = rand_read_uint32 (&buf);
+      index = rand_read_uint32 (&buf);
+      /* 64 bit numbers are two words of the same block */
+      if (index != 0 && index != 2)
+        goto invalid;
+      philox4x32_set_position (philox, counter, index);
+      break;
+  }
+
+  return rand;
+
+invalid:
+  free (rand);
+  return NULL;
+}
+
+/* Next 64 bits from one of the 64 bit engines */
+static inline uint64_t
+rand_next64 (SnippetsRand * rand)
+{
+  switch (rand->engine) {
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS:
+      return xoshiro256_next (&rand->state.xoshiro256);
+    case SNIPPETS_RAND_ENGINE_PCG64:
+      return pcg64_next (&rand->state.pcg64);
+    case SNIPPETS_RAND_ENGINE_PHILOX4X32:
+      return philox4x32_next (&rand->state.philox4x32);
+    case SNIPPETS_RAND_ENGINE_SPLITMIX64:
+    default:
+      return splitmix64_next (&rand->state.splitmix64);
+  }
+}
+
+/* The 64 bit engines use the upper half of their output for 32 bit
+ * numbers, which are the better bits for all of them */
+static inline uint32_t
+rand_next32 (SnippetsRand * rand)
+{
+  if (rand->engine == SNIPPETS_RAND_ENGINE_MT19937)
+    return mt19937_genrand_uint32 (&rand->state.mt19937);
+
+  return rand_next64 (rand) >> 32;
+}
+
 uint32_t
 snippets_rand_uint32 (SnippetsRand * rand)
 {
   assert (rand != NULL);
 
-  return mt19937_genrand_uint32 (rand);
+  return rand_next32 (rand);
 }
 
-uint32_t
-snippets_rand_uint32_range (SnippetsRand * rand, uint32_t min, uint32_t max)
+/* MT19937 gives the first number in the upper half */
+static inline uint64_t
+rand_uint64 (SnippetsRand * rand)
 {
   uint64_t a;
 
+  if (rand->engine != SNIPPETS_RAND_ENGINE_MT19937)
+    return rand_next64 (rand);
+
+  a = mt19937_genrand_uint32 (&rand->state.mt19937);
+  return (a << 32) | mt19937_genrand_uint32 (&rand->state.mt19937);
+}
+
+uint64_t
+snippets_rand_uint64 (SnippetsRand * rand)
+{
   assert (rand != NULL);
 
-  a = mt19937_genrand_uint32 (rand);
-  a = (a * (max - min)) / 0xffffffff + min;
+  return rand_uint64 (rand);
+}
+
+/* Lemire's multiply-shift method, see "Fast Random Integer Generation
+ * in an Interval" by Daniel Lemire. The upper half of v * range is
+ * uniform on [0, range) if the lower half is not below
+ * 2^32 % range, which is only calculated when the lower half is
+ * below range at all */
+static inline uint32_t
+rand_uint32_range (SnippetsRand * rand, uint32_t range)
+{
+  uint64_t m = (uint64_t) rand_next32 (rand) * range;
+  uint32_t threshold;
+
+  if ((uint32_t) m < range) {
+    threshold = (0 - range) % range;
+    while ((uint32_t) m < threshold)
+      m = (uint64_t) rand_next32 (rand) * range;
+  }
 
-  return (uint32_t) a;
+  return m >> 32;
+}
+
+uint32_t
+snippets_rand_uint32_range (SnippetsRand * rand, uint32_t min, uint32_t max)
+{
+  assert (rand != NULL);
+  assert (min <= max);
+
+  return rand_uint32_range (rand, max - min) + min;
 }
 
 #define DOUBLE_TRANSFORM 2.3283064365386962890625e-10
+
+static inline double
+rand_uint32_to_double (uint32_t a, uint32_t b)
+{
+  return (a * DOUBLE_TRANSFORM + b) * DOUBLE_TRANSFORM;
+}
+
+/* The 64 bit engines use the upper 53 bits, which gives all
+ * representable multiples of 2^-53 and never 1.0 */
+#define DOUBLE_TRANSFORM_53 1.1102230246251565404236316680908203125e-16
+
+static inline double
+rand_uint64_to_double (uint64_t a)
+{
+  return (a >> 11) * DOUBLE_TRANSFORM_53;
+}
+
 double
 snippets_rand_double (SnippetsRand * rand)
 {
@@ -81,8 +792,11 @@ snippets_rand_double (SnippetsRand * rand)
 
   assert (rand != NULL);
 
-  a = mt19937_genrand_uint32 (rand) * DOUBLE_TRANSFORM;
-  a = (a + mt19937_genrand_uint32 (rand)) * DOUBLE_TRANSFORM;
+  if (rand->engine != SNIPPETS_RAND_ENGINE_MT19937)
+    return rand_uint64_to_double (rand_next64 (rand));
+
+  a = mt19937_genrand_uint32 (&rand->state.mt19937) * DOUBLE_TRANSFORM;
+  a = (a + mt19937_genrand_uint32 (&rand->state.mt19937)) * DOUBLE_TRANSFORM;
 
   /* a >= 1.0 might happen due to rare rounding errors */
   return (a >= 1.0) ? snippets_rand_double (rand) : a;
@@ -95,3 +809,808 @@ snippets_rand_double_range (SnippetsRand * rand, double min, double max)
 
   return snippets_rand_double (rand) * (max - min) + min;
 }
+
+/* The bulk functions produce exactly the same numbers as the
+ * corresponding number of calls to the single value functions */
+
+/* Number of Philox4x32 numbers calculated at once into a stack buffer */
+#define FILL_64_CHUNK 256
+
+/* The engine is selected outside the loops so that they
+ * only contain the inlined engine step. Philox4x32 calculates blocks
+ * with SIMD into a buffer first */
+#define FILL_64(rand, buf, n, transform) do { \
+  size_t _i; \
+  switch ((rand)->engine) { \
+    case SNIPPETS_RAND_ENGINE_PHILOX4X32: { \
+      uint32_t _w[2 * FILL_64_CHUNK]; \
+      size_t _j, _m; \
+      \
+      for (_i = 0; _i < (n); _i += _m) { \
+        _m = (n) - _i < FILL_64_CHUNK ? (n) - _i : FILL_64_CHUNK; \
+        philox4x32_fill (&(rand)->state.philox4x32, _w, 2 * _m); \
+        for (_j = 0; _j < _m; _j++) \
+          (buf)[_i + _j] = transform (_w[2 * _j] | \
+              ((uint64_t) _w[2 * _j + 1] << 32)); \
+      } \
+      break; \
+    } \
+    case SNIPPETS_RAND_ENGINE_XOSHIRO256SS: \
+      for (_i = 0; _i < (n); _i++) \
+        (buf)[_i] = transform (xoshiro256_next (&(rand)->state.xoshiro256)); \
+      break; \
+    case SNIPPETS_RAND_ENGINE_PCG64: \
+      for (_i = 0; _i < (n); _i++) \
+        (buf)[_i] = transform (pcg64_next (&(rand)->state.pcg64)); \
+      break; \
+    default: \
+      for (_i = 0; _i < (n); _i++) \
+        (buf)[_i] = transform (splitmix64_next (&(rand)->state.splitmix64)); \
+      break; \
+  } \
+} while (0)
+
+#define UPPER_32(a) ((uint32_t) ((a) >> 32))
+
+static void
+rand_fill_uint32 (SnippetsRand * rand, uint32_t * buf, size_t n)
+{
+  if (rand->engine == SNIPPETS_RAND_ENGINE_MT19937)
+    mt19937_fill_uint32 (&rand->state.mt19937, buf, n);
+  else
+    FILL_64 (rand, buf, n, UPPER_32);
+}
+
+void
+snippets_rand_fill_uint32 (SnippetsRand * rand, uint32_t * buf, size_t n)
+{
+  assert (rand != NULL);
+  assert (buf != NULL || n == 0);
+
+  rand_fill_uint32 (rand, buf, n);
+}
+
+void
+snippets_rand_fill_uint32_range (SnippetsRand * rand, uint32_t * buf,
+    size_t n, uint32_t min, uint32_t max)
+{
+  uint32_t range = max - min, threshold;
+  uint64_t m;
+  size_t i, j;
+
+  assert (rand != NULL);
+  assert (buf != NULL || n == 0);
+  assert (min <= max);
+
+  /* The rejection threshold only needs to be calculated once */
+  threshold = range ? (0 - range) % range : 0;
+
+  /* Rejected numbers are dropped and the remaining ones moved to the
+   * front, the missing ones are generated in the next iteration */
+  while (n > 0) {
+    rand_fill_uint32 (rand, buf, n);
+    for (i = 0, j = 0; i < n; i++) {
+      m = (uint64_t) buf[i] * range;
+      buf[j] = (m >> 32) + min;
+      j += ((uint32_t) m >= threshold);
+    }
+
+    buf += j;
+    n -= j;
+  }
+}
+
+/* Number of doubles converted at once from a stack buffer */
+#define FILL_DOUBLE_CHUNK 512
+
+void
+snippets_rand_fill_double (SnippetsRand * rand, double *buf, size_t n)
+{
+  uint32_t tmp[2 * FILL_DOUBLE_CHUNK];
+  size_t i, j, m;
+  int rejected;
+
+  assert (rand != NULL);
+  assert (buf != NULL || n == 0);
+
+  if (rand->engine != SNIPPETS_RAND_ENGINE_MT19937) {
+    FILL_64 (rand, buf, n, rand_uint64_to_double);
+    return;
+  }
+
+  while (n > 0) {
+    m = n < FILL_DOUBLE_CHUNK ? n : FILL_DOUBLE_CHUNK;
+
+    mt19937_fill_uint32 (&rand->state.mt19937, tmp, 2 * m);
+    rejected = FALSE;
+    for (i = 0; i < m; i++) {
+      buf[i] = rand_uint32_to_double (tmp[2 * i], tmp[2 * i + 1]);
+      rejected |= (buf[i] >= 1.0);
+    }
+
+    /* Drop values >= 1.0 like snippets_rand_double(), which happen
+     * only very rarely. The missing ones are generated in the next
+     * iteration */
+    if (rejected) {
+      for (i = 0, j = 0; i < m; i++) {
+        if (buf[i] < 1.0)
+          buf[j++] = buf[i];
+      }
+      m = j;
+    }
+
+    buf += m;
+    n -= m;
+  }
+}
+
+void
+snippets_rand_fill_double_range (SnippetsRand * rand, double *buf, size_t n,
+    double min, double max)
+{
+  size_t i;
+
+  assert (rand != NULL);
+  assert (buf != NULL || n == 0);
+
+  snippets_rand_fill_double (rand, buf, n);
+  for (i = 0; i < n; i++)
+    buf[i] = buf[i] * (max - min) + min;
+}
+
+/* Ziggurat method for normal and exponential distributions by George
+ * Marsaglia and Wai Wan Tsang, see "The Ziggurat Method for Generating
+ * Random Variables". 128 layers for the normal and 256 for the
+ * exponential distribution, the tables are calculated on first use.
+ *
+ * Every sample starts from a 32 bit number: the lowest 8 bits select
+ * the layer (and the sign for the normal distribution), the upper 24
+ * bits are the position in the layer. Only if that is outside the
+ * rectangle completely below the curve more numbers are needed */
+#define ZIGGURAT_NORMAL_LAYERS 128
+#define ZIGGURAT_NORMAL_R 3.442619855899
+#define ZIGGURAT_NORMAL_V 9.91256303526217e-3
+#define ZIGGURAT_EXP_LAYERS 256
+#define ZIGGURAT_EXP_R 7.697117470131487
+#define ZIGGURAT_EXP_V 3.949659822581572e-3
+#define ZIGGURAT_SCALE 16777216.0
+
+static struct
+{
+  uint32_t kn[ZIGGURAT_NORMAL_LAYERS];
+  double wn[ZIGGURAT_NORMAL_LAYERS], fn[ZIGGURAT_NORMAL_LAYERS];
+  uint32_t ke[ZIGGURAT_EXP_LAYERS];
+  double we[ZIGGURAT_EXP_LAYERS], fe[ZIGGURAT_EXP_LAYERS];
+} ziggurat;
+
+static void
+rand_ziggurat_init (void)
+{
+  double dn = ZIGGURAT_NORMAL_R, tn = dn, de = ZIGGURAT_EXP_R, te = de, q;
+  int i;
+
+  q = ZIGGURAT_NORMAL_V / exp (-0.5 * dn * dn);
+  ziggurat.kn[0] = (dn / q) * ZIGGURAT_SCALE;
+  ziggurat.kn[1] = 0;
+  ziggurat.wn[0] = q / ZIGGURAT_SCALE;
+  ziggurat.wn[ZIGGURAT_NORMAL_LAYERS - 1] = dn / ZIGGURAT_SCALE;
+  ziggurat.fn[0] = 1.0;
+  ziggurat.fn[ZIGGURAT_NORMAL_LAYERS - 1] = exp (-0.5 * dn * dn);
+  for (i = ZIGGURAT_NORMAL_LAYERS - 2; i >= 1; i--) {
+    dn = sqrt (-2.0 * log (ZIGGURAT_NORMAL_V / dn + exp (-0.5 * dn * dn)));
+    ziggurat.kn[i + 1] = (dn / tn) * ZIGGURAT_SCALE;
+    tn = dn;
+    ziggurat.fn[i] = exp (-0.5 * dn * dn);
+    ziggurat.wn[i] = dn / ZIGGURAT_SCALE;
+  }
+
+  q = ZIGGURAT_EXP_V / exp (-de);
+  ziggurat.ke[0] = (de / q) * ZIGGURAT_SCALE;
+  ziggurat.ke[1] = 0;
+  ziggurat.we[0] = q / ZIGGURAT_SCALE;
+  ziggurat.we[ZIGGURAT_EXP_LAYERS - 1] = de / ZIGGURAT_SCALE;
+  ziggurat.fe[0] = 1.0;
+  ziggurat.fe[ZIGGURAT_EXP_LAYERS - 1] = exp (-de);
+  for (i = ZIGGURAT_EXP_LAYERS - 2; i >= 1; i--) {
+    de = -log (ZIGGURAT_EXP_V / de + exp (-de));
+    ziggurat.ke[i + 1] = (de / te) * ZIGGURAT_SCALE;
+    te = de;
+    ziggurat.fe[i] = exp (-de);
+    ziggurat.we[i] = de / ZIGGURAT_SCALE;
+  }
+}
+
+static void
+rand_ziggurat_ensure_init (void)
+{
+#ifdef HAVE_PTHREAD
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+  pthread_once (&once, rand_ziggurat_init);
+#else
+  static int initialized = FALSE;
+
+  if (!initialized) {
+    rand_ziggurat_init ();
+    initialized = TRUE;
+  }
+#endif
+}
+
+/* 32 bit numbers taken from a buffer filled by rand_fill_uint32()
+ * first and then from the engine, which gives the bulk functions the
+ * same numbers as the single value functions */
+typedef struct
+{
+  SnippetsRand *rand;
+  const uint32_t *buf;
+  size_t pos, len;
+} RandSource;
+
+static inline uint32_t
+rand_source_next32 (RandSource * src)
+{
+  return src->pos < src->len ? src->buf[src->pos++] : rand_next32 (src->rand);
+}
+
+/* Uniform on (0, 1), never 0 for the logarithms */
+static inline double
+rand_source_uniform (RandSource * src)
+{
+  return (rand_source_next32 (src) + 0.5) * DOUBLE_TRANSFORM;
+}
+
+static double
+rand_normal_slow (RandSource * src, uint32_t j)
+{
+  unsigned int i;
+  double x, y;
+
+  for (;;) {
+    i = j & (ZIGGURAT_NORMAL_LAYERS - 1);
+    x = (j >> 8) * ziggurat.wn[i];
+    if ((j >> 8) < ziggurat.kn[i])
+      break;
+
+    if (i == 0) {
+      /* Tail beyond R */
+      do {
+        x = -log (rand_source_uniform (src)) / ZIGGURAT_NORMAL_R;
+        y = -log (rand_source_uniform (src));
+      } while (y + y < x * x);
+      x += ZIGGURAT_NORMAL_R;
+      break;
+    }
+
+    if (ziggurat.fn[i] + rand_source_uniform (src) * (ziggurat.fn[i - 1] -
+            ziggurat.fn[i]) < exp (-0.5 * x * x))
+      break;
+
+    j = rand_source_next32 (src);
+  }
+
+  return (j & ZIGGURAT_NORMAL_LAYERS) ? -x : x;
+}
+
+static inline double
+rand_normal (RandSource * src)
+{
+  uint32_t j = rand_source_next32 (src);
+  unsigned int i = j & (ZIGGURAT_NORMAL_LAYERS - 1);
+  int32_t sign, u;
+
+  if ((j >> 8) >= ziggurat.kn[i])
+    return rand_normal_slow (src, j);
+
+  /* Negate without a branch, the sign is unpredictable */
+  sign = -(int32_t) ((j >> 7) & 1);
+  u = ((int32_t) (j >> 8) ^ sign) - sign;
+  return u * ziggurat.wn[i];
+}
+
+static double
+rand_exponential_slow (RandSource * src, uint32_t j)
+{
+  unsigned int i;
+  double x;
+
+  for (;;) {
+    i = j & (ZIGGURAT_EXP_LAYERS - 1);
+    x = (j >> 8) * ziggurat.we[i];
+    if ((j >> 8) < ziggurat.ke[i])
+      return x;
+
+    /* Tail beyond R */
+    if (i == 0)
+      return ZIGGURAT_EXP_R - log (rand_source_uniform (src));
+
+    if (ziggurat.fe[i] + rand_source_uniform (src) * (ziggurat.fe[i - 1] -
+            ziggurat.fe[i]) < exp (-x))
+      return x;
+
+    j = rand_source_next32 (src);
+  }
+}
+
+static inline double
+rand_exponential (RandSource * src)
+{
+  uint32_t j = rand_source_next32 (src);
+  unsigned int i = j & (ZIGGURAT_EXP_LAYERS - 1);
+
+  if ((j >> 8) >= ziggurat.ke[i])
+    return rand_exponential_slow (src, j);
+
+  return (j >> 8) * ziggurat.we[i];
+}
+
+double
+snippets_rand_normal (SnippetsRand * rand, double mean, double stddev)
+{
+  RandSource src = { rand, NULL, 0, 0 };
+
+  assert (rand != NULL);
+
+  rand_ziggurat_ensure_init ();
+
+  return rand_normal (&src) * stddev + mean;
+}
+
+double
+snippets_rand_exponential (SnippetsRand * rand, double lambda)
+{
+  RandSource src = { rand, NULL, 0, 0 };
+
+  assert (rand != NULL);
+  assert (lambda > 0);
+
+  rand_ziggurat_ensure_init ();
+
+  return rand_exponential (&src) / lambda;
+}
+
+/* Number of 32 bit numbers generated at once into a stack buffer */
+#define FILL_SOURCE_CHUNK 512
+
+void
+snippets_rand_fill_normal (SnippetsRand * rand, double *buf, size_t n,
+    double mean, double stddev)
+{
+  uint32_t tmp[FILL_SOURCE_CHUNK];
+  RandSource src = { rand, tmp, 0, 0 };
+
+  assert (rand != NULL);
+  assert (buf != NULL || n == 0);
+
+  rand_ziggurat_ensure_init ();
+
+  /* Every sample needs at least one number, so no more than the
+   * remaining number of samples is generated in advance */
+  while (n > 0) {
+    src.len = n < FILL_SOURCE_CHUNK ? n : FILL_SOURCE_CHUNK;
+    src.pos = 0;
+    rand_fill_uint32 (rand, tmp, src.len);
+
+    while (src.pos < src.len) {
+      *buf++ = rand_normal (&src) * stddev + mean;
+      n--;
+    }
+  }
+}
+
+void
+snippets_rand_fill_exponential (SnippetsRand * rand, double *buf, size_t n,
+    double lambda)
+{
+  uint32_t tmp[FILL_SOURCE_CHUNK];
+  RandSource src = { rand, tmp, 0, 0 };
+
+  assert (rand != NULL);
+  assert (buf != NULL || n == 0);
+  assert (lambda > 0);
+
+  rand_ziggurat_ensure_init ();
+
+  while (n > 0) {
+    src.len = n < FILL_SOURCE_CHUNK ? n : FILL_SOURCE_CHUNK;
+    src.pos = 0;
+    rand_fill_uint32 (rand, tmp, src.len);
+
+    while (src.pos < src.len) {
+      *buf++ = rand_exponential (&src) / lambda;
+      n--;
+    }
+  }
+}
+
+/* Shuffling */
+
+/* Low half of a * b, the high half goes to @high */
+static inline uint64_t
+rand_mul64 (uint64_t a, uint64_t b, uint64_t * high)
+{
+  uint64_t low;
+
+  pcg64_muladd (0, a, 0, b, 0, 0, high, &low);
+
+  return low;
+}
+
+/* Lemire's method like rand_uint32_range() for 64 bit ranges */
+static inline uint64_t
+rand_uint64_range (SnippetsRand * rand, uint64_t range)
+{
+  uint64_t high, low, threshold;
+
+  low = rand_mul64 (rand_uint64 (rand), range, &high);
+  if (low < range) {
+    threshold = (0 - range) % range;
+    while (low < threshold)
+      low = rand_mul64 (rand_uint64 (rand), range, &high);
+  }
+
+  return high;
+}
+
+/* Draws numbers for the @k bounds @bound, @bound - 1, ... from a single
+ * 64 bit number, see "Batched Ranged Random Integer Generation" by
+ * Nevin Brackett-Rozinsky and Daniel Lemire. Each bound takes the
+ * upper half of its product with the lower half of the previous one,
+ * and the numbers are rejected together if the final lower half is
+ * below 2^64 % the product of the bounds, which must fit into 64
+ * bits */
+static inline void
+rand_batched_range (SnippetsRand * rand, uint64_t bound, unsigned int k,
+    uint64_t * out)
+{
+  uint64_t product = 1, threshold, r;
+  unsigned int i;
+
+  for (i = 0; i < k; i++)
+    product *= bound - i;
+
+  r = rand_uint64 (rand);
+  for (i = 0; i < k; i++)
+    r = rand_mul64 (r, bound - i, &out[i]);
+
+  if (r < product) {
+    threshold = (0 - product) % product;
+    while (r < threshold) {
+      r = rand_uint64 (rand);
+      for (i = 0; i < k; i++)
+        r = rand_mul64 (r, bound - i, &out[i]);
+    }
+  }
+}
+
+/* Must be inlined for the element size to be a constant */
+static inline __attribute__ ((always_inline)) void
+rand_swap (uint8_t * base, size_t i, size_t j, size_t size)
+{
+  uint8_t a[64], b[64];
+  size_t offset, len;
+
+  for (offset = 0; offset < size; offset += len) {
+    len = size - offset < sizeof (a) ? size - offset : sizeof (a);
+    memcpy (a, base + i * size + offset, len);
+    memcpy (b, base + j * size + offset, len);
+    memcpy (base + i * size + offset, b, len);
+    memcpy (base + j * size + offset, a, len);
+  }
+}
+
+/* Swaps if @cond is 1, without a branch for the common sizes */
+static inline __attribute__ ((always_inline)) void
+rand_swap_if (uint8_t * base, size_t i, size_t j, size_t size, uint64_t cond)
+{
+  uint64_t a, b, t;
+
+  if (size == 4 || size == 8) {
+    a = b = 0;
+    memcpy (&a, base + i * size, size);
+    memcpy (&b, base + j * size, size);
+    t = (a ^ b) & (0 - cond);
+    a ^= t;
+    b ^= t;
+    memcpy (base + i * size, &a, size);
+    memcpy (base + j * size, &b, size);
+  } else if (cond) {
+    rand_swap (base, i, j, size);
+  }
+}
+
+/* Fisher-Yates shuffle, with as many indices per 64 bit number as the
+ * product of their bounds allows */
+static inline __attribute__ ((always_inline)) void
+rand_shuffle_fisher_yates_size (SnippetsRand * rand, uint8_t * base,
+    size_t n, size_t size)
+{
+  uint64_t j[4];
+  size_t i = n;
+
+  for (; i > 0xffffffff; i--)
+    rand_swap (base, i - 1, rand_uint64_range (rand, i), size);
+
+  for (; i > (1 << 20); i -= 2) {
+    rand_batched_range (rand, i, 2, j);
+    rand_swap (base, i - 1, j[0], size);
+    rand_swap (base, i - 2, j[1], size);
+  }
+
+  for (; i > (1 << 16); i -= 3) {
+    rand_batched_range (rand, i, 3, j);
+    rand_swap (base, i - 1, j[0], size);
+    rand_swap (base, i - 2, j[1], size);
+    rand_swap (base, i - 3, j[2], size);
+  }
+
+  for (; i >= 5; i -= 4) {
+    rand_batched_range (rand, i, 4, j);
+    rand_swap (base, i - 1, j[0], size);
+    rand_swap (base, i - 2, j[1], size);
+    rand_swap (base, i - 3, j[2], size);
+    rand_swap (base, i - 4, j[3], size);
+  }
+
+  for (; i > 1; i--)
+    rand_swap (base, i - 1, rand_uint64_range (rand, i), size);
+}
+
+/* Merges the shuffled ranges [lo, mid) and [mid, hi) into a shuffled
+ * [lo, hi), see "MergeShuffle: A Very Fast, Parallel Random
+ * Permutation Algorithm" by Axel Bacher, Olivier Bodini, Alexandros
+ * Hollender and Jérémie Lumbroso. Each position takes the next element
+ * of a random side until one side runs out, the rest is inserted with
+ * Fisher-Yates steps. Apart from those it only needs one random bit
+ * per element and accesses the memory sequentially */
+static inline __attribute__ ((always_inline)) void
+rand_shuffle_merge_size (SnippetsRand * rand, uint8_t * base, size_t lo,
+    size_t mid, size_t hi, size_t size)
+{
+  size_t i = lo, j = mid;
+  uint64_t bits = 0, bit;
+  unsigned int n_bits = 0;
+
+  /* Neither side can run out while i < j < hi, the choice is then
+   * made without a branch */
+  while (i < j && j < hi) {
+    if (n_bits == 0) {
+      bits = rand_uint64 (rand);
+      n_bits = 64;
+    }
+    bit = bits & 1;
+    rand_swap_if (base, i, j, size, bit);
+    j += bit;
+    bits >>= 1;
+    n_bits--;
+    i++;
+  }
+
+  for (;;) {
+    if (n_bits == 0) {
+      bits = rand_uint64 (rand);
+      n_bits = 64;
+    }
+    if (bits & 1) {
+      if (j == hi)
+        break;
+      rand_swap (base, i, j, size);
+      j++;
+    } else if (i == j) {
+      break;
+    }
+    bits >>= 1;
+    n_bits--;
+    i++;
+  }
+
+  for (; i < hi; i++)
+    rand_swap (base, i, lo + rand_uint64_range (rand, i - lo + 1), size);
+}
+
+static void
+rand_shuffle_fisher_yates (SnippetsRand * rand, uint8_t * base, size_t n,
+    size_t size)
+{
+  switch (size) {
+    case 4:
+      rand_shuffle_fisher_yates_size (rand, base, n, 4);
+      break;
+    case 8:
+      rand_shuffle_fisher_yates_size (rand, base, n, 8);
+      break;
+    default:
+      rand_shuffle_fisher_yates_size (rand, base, n, size);
+      break;
+  }
+}
+
+static void
+rand_shuffle_merge (SnippetsRand * rand, uint8_t * base, size_t lo,
+    size_t mid, size_t hi, size_t size)
+{
+  switch (size) {
+    case 4:
+      rand_shuffle_merge_size (rand, base, lo, mid, hi, 4);
+      break;
+    case 8:
+      rand_shuffle_merge_size (rand, base, lo, mid, hi, 8);
+      break;
+    default:
+      rand_shuffle_merge_size (rand, base, lo, mid, hi, size);
+      break;
+  }
+}
+
+/* Arrays above SHUFFLE_MERGE_SIZE bytes are shuffled in blocks of
+ * SHUFFLE_BLOCK_SIZE bytes, which stay in the L2 cache, and the blocks
+ * are then merged level by level. Below that the random accesses of
+ * Fisher-Yates mostly hit the last level cache and are faster than
+ * the merge passes. Both sizes are fixed so that the result doesn't
+ * depend on the machine. Every block and every merge is a task
+ * with its own Philox4x32 stream, keyed with a number from the
+ * generator and with the level and index of the task as counter. The
+ * tasks of a level are independent, so the result only depends on the
+ * generator and never on the number of threads */
+#define SHUFFLE_MERGE_SIZE (32 * 1024 * 1024)
+#define SHUFFLE_BLOCK_SIZE (1024 * 1024)
+
+typedef struct
+{
+  uint8_t *base;
+  size_t n, size;
+  size_t block;                 /* elements per block */
+  uint64_t key;
+
+  unsigned int level;           /* 0 for the blocks */
+  size_t first_task, n_tasks;
+} RandShuffleJob;
+
+static void *
+rand_shuffle_tasks (void *data)
+{
+  RandShuffleJob *job = data;
+  SnippetsRand *rand;
+  uint32_t counter[4];
+  size_t t, width, lo, hi;
+
+  rand = snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_PHILOX4X32,
+      job->key);
+
+  for (t = job->first_task; t < job->first_task + job->n_tasks; t++) {
+    counter[0] = 0;
+    counter[1] = 0;
+    counter[2] = (uint32_t) t;
+    counter[3] = ((uint64_t) t >> 32) | (job->level << 16);
+    philox4x32_set_position (&rand->state.philox4x32, counter, 0);
+
+    if (job->level == 0) {
+      lo = t * job->block;
+      hi = lo + job->block < job->n ? lo + job->block : job->n;
+      rand_shuffle_fisher_yates (rand, job->base + lo * job->size, hi - lo,
+          job->size);
+    } else {
+      width = job->block << (job->level - 1);
+      lo = t * 2 * width;
+      hi = lo + 2 * width < job->n ? lo + 2 * width : job->n;
+      rand_shuffle_merge (rand, job->base, lo, lo + width, hi, job->size);
+    }
+  }
+
+  snippets_rand_free (rand);
+
+  return NULL;
+}
+
+/* Runs the tasks of a level, split over up to @n_threads threads */
+static void
+rand_shuffle_level (const RandShuffleJob * level, size_t n_tasks,
+    unsigned int n_threads)
+{
+  RandShuffleJob *jobs;
+  size_t first_task;
+  unsigned int i;
+#ifdef HAVE_PTHREAD
+  pthread_t *threads;
+  int *started;
+#endif
+
+  if (n_threads > n_tasks)
+    n_threads = n_tasks;
+#ifndef HAVE_PTHREAD
+  n_threads = 1;
+#endif
+
+  jobs = calloc (n_threads, sizeof (RandShuffleJob));
+
+  first_task = 0;
+  for (i = 0; i < n_threads; i++) {
+    jobs[i] = *level;
+    jobs[i].first_task = first_task;
+    jobs[i].n_tasks = n_tasks / n_threads + (i < n_tasks % n_threads);
+    first_task += jobs[i].n_tasks;
+  }
+
+#ifdef HAVE_PTHREAD
+  /* Like for snippets_fnv_tree() the first job runs in the calling
+   * thread, as do the jobs for which no thread could be started */
+  threads = calloc (n_threads, sizeof (pthread_t));
+  started = calloc (n_threads, sizeof (int));
+
+  for (i = 1; i < n_threads; i++)
+    started[i] =
+        (pthread_create (&threads[i], NULL, rand_shuffle_tasks,
+            &jobs[i]) == 0);
+  rand_shuffle_tasks (&jobs[0]);
+  for (i = 1; i < n_threads; i++) {
+    if (started[i])
+      pthread_join (threads[i], NULL);
+    else
+      rand_shuffle_tasks (&jobs[i]);
+  }
+
+  free (started);
+  free (threads);
+#else
+  rand_shuffle_tasks (&jobs[0]);
+#endif
+
+  free (jobs);
+}
+
+void
+snippets_rand_shuffle_parallel (SnippetsRand * rand, void *base, size_t n,
+    size_t elem_size, unsigned int n_threads)
+{
+  RandShuffleJob level;
+  size_t width;
+
+  assert (rand != NULL);
+  assert (base != NULL || n == 0);
+  assert (elem_size > 0);
+  assert (n_threads > 0);
+
+  if (n * elem_size <= SHUFFLE_MERGE_SIZE) {
+    rand_shuffle_fisher_yates (rand, base, n, elem_size);
+    return;
+  }
+
+  memset (&level, 0, sizeof (level));
+  level.base = base;
+  level.n = n;
+  level.size = elem_size;
+  level.block = SHUFFLE_BLOCK_SIZE / elem_size;
+  if (level.block < 2)
+    level.block = 2;
+  level.key = rand_uint64 (rand);
+
+  level.level = 0;
+  rand_shuffle_level (&level, (n + level.block - 1) / level.block, n_threads);
+
+  for (width = level.block; width < n; width *= 2) {
+    level.level++;
+    rand_shuffle_level (&level, (n - width + 2 * width - 1) / (2 * width),
+        n_threads);
+  }
+}
+
+void
+snippets_rand_shuffle (SnippetsRand * rand, void *base, size_t n,
+    size_t elem_size)
+{
+  snippets_rand_shuffle_parallel (rand, base, n, elem_size, 1);
+}
+
+void
+snippets_rand_permutation (SnippetsRand * rand, uint32_t * out, uint32_t n)
+{
+  uint32_t i;
+
+  assert (rand != NULL);
+  assert (out != NULL || n == 0);
+
+  for (i = 0; i < n; i++)
+    out[i] = i;
+
+  snippets_rand_shuffle (rand, out, n, sizeof (uint32_t));
+}
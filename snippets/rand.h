@@ -26,14 +26,229 @@ SNIPPETS_BEGIN_DECLS
 
 typedef struct _SnippetsRand SnippetsRand;
 
+/** SnippetsRandEngine:
+ *  @SNIPPETS_RAND_ENGINE_MT19937: MT19937 mersenne twister, 2.5 KB
+ *    state, the default
+ *  @SNIPPETS_RAND_ENGINE_XOSHIRO256SS: xoshiro256**, 32 byte state
+ *  @SNIPPETS_RAND_ENGINE_PCG64: PCG64 (XSL RR 128/64), 32 byte state
+ *  @SNIPPETS_RAND_ENGINE_SPLITMIX64: SplitMix64, 8 byte state
+ *  @SNIPPETS_RAND_ENGINE_PHILOX4X32: Philox4x32-10 counter-based
+ *    generator, the seed is the key and the counter starts at 0. See
+ *    snippets_philox4x32_10_fill() for calculating any part of the
+ *    stream directly
+ *
+ *  Pseudo random number generator engine. The engines other than
+ *  MT19937 are 64 bit generators that are much cheaper to create. They
+ *  use the upper 32 bits of their output for 32 bit numbers and the
+ *  upper 53 bits for doubles.
+ */
+typedef enum {
+  SNIPPETS_RAND_ENGINE_MT19937 = 0,
+  SNIPPETS_RAND_ENGINE_XOSHIRO256SS,
+  SNIPPETS_RAND_ENGINE_PCG64,
+  SNIPPETS_RAND_ENGINE_SPLITMIX64,
+  SNIPPETS_RAND_ENGINE_PHILOX4X32
+} SnippetsRandEngine;
+
 SnippetsRand * snippets_rand_new          (uint32_t seed);
+
+/** snippets_rand_new_with_engine:
+ *  @engine: the engine
+ *  @seed: the seed
+ *
+ *  Creates a generator with @engine. MT19937 uses the reference
+ *  init_genrand() for seeds below 2^32 and init_by_array() with the
+ *  lower and upper half for larger seeds.
+ */
+SnippetsRand * snippets_rand_new_with_engine (SnippetsRandEngine engine, uint64_t seed);
+
+/** snippets_rand_new_from_array:
+ *  @key: array of @key_length numbers
+ *  @key_length: length of @key, at least 1
+ *
+ *  Creates an MT19937 generator with the reference init_by_array(),
+ *  which can reach far more than the 2^32 states of a single 32 bit
+ *  seed, e.g. with a job id and a worker id as key.
+ */
+SnippetsRand * snippets_rand_new_from_array (const uint32_t *key, size_t key_length);
+
+/** snippets_rand_new_entropy:
+ *
+ *  Creates an MT19937 generator that is initialized with
+ *  init_by_array() from 624 words of the entropy source of the system
+ *  (getrandom() or /dev/urandom), mixed with the time and the thread
+ *  id. Generators created at the same time in different processes or
+ *  threads get unrelated states.
+ */
+SnippetsRand * snippets_rand_new_entropy  (void);
+
+/** snippets_rand_new_entropy_with_engine:
+ *  @engine: the engine
+ *
+ *  Like snippets_rand_new_entropy() for any engine. The whole state of
+ *  the 64 bit engines comes from the entropy, for Philox4x32 the key
+ *  and the upper half of the counter.
+ */
+SnippetsRand * snippets_rand_new_entropy_with_engine (SnippetsRandEngine engine);
+SnippetsRandEngine snippets_rand_get_engine (SnippetsRand *rand);
 void           snippets_rand_free         (SnippetsRand *rand);
 
+/** snippets_rand_thread_default:
+ *
+ *  Returns the generator of the calling thread, which is created on
+ *  the first call in each thread and freed when the thread exits. It
+ *  is a xoshiro256** generator seeded from the entropy source of the
+ *  system and the thread id, so different threads and processes get
+ *  different numbers. It must not be freed or used by other threads.
+ *  See <snippets/rand-inline.h> for inline access.
+ */
+SnippetsRand * snippets_rand_thread_default (void);
+
+/** snippets_rand_jump:
+ *  @rand: the generator
+ *  @log2_steps: k to advance by 2^k steps
+ *
+ *  Advances @rand as if 2^k numbers were generated and discarded. A
+ *  step is a snippets_rand_uint32() for MT19937 and one 64 bit output
+ *  for the other engines. MT19937 and xoshiro256** use jump
+ *  polynomials, which takes k polynomial squarings plus about 20000
+ *  (MT19937) or 256 (xoshiro256**) steps. PCG64 takes O(k) and
+ *  SplitMix64 and Philox4x32 O(1).
+ */
+void           snippets_rand_jump         (SnippetsRand *rand, unsigned int log2_steps);
+
+/** snippets_rand_split:
+ *  @rand: the generator
+ *  @n_streams: number of generators to create
+ *  @streams: array of @n_streams for the new generators
+ *
+ *  Creates @n_streams generators for non-overlapping substreams of
+ *  @rand, e.g. for one generator per thread, and jumps @rand past all
+ *  of them. The substreams are 2^128 steps long for MT19937 and
+ *  xoshiro256**, 2^96 for PCG64 and Philox4x32 and 2^48 for
+ *  SplitMix64.
+ */
+void           snippets_rand_split        (SnippetsRand *rand, unsigned int n_streams, SnippetsRand **streams);
+
+/** snippets_rand_save:
+ *  @rand: the generator
+ *  @buf: buffer of snippets_rand_get_save_size() bytes
+ *
+ *  Serializes the state of @rand, so that snippets_rand_restore()
+ *  creates a generator that continues exactly where @rand is now. The
+ *  format is versioned and has the same byte order on all platforms,
+ *  4 header bytes and 2.5 KB for MT19937, 8 to 32 bytes for the other
+ *  engines.
+ */
+size_t         snippets_rand_get_save_size (SnippetsRand *rand);
+void           snippets_rand_save         (SnippetsRand *rand, uint8_t *buf);
+
+/** snippets_rand_restore:
+ *  @buf: data from snippets_rand_save()
+ *  @len: length of @buf
+ *
+ *  Creates a generator from the saved state in @buf, or returns %NULL
+ *  if @buf is not a valid saved state of a supported version.
+ */
+SnippetsRand * snippets_rand_restore      (const uint8_t *buf, size_t len);
+
 uint32_t       snippets_rand_uint32       (SnippetsRand *rand);
+uint64_t       snippets_rand_uint64       (SnippetsRand *rand);
+
+/** snippets_rand_uint32_range:
+ *  @rand: the generator
+ *  @min: lower bound, inclusive
+ *  @max: upper bound, exclusive
+ *
+ *  Returns a uniformly distributed number in [@min, @max), or @min if
+ *  both are equal. Uses a multiplication instead of a division and
+ *  rejects the few numbers that would bias the result, which needs
+ *  more than one number from the engine with a probability of
+ *  (2^32 % (@max - @min)) / 2^32.
+ */
 uint32_t       snippets_rand_uint32_range (SnippetsRand *rand, uint32_t min, uint32_t max);
+
 double         snippets_rand_double       (SnippetsRand *rand);
 double         snippets_rand_double_range (SnippetsRand *rand, double min, double max);
 
+void           snippets_rand_fill_uint32       (SnippetsRand *rand, uint32_t *buf, size_t n);
+
+/** snippets_rand_fill_uint32_range:
+ *  @rand: the generator
+ *  @buf: array of @n numbers
+ *  @n: number of numbers
+ *  @min: lower bound, inclusive
+ *  @max: upper bound, exclusive
+ *
+ *  Fills @buf with the same numbers as @n calls to
+ *  snippets_rand_uint32_range().
+ */
+void           snippets_rand_fill_uint32_range (SnippetsRand *rand, uint32_t *buf, size_t n, uint32_t min, uint32_t max);
+
+void           snippets_rand_fill_double       (SnippetsRand *rand, double *buf, size_t n);
+void           snippets_rand_fill_double_range (SnippetsRand *rand, double *buf, size_t n, double min, double max);
+
+/** snippets_rand_normal:
+ *  @rand: the generator
+ *  @mean: mean of the distribution
+ *  @stddev: standard deviation of the distribution
+ *
+ *  Returns a normally distributed number. Uses the ziggurat method,
+ *  which needs a single 32 bit number, a table lookup and a
+ *  multiplication for about 99% of the numbers.
+ */
+double         snippets_rand_normal            (SnippetsRand *rand, double mean, double stddev);
+
+/** snippets_rand_exponential:
+ *  @rand: the generator
+ *  @lambda: rate of the distribution, the mean is 1 / @lambda
+ *
+ *  Returns an exponentially distributed number, with the ziggurat
+ *  method like snippets_rand_normal().
+ */
+double         snippets_rand_exponential       (SnippetsRand *rand, double lambda);
+
+void           snippets_rand_fill_normal       (SnippetsRand *rand, double *buf, size_t n, double mean, double stddev);
+void           snippets_rand_fill_exponential  (SnippetsRand *rand, double *buf, size_t n, double lambda);
+
+/** snippets_rand_shuffle:
+ *  @rand: the generator
+ *  @base: array of @n elements
+ *  @n: number of elements
+ *  @elem_size: size of an element
+ *
+ *  Shuffles @base in place, every permutation is equally likely. Small
+ *  arrays use Fisher-Yates, with up to four unbiased indices from a
+ *  single 64 bit number. Arrays above 32 MB are shuffled in
+ *  cache-sized blocks that are then merged with MergeShuffle, which
+ *  accesses the memory sequentially and needs about one random bit per
+ *  element and level.
+ */
+void           snippets_rand_shuffle           (SnippetsRand *rand, void *base, size_t n, size_t elem_size);
+
+/** snippets_rand_shuffle_parallel:
+ *  @rand: the generator
+ *  @base: array of @n elements
+ *  @n: number of elements
+ *  @elem_size: size of an element
+ *  @n_threads: number of threads to use
+ *
+ *  Like snippets_rand_shuffle(), with the blocks and the merges of each
+ *  level distributed over up to @n_threads threads if threads are
+ *  supported. The result is the same as from snippets_rand_shuffle()
+ *  and never depends on @n_threads.
+ */
+void           snippets_rand_shuffle_parallel  (SnippetsRand *rand, void *base, size_t n, size_t elem_size, unsigned int n_threads);
+
+/** snippets_rand_permutation:
+ *  @rand: the generator
+ *  @out: array of @n numbers
+ *  @n: number of numbers
+ *
+ *  Fills @out with a random permutation of 0 to @n - 1.
+ */
+void           snippets_rand_permutation       (SnippetsRand *rand, uint32_t *out, uint32_t n);
+
 SNIPPETS_END_DECLS
 
 #endif /* __SNIPPETS_RAND_H__ */
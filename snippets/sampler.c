@@ -0,0 +1,664 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <snippets/sampler.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Weighted sampling with Vose's alias method, see "A Linear Algorithm
+ * For Generating Random Numbers With a Given Distribution" by
+ * Michael D. Vose in IEEE Transactions on Software Engineering,
+ * Volume 17, Number 9 (1991), or
+ *
+ * http://www.keithschwarz.com/darts-dice-coins/
+ *
+ * Every entry of the table is selected with probability 1/n and then
+ * returns its own index with the probability stored in the entry,
+ * otherwise its alias. The weights are scaled so that their mean is
+ * 1, entries with a weight below 1 get the excess of an entry with a
+ * weight above 1 as alias until all are filled up.
+ */
+
+typedef struct
+{
+  uint32_t threshold;           /* probability * 2^32 */
+  uint32_t alias;
+} AliasEntry;
+
+struct _SnippetsWeightedSampler
+{
+  uint32_t n;
+  double *weights;
+  int dirty;
+
+  AliasEntry *table;
+
+  /* Scratch space for building the table */
+  double *scaled;
+  uint32_t *work;
+};
+
+static inline void
+alias_entry_set (AliasEntry * entry, double p, uint32_t alias)
+{
+  double t = p * 4294967296.0;
+
+  if (t <= 0)
+    entry->threshold = 0;
+  else if (t < 4294967295.0)
+    entry->threshold = t;
+  else
+    entry->threshold = 0xffffffff;
+  entry->alias = alias;
+}
+
+static void
+weighted_sampler_build (SnippetsWeightedSampler * sampler)
+{
+  uint32_t n = sampler->n, i, s, l;
+  uint32_t *work = sampler->work;
+  double *p = sampler->scaled;
+  double sum = 0;
+  /* Small entries are on a stack at the start of work, large ones on
+   * a stack growing down from its end */
+  uint32_t n_small = 0, large = n;
+
+  for (i = 0; i < n; i++)
+    sum += sampler->weights[i];
+  assert (sum > 0 && "All weights are zero");
+
+  for (i = 0; i < n; i++) {
+    p[i] = sampler->weights[i] * n / sum;
+    if (p[i] < 1.0)
+      work[n_small++] = i;
+    else
+      work[--large] = i;
+  }
+
+  while (n_small > 0 && large < n) {
+    s = work[--n_small];
+    l = work[large];
+
+    alias_entry_set (&sampler->table[s], p[s], l);
+    p[l] = (p[l] + p[s]) - 1.0;
+    if (p[l] < 1.0) {
+      large++;
+      work[n_small++] = l;
+    }
+  }
+
+  /* What is left has probability 1, up to rounding errors */
+  while (large < n) {
+    l = work[large++];
+    alias_entry_set (&sampler->table[l], 1.0, l);
+  }
+  while (n_small > 0) {
+    s = work[--n_small];
+    alias_entry_set (&sampler->table[s], 1.0, s);
+  }
+
+  sampler->dirty = FALSE;
+}
+
+SnippetsWeightedSampler *
+snippets_weighted_sampler_new (const double *weights, uint32_t n)
+{
+  SnippetsWeightedSampler *sampler;
+  uint32_t i;
+
+  assert (weights != NULL);
+  assert (n > 0);
+
+  for (i = 0; i < n; i++)
+    assert (weights[i] >= 0);
+
+  sampler = calloc (sizeof (SnippetsWeightedSampler), 1);
+  sampler->n = n;
+  sampler->weights = malloc (n * sizeof (double));
+  memcpy (sampler->weights, weights, n * sizeof (double));
+  sampler->table = malloc (n * sizeof (AliasEntry));
+  sampler->scaled = malloc (n * sizeof (double));
+  sampler->work = malloc (n * sizeof (uint32_t));
+
+  weighted_sampler_build (sampler);
+
+  return sampler;
+}
+
+void
+snippets_weighted_sampler_free (SnippetsWeightedSampler * sampler)
+{
+  assert (sampler != NULL);
+
+  free (sampler->weights);
+  free (sampler->table);
+  free (sampler->scaled);
+  free (sampler->work);
+  free (sampler);
+}
+
+uint32_t
+snippets_weighted_sampler_get_size (SnippetsWeightedSampler * sampler)
+{
+  assert (sampler != NULL);
+
+  return sampler->n;
+}
+
+double
+snippets_weighted_sampler_get_weight (SnippetsWeightedSampler * sampler,
+    uint32_t index)
+{
+  assert (sampler != NULL);
+  assert (index < sampler->n);
+
+  return sampler->weights[index];
+}
+
+void
+snippets_weighted_sampler_set_weight (SnippetsWeightedSampler * sampler,
+    uint32_t index, double weight)
+{
+  assert (sampler != NULL);
+  assert (index < sampler->n);
+  assert (weight >= 0);
+
+  sampler->weights[index] = weight;
+  sampler->dirty = TRUE;
+}
+
+/* The upper half of r * n is the entry, the lower half is uniform
+ * with a resolution of n / 2^32 */
+static inline uint32_t
+weighted_sampler_lookup (const AliasEntry * table, uint32_t n, uint32_t r)
+{
+  uint64_t m = (uint64_t) r * n;
+  uint32_t i = m >> 32;
+
+  return (uint32_t) m < table[i].threshold ? i : table[i].alias;
+}
+
+uint32_t
+snippets_weighted_sampler_sample (SnippetsWeightedSampler * sampler,
+    SnippetsRand * rand)
+{
+  assert (sampler != NULL);
+  assert (rand != NULL);
+
+  if (sampler->dirty)
+    weighted_sampler_build (sampler);
+
+  return weighted_sampler_lookup (sampler->table, sampler->n,
+      snippets_rand_uint32 (rand));
+}
+
+void
+snippets_weighted_sampler_fill (SnippetsWeightedSampler * sampler,
+    SnippetsRand * rand, uint32_t * buf, size_t n)
+{
+  const AliasEntry *table;
+  uint32_t size;
+  size_t i;
+
+  assert (sampler != NULL);
+  assert (rand != NULL);
+  assert (buf != NULL || n == 0);
+
+  if (sampler->dirty)
+    weighted_sampler_build (sampler);
+
+  table = sampler->table;
+  size = sampler->n;
+
+  snippets_rand_fill_uint32 (rand, buf, n);
+  for (i = 0; i < n; i++)
+    buf[i] = weighted_sampler_lookup (table, size, buf[i]);
+}
+
+/* Item storage of the reservoirs, the same as the nodes of
+ * SnippetsLinkedList: either data_size bytes per item or a pointer */
+typedef struct
+{
+  uint8_t *data;
+  size_t elem_size;
+  int pointer;
+
+  SnippetsCopyToFunction copy_func;
+  SnippetsFreeFunction free_func;
+} ReservoirItems;
+
+static void
+reservoir_items_init (ReservoirItems * items, uint32_t capacity,
+    size_t data_size, SnippetsCopyToFunction copy_func,
+    SnippetsFreeFunction free_func, int pointer)
+{
+  items->pointer = pointer;
+  items->elem_size = pointer ? sizeof (void *) : data_size;
+  items->data = calloc (capacity, items->elem_size);
+  items->copy_func = copy_func;
+  items->free_func = free_func;
+}
+
+static inline void *
+reservoir_items_get (const ReservoirItems * items, uint32_t index)
+{
+  uint8_t *item = items->data + index * items->elem_size;
+
+  return items->pointer ? *(void **) item : item;
+}
+
+static void
+reservoir_items_release (ReservoirItems * items, uint32_t index)
+{
+  void *data;
+
+  if (!items->free_func)
+    return;
+
+  data = reservoir_items_get (items, index);
+  if (data)
+    items->free_func (data);
+}
+
+static void
+reservoir_items_set (ReservoirItems * items, uint32_t index, void *data)
+{
+  uint8_t *item = items->data + index * items->elem_size;
+
+  if (items->copy_func)
+    items->copy_func (item, data);
+  else if (items->pointer)
+    *(void **) item = data;
+  else
+    memcpy (item, data, items->elem_size);
+}
+
+static void
+reservoir_items_clear (ReservoirItems * items, uint32_t length)
+{
+  uint32_t i;
+
+  for (i = 0; i < length; i++)
+    reservoir_items_release (items, i);
+  free (items->data);
+}
+
+/* Uniform on (0, 1], for taking the logarithm */
+static inline double
+reservoir_uniform (SnippetsRand * rand)
+{
+  return 1.0 - snippets_rand_double (rand);
+}
+
+/* Reservoir sampling with Algorithm L, see "Reservoir-Sampling
+ * Algorithms of Time Complexity O(n(1 + log(N/n)))" by Kim-Hung Li in
+ * ACM Transactions on Mathematical Software, Volume 20, Number 4
+ * (1994).
+ *
+ * W is the largest of capacity uniform numbers, for which the number
+ * of items until the next one with a smaller number is geometric
+ * with parameter 1 - W. Once the reservoir is full only those items
+ * are taken, and W is updated with the new numbers in the reservoir.
+ * W is kept as logarithm as it goes towards 0 for long streams.
+ */
+
+struct _SnippetsReservoir
+{
+  ReservoirItems items;
+  uint32_t capacity, length;
+
+  uint64_t n_seen;
+  uint64_t next;                /* n_seen of the next item to take */
+  double log_w;
+};
+
+static void
+reservoir_skip (SnippetsReservoir * reservoir, SnippetsRand * rand)
+{
+  double skip;
+
+  reservoir->log_w += log (reservoir_uniform (rand)) / reservoir->capacity;
+  skip =
+      floor (log (reservoir_uniform (rand)) / log1p (-exp (reservoir->log_w)));
+
+  /* Never for all practical purposes */
+  if (skip >= 9223372036854775808.0
+      || (uint64_t) skip > 0xffffffffffffffffULL - reservoir->n_seen)
+    reservoir->next = 0xffffffffffffffffULL;
+  else
+    reservoir->next = reservoir->n_seen + (uint64_t) skip;
+}
+
+static SnippetsReservoir *
+reservoir_new (uint32_t capacity, size_t data_size,
+    SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func,
+    int pointer)
+{
+  SnippetsReservoir *reservoir;
+
+  assert (capacity > 0);
+
+  reservoir = calloc (sizeof (SnippetsReservoir), 1);
+  reservoir->capacity = capacity;
+  reservoir_items_init (&reservoir->items, capacity, data_size, copy_func,
+      free_func, pointer);
+
+  return reservoir;
+}
+
+SnippetsReservoir *
+snippets_reservoir_new (uint32_t capacity, size_t data_size,
+    SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func)
+{
+  assert (data_size != 0);
+
+  return reservoir_new (capacity, data_size, copy_func, free_func, FALSE);
+}
+
+SnippetsReservoir *
+snippets_reservoir_new_pointer (uint32_t capacity,
+    SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func)
+{
+  return reservoir_new (capacity, 0, copy_func, free_func, TRUE);
+}
+
+void
+snippets_reservoir_free (SnippetsReservoir * reservoir)
+{
+  assert (reservoir != NULL);
+
+  reservoir_items_clear (&reservoir->items, reservoir->length);
+  free (reservoir);
+}
+
+/* Takes the item with index n_seen */
+static void
+reservoir_take (SnippetsReservoir * reservoir, SnippetsRand * rand,
+    void *data)
+{
+  uint32_t index;
+
+  if (reservoir->length < reservoir->capacity) {
+    reservoir_items_set (&reservoir->items, reservoir->length++, data);
+    reservoir->n_seen++;
+    if (reservoir->length == reservoir->capacity)
+      reservoir_skip (reservoir, rand);
+    return;
+  }
+
+  index = snippets_rand_uint32_range (rand, 0, reservoir->capacity);
+  reservoir_items_release (&reservoir->items, index);
+  reservoir_items_set (&reservoir->items, index, data);
+  reservoir->n_seen++;
+  reservoir_skip (reservoir, rand);
+}
+
+int
+snippets_reservoir_add (SnippetsReservoir * reservoir, SnippetsRand * rand,
+    void *data)
+{
+  assert (reservoir != NULL);
+  assert (rand != NULL);
+
+  if (reservoir->length == reservoir->capacity
+      && reservoir->n_seen != reservoir->next) {
+    reservoir->n_seen++;
+    return FALSE;
+  }
+
+  reservoir_take (reservoir, rand, data);
+  return TRUE;
+}
+
+void
+snippets_reservoir_add_array (SnippetsReservoir * reservoir,
+    SnippetsRand * rand, void *data, size_t n)
+{
+  uint8_t *items = data;
+  size_t elem_size, i = 0;
+  uint64_t skip;
+
+  assert (reservoir != NULL);
+  assert (rand != NULL);
+  assert (data != NULL || n == 0);
+
+  elem_size = reservoir->items.elem_size;
+
+  while (i < n) {
+    if (reservoir->length == reservoir->capacity) {
+      skip = reservoir->next - reservoir->n_seen;
+      if (skip >= n - i) {
+        reservoir->n_seen += n - i;
+        break;
+      }
+      reservoir->n_seen += skip;
+      i += skip;
+    }
+
+    reservoir_take (reservoir, rand, reservoir->items.pointer ?
+        ((void **) items)[i] : items + i * elem_size);
+    i++;
+  }
+}
+
+uint32_t
+snippets_reservoir_length (SnippetsReservoir * reservoir)
+{
+  assert (reservoir != NULL);
+
+  return reservoir->length;
+}
+
+uint64_t
+snippets_reservoir_n_seen (SnippetsReservoir * reservoir)
+{
+  assert (reservoir != NULL);
+
+  return reservoir->n_seen;
+}
+
+void *
+snippets_reservoir_get_ (SnippetsReservoir * reservoir, uint32_t index)
+{
+  assert (reservoir != NULL);
+  assert (index < reservoir->length);
+
+  return reservoir_items_get (&reservoir->items, index);
+}
+
+/* Weighted reservoir sampling with A-ExpJ, see "Weighted random
+ * sampling with a reservoir" by Pavlos S. Efraimidis and Paul G.
+ * Spirakis in Information Processing Letters, Volume 97, Number 5
+ * (2006).
+ *
+ * The keys are kept as logarithms, log (u) / weight, in a min-heap of
+ * the reservoir's items. The item that replaces the smallest key T is
+ * found by skipping log (u) / log (T) of weight, and its key is
+ * then drawn from the part of the distribution above T.
+ */
+
+typedef struct
+{
+  double key;
+  uint32_t index;
+} ReservoirKey;
+
+struct _SnippetsWeightedReservoir
+{
+  ReservoirItems items;
+  uint32_t capacity, length;
+  ReservoirKey *heap;
+
+  uint64_t n_seen;
+  double skip;                  /* weight until the next item to take */
+};
+
+static void
+weighted_reservoir_sift_up (ReservoirKey * heap, uint32_t i)
+{
+  ReservoirKey k = heap[i];
+  uint32_t parent;
+
+  while (i > 0) {
+    parent = (i - 1) / 2;
+    if (heap[parent].key <= k.key)
+      break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = k;
+}
+
+static void
+weighted_reservoir_sift_down (ReservoirKey * heap, uint32_t n, uint32_t i)
+{
+  ReservoirKey k = heap[i];
+  uint32_t child;
+
+  while ((child = 2 * i + 1) < n) {
+    if (child + 1 < n && heap[child + 1].key < heap[child].key)
+      child++;
+    if (k.key <= heap[child].key)
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = k;
+}
+
+static SnippetsWeightedReservoir *
+weighted_reservoir_new (uint32_t capacity, size_t data_size,
+    SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func,
+    int pointer)
+{
+  SnippetsWeightedReservoir *reservoir;
+
+  assert (capacity > 0);
+
+  reservoir = calloc (sizeof (SnippetsWeightedReservoir), 1);
+  reservoir->capacity = capacity;
+  reservoir->heap = malloc (capacity * sizeof (ReservoirKey));
+  reservoir_items_init (&reservoir->items, capacity, data_size, copy_func,
+      free_func, pointer);
+
+  return reservoir;
+}
+
+SnippetsWeightedReservoir *
+snippets_weighted_reservoir_new (uint32_t capacity, size_t data_size,
+    SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func)
+{
+  assert (data_size != 0);
+
+  return weighted_reservoir_new (capacity, data_size, copy_func, free_func,
+      FALSE);
+}
+
+SnippetsWeightedReservoir *
+snippets_weighted_reservoir_new_pointer (uint32_t capacity,
+    SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func)
+{
+  return weighted_reservoir_new (capacity, 0, copy_func, free_func, TRUE);
+}
+
+void
+snippets_weighted_reservoir_free (SnippetsWeightedReservoir * reservoir)
+{
+  assert (reservoir != NULL);
+
+  reservoir_items_clear (&reservoir->items, reservoir->length);
+  free (reservoir->heap);
+  free (reservoir);
+}
+
+int
+snippets_weighted_reservoir_add (SnippetsWeightedReservoir * reservoir,
+    SnippetsRand * rand, void *data, double weight)
+{
+  ReservoirKey *heap;
+  double t;
+
+  assert (reservoir != NULL);
+  assert (rand != NULL);
+  assert (weight >= 0);
+
+  reservoir->n_seen++;
+  if (weight == 0)
+    return FALSE;
+
+  heap = reservoir->heap;
+
+  if (reservoir->length < reservoir->capacity) {
+    heap[reservoir->length].key = log (reservoir_uniform (rand)) / weight;
+    heap[reservoir->length].index = reservoir->length;
+    reservoir_items_set (&reservoir->items, reservoir->length, data);
+    weighted_reservoir_sift_up (heap, reservoir->length++);
+  } else {
+    reservoir->skip -= weight;
+    if (reservoir->skip > 0)
+      return FALSE;
+
+    /* u uniform on (T^weight, 1] */
+    t = exp (weight * heap[0].key);
+    heap[0].key = log (t + (1.0 - t) * reservoir_uniform (rand)) / weight;
+    reservoir_items_release (&reservoir->items, heap[0].index);
+    reservoir_items_set (&reservoir->items, heap[0].index, data);
+    weighted_reservoir_sift_down (heap, reservoir->length, 0);
+  }
+
+  /* Nothing can replace a key of log (1) */
+  if (reservoir->length == reservoir->capacity)
+    reservoir->skip = heap[0].key < 0 ?
+        log (reservoir_uniform (rand)) / heap[0].key : HUGE_VAL;
+
+  return TRUE;
+}
+
+uint32_t
+snippets_weighted_reservoir_length (SnippetsWeightedReservoir * reservoir)
+{
+  assert (reservoir != NULL);
+
+  return reservoir->length;
+}
+
+uint64_t
+snippets_weighted_reservoir_n_seen (SnippetsWeightedReservoir * reservoir)
+{
+  assert (reservoir != NULL);
+
+  return reservoir->n_seen;
+}
+
+void *
+snippets_weighted_reservoir_get_ (SnippetsWeightedReservoir * reservoir,
+    uint32_t index)
+{
+  assert (reservoir != NULL);
+  assert (index < reservoir->length);
+
+  return reservoir_items_get (&reservoir->items, index);
+}
@@ -0,0 +1,161 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SNIPPETS_SAMPLER_H__
+#define __SNIPPETS_SAMPLER_H__
+
+#include <snippets/utils.h>
+#include <snippets/rand.h>
+
+SNIPPETS_BEGIN_DECLS
+
+typedef struct _SnippetsWeightedSampler SnippetsWeightedSampler;
+typedef struct _SnippetsReservoir SnippetsReservoir;
+typedef struct _SnippetsWeightedReservoir SnippetsWeightedReservoir;
+
+/** snippets_weighted_sampler_new:
+ *  @weights: array of @n non-negative weights, at least one must be
+ *    positive
+ *  @n: number of weights
+ *
+ *  Creates a sampler that returns index i with probability
+ *  @weights[i] / sum (@weights). Builds a Vose alias table in O(@n),
+ *  after which every sample takes O(1) and a single
+ *  snippets_rand_uint32(). The upper half of the number times @n
+ *  selects the table entry and the lower half decides between the
+ *  entry and its alias, so the probabilities are exact up to
+ *  @n / 2^32.
+ */
+SnippetsWeightedSampler * snippets_weighted_sampler_new    (const double *weights, uint32_t n);
+void          snippets_weighted_sampler_free               (SnippetsWeightedSampler *sampler);
+
+uint32_t      snippets_weighted_sampler_get_size           (SnippetsWeightedSampler *sampler);
+double        snippets_weighted_sampler_get_weight         (SnippetsWeightedSampler *sampler, uint32_t index);
+
+/** snippets_weighted_sampler_set_weight:
+ *  @sampler: the sampler
+ *  @index: index of the weight
+ *  @weight: new non-negative weight
+ *
+ *  Changes a weight. The alias table is rebuilt by the next sample, so
+ *  that any number of updates in a row only cost one rebuild.
+ */
+void          snippets_weighted_sampler_set_weight         (SnippetsWeightedSampler *sampler, uint32_t index, double weight);
+
+uint32_t      snippets_weighted_sampler_sample             (SnippetsWeightedSampler *sampler, SnippetsRand *rand);
+
+/** snippets_weighted_sampler_fill:
+ *  @sampler: the sampler
+ *  @rand: the generator
+ *  @buf: array of @n indices
+ *  @n: number of samples
+ *
+ *  Fills @buf with the same indices as @n calls to
+ *  snippets_weighted_sampler_sample().
+ */
+void          snippets_weighted_sampler_fill               (SnippetsWeightedSampler *sampler, SnippetsRand *rand, uint32_t *buf, size_t n);
+
+/** snippets_reservoir_new:
+ *  @capacity: number of items to keep
+ *  @data_size: size of an item
+ *  @copy_func: function to copy an item into the reservoir, or %NULL
+ *    for memcpy()
+ *  @free_func: function to release an item that is replaced or still
+ *    in the reservoir when it is freed, or %NULL
+ *
+ *  Creates a reservoir that keeps a uniform random sample of
+ *  @capacity items from a stream of unknown length, stored inline like
+ *  the items of a #SnippetsLinkedList. Uses Li's Algorithm L, which
+ *  calculates how many items to skip until the next one is taken, so
+ *  that most items only cost a comparison and no random number.
+ *  snippets_reservoir_new_pointer() stores pointers instead.
+ */
+SnippetsReservoir * snippets_reservoir_new         (uint32_t capacity, size_t data_size, SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func);
+SnippetsReservoir * snippets_reservoir_new_pointer (uint32_t capacity, SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func);
+void          snippets_reservoir_free              (SnippetsReservoir *reservoir);
+
+/** snippets_reservoir_add:
+ *  @reservoir: the reservoir
+ *  @rand: the generator
+ *  @data: the item, or the pointer for pointer reservoirs
+ *
+ *  Offers the next item of the stream and returns %TRUE if it was
+ *  taken into the reservoir.
+ */
+int           snippets_reservoir_add               (SnippetsReservoir *reservoir, SnippetsRand *rand, void *data);
+
+/** snippets_reservoir_add_array:
+ *  @reservoir: the reservoir
+ *  @rand: the generator
+ *  @data: array of @n items, or of @n pointers for pointer reservoirs
+ *  @n: number of items
+ *
+ *  Offers @n items at once, which jumps directly to the items that are
+ *  taken. Gives the same result as @n calls to snippets_reservoir_add().
+ */
+void          snippets_reservoir_add_array         (SnippetsReservoir *reservoir, SnippetsRand *rand, void *data, size_t n);
+
+uint32_t      snippets_reservoir_length            (SnippetsReservoir *reservoir);
+uint64_t      snippets_reservoir_n_seen            (SnippetsReservoir *reservoir);
+
+#define snippets_reservoir_get(reservoir, index, __type) \
+  ((__type *) snippets_reservoir_get_ (reservoir, index))
+void *        snippets_reservoir_get_              (SnippetsReservoir *reservoir, uint32_t index);
+
+/** snippets_weighted_reservoir_new:
+ *  @capacity: number of items to keep
+ *  @data_size: size of an item
+ *  @copy_func: function to copy an item into the reservoir, or %NULL
+ *    for memcpy()
+ *  @free_func: function to release an item that is replaced or still
+ *    in the reservoir when it is freed, or %NULL
+ *
+ *  Creates a reservoir for a weighted random sample without
+ *  replacement, using the A-ExpJ algorithm by Efraimidis and Spirakis.
+ *  Every item gets the key u^(1/weight) and the @capacity items with
+ *  the largest keys are kept. Like snippets_reservoir_new() it
+ *  calculates how much weight to skip until the next item is taken,
+ *  which is the only time it needs random numbers.
+ */
+SnippetsWeightedReservoir * snippets_weighted_reservoir_new         (uint32_t capacity, size_t data_size, SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func);
+SnippetsWeightedReservoir * snippets_weighted_reservoir_new_pointer (uint32_t capacity, SnippetsCopyToFunction copy_func, SnippetsFreeFunction free_func);
+void          snippets_weighted_reservoir_free     (SnippetsWeightedReservoir *reservoir);
+
+/** snippets_weighted_reservoir_add:
+ *  @reservoir: the reservoir
+ *  @rand: the generator
+ *  @data: the item, or the pointer for pointer reservoirs
+ *  @weight: non-negative weight of the item, items with weight 0 are
+ *    never taken
+ *
+ *  Offers the next item of the stream and returns %TRUE if it was
+ *  taken into the reservoir.
+ */
+int           snippets_weighted_reservoir_add      (SnippetsWeightedReservoir *reservoir, SnippetsRand *rand, void *data, double weight);
+
+uint32_t      snippets_weighted_reservoir_length   (SnippetsWeightedReservoir *reservoir);
+uint64_t      snippets_weighted_reservoir_n_seen   (SnippetsWeightedReservoir *reservoir);
+
+#define snippets_weighted_reservoir_get(reservoir, index, __type) \
+  ((__type *) snippets_weighted_reservoir_get_ (reservoir, index))
+void *        snippets_weighted_reservoir_get_     (SnippetsWeightedReservoir *reservoir, uint32_t index);
+
+SNIPPETS_END_DECLS
+
+#endif /* __SNIPPETS_SAMPLER_H__ */
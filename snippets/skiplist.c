@@ -22,11 +22,10 @@
 #endif
 
 #include <snippets/skiplist.h>
-#include <snippets/rand.h>
+#include <snippets/rand-inline.h>
 
 #include <assert.h>
 #include <string.h>
-#include <time.h>
 
 #include <math.h>
 
@@ -41,8 +40,6 @@ struct _SnippetsSkipList
   unsigned int max_level;
   uint32_t p;                   /* p * 0xffffffff */
 
-  SnippetsRand *rand;
-
   size_t data_size;
   SnippetsCompareFunction compare_func;
   SnippetsCopyToFunction copy_func;
@@ -67,13 +64,12 @@ struct _SnippetsSkipListNode
     ((offset + (STRUCT_ALIGNMENT - 1)) & -STRUCT_ALIGNMENT)
 
 static unsigned int
-snippets_skip_list_get_random_level (SnippetsRand * rand,
-    unsigned int max_level, uint32_t p)
+snippets_skip_list_get_random_level (unsigned int max_level, uint32_t p)
 {
+  SnippetsRandThreadState *state = snippets_rand_thread_state ();
   unsigned int level = 1;
-  uint32_t r;
 
-  while ((r = snippets_rand_uint32 (rand)) <= p && level < max_level)
+  while (snippets_rand_thread_uint32 (state) <= p && level < max_level)
     level++;
 
   return level;
@@ -155,8 +151,6 @@ snippets_skip_list_new (unsigned int max_level, double p, size_t data_size,
   list->user_data_copy = user_data_copy;
   list->user_data_free = user_data_free;
 
-  list->rand = snippets_rand_new (time (0));
-
   list->head =
       snippets_skip_list_node_new (list, list->data_size, NULL, NULL,
       max_level);
@@ -188,8 +182,6 @@ snippets_skip_list_new_pointer (unsigned int max_level, double p,
   list->user_data_copy = user_data_copy;
   list->user_data_free = user_data_free;
 
-  list->rand = snippets_rand_new (time (0));
-
   list->head =
       snippets_skip_list_node_new (list, list->data_size, NULL, NULL,
       max_level);
@@ -210,7 +202,6 @@ snippets_skip_list_free (SnippetsSkipList * list)
     l = l->next;
     snippets_skip_list_node_free (m, list->free_func);
   }
-  snippets_rand_free (list->rand);
 
   if (list->user_data && list->user_data_free)
     list->user_data_free (list->user_data);
@@ -242,8 +233,6 @@ snippets_skip_list_copy (const SnippetsSkipList * list)
     copy->user_data_free = list->user_data_free;
   }
 
-  copy->rand = snippets_rand_new (time (0));
-
   /* TODO: Could build perfect skip list here by
    * choosing the optimal levels
    */
@@ -305,8 +294,7 @@ snippets_skip_list_insert (SnippetsSkipList * list, void *data)
     return nodes[0];
 
   level =
-      snippets_skip_list_get_random_level (list->rand, list->max_level,
-      list->p);
+      snippets_skip_list_get_random_level (list->max_level, list->p);
   node =
       snippets_skip_list_node_new (list, list->data_size, list->copy_func, data,
       level);
@@ -0,0 +1,46 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* SplitMix64 by Sebastiano Vigna, see
+ *
+ * http://prng.di.unimi.it/splitmix64.c
+ *
+ * 64 bits of state, mostly used for seeding the other engines.
+ */
+
+#define SPLITMIX64_GAMMA 0x9e3779b97f4a7c15ULL
+
+static inline uint64_t
+splitmix64_next (uint64_t * state)
+{
+  uint64_t z = (*state += SPLITMIX64_GAMMA);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+  return z ^ (z >> 31);
+}
+
+/* Advances by 2^k steps, the state is a counter with period 2^64 */
+static void
+splitmix64_jump (uint64_t * state, unsigned int k)
+{
+  if (k < 64)
+    *state += SPLITMIX64_GAMMA << k;
+}
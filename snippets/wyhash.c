@@ -0,0 +1,198 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <snippets/wyhash.h>
+
+#include <assert.h>
+#include <string.h>
+
+/* This implements wyhash final version 4 by Wang Yi, see
+ *
+ * https://github.com/wangyi-fudan/wyhash
+ *
+ * Input is consumed in 48 byte steps by three independent
+ * multiply-mix lanes, the remainder in 16 byte steps. Keys of up to
+ * 16 bytes are read with at most four overlapping loads.
+ */
+
+static const uint64_t wyhash_secret[4] = {
+  0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+/* Multiplies *a and *b to 128 bits, the low half goes to *a
+ * and the high half to *b */
+static inline void
+wyhash_mum (uint64_t * a, uint64_t * b)
+{
+#ifdef HAVE_UNSIGNED___INT128
+  unsigned __int128 r = *a;
+
+  r *= *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) * a, lb =
+      (uint32_t) * b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), c = t < rl, lo, hi;
+
+  lo = t + (rm1 << 32);
+  c += lo < t;
+  hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+  *a = lo;
+  *b = hi;
+#endif
+}
+
+static inline uint64_t
+wyhash_mix (uint64_t a, uint64_t b)
+{
+  wyhash_mum (&a, &b);
+  return a ^ b;
+}
+
+static inline uint64_t
+wyhash_read64 (const uint8_t * p)
+{
+  uint64_t v;
+
+  memcpy (&v, p, 8);
+#ifdef WORDS_BIGENDIAN
+  v = __builtin_bswap64 (v);
+#endif
+
+  return v;
+}
+
+static inline uint64_t
+wyhash_read32 (const uint8_t * p)
+{
+  uint32_t v;
+
+  memcpy (&v, p, 4);
+#ifdef WORDS_BIGENDIAN
+  v = __builtin_bswap32 (v);
+#endif
+
+  return v;
+}
+
+/* Reads 1 to 3 bytes */
+static inline uint64_t
+wyhash_read3 (const uint8_t * p, size_t k)
+{
+  return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+}
+
+/* Consumes all of @data and leaves the state in @a, @b and @seed
+ * for the finalization */
+static inline void
+wyhash_process (const uint8_t * p, size_t len, uint64_t * seed_out,
+    uint64_t * a_out, uint64_t * b_out)
+{
+  uint64_t seed = *seed_out, a, b;
+  size_t i;
+
+  seed ^= wyhash_mix (seed ^ wyhash_secret[0], wyhash_secret[1]);
+
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (wyhash_read32 (p) << 32) | wyhash_read32 (p + ((len >> 3) << 2));
+      b = (wyhash_read32 (p + len - 4) << 32) |
+          wyhash_read32 (p + len - 4 - ((len >> 3) << 2));
+    } else if (len > 0) {
+      a = wyhash_read3 (p, len);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    i = len;
+    if (i >= 48) {
+      uint64_t see1 = seed, see2 = seed;
+
+      do {
+        seed = wyhash_mix (wyhash_read64 (p) ^ wyhash_secret[1],
+            wyhash_read64 (p + 8) ^ seed);
+        see1 = wyhash_mix (wyhash_read64 (p + 16) ^ wyhash_secret[2],
+            wyhash_read64 (p + 24) ^ see1);
+        see2 = wyhash_mix (wyhash_read64 (p + 32) ^ wyhash_secret[3],
+            wyhash_read64 (p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i >= 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = wyhash_mix (wyhash_read64 (p) ^ wyhash_secret[1],
+          wyhash_read64 (p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = wyhash_read64 (p + i - 16);
+    b = wyhash_read64 (p + i - 8);
+  }
+
+  *seed_out = seed;
+  *a_out = a;
+  *b_out = b;
+}
+
+uint64_t
+snippets_wyhash_64 (const uint8_t * data, size_t len, uint64_t seed)
+{
+  uint64_t a, b;
+
+  assert (data != NULL || len == 0);
+
+  wyhash_process (data, len, &seed, &a, &b);
+
+  a ^= wyhash_secret[1];
+  b ^= seed;
+  wyhash_mum (&a, &b);
+
+  return wyhash_mix (a ^ wyhash_secret[0] ^ len, b ^ wyhash_secret[1]);
+}
+
+void
+snippets_wyhash_128 (const uint8_t * data, size_t len, uint64_t seed,
+    uint64_t hash[2])
+{
+  uint64_t a, b, a2, b2;
+
+  assert (data != NULL || len == 0);
+  assert (hash != NULL);
+
+  wyhash_process (data, len, &seed, &a, &b);
+
+  a2 = a ^ wyhash_secret[2];
+  b2 = b ^ seed ^ wyhash_secret[3];
+  a ^= wyhash_secret[1];
+  b ^= seed;
+  wyhash_mum (&a, &b);
+  wyhash_mum (&a2, &b2);
+
+  hash[0] = wyhash_mix (a ^ wyhash_secret[0] ^ len, b ^ wyhash_secret[1]);
+  hash[1] = wyhash_mix (a2 ^ wyhash_secret[3] ^ len, b2 ^ wyhash_secret[2]);
+}
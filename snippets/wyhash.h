@@ -0,0 +1,55 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SNIPPETS_WYHASH_H__
+#define __SNIPPETS_WYHASH_H__
+
+#include <snippets/utils.h>
+
+SNIPPETS_BEGIN_DECLS
+
+/** wyhash_64:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @seed: Seed for the hash
+ *
+ *  Calculates the 64 bit wyhash (final version 4, with the default
+ *  secret) from @data and returns it as an integer in host byte order.
+ *
+ *  wyhash consumes 16 or 48 bytes per step with 64x64->128 bit
+ *  multiplications and is much faster than FNV for longer keys. It is
+ *  not a cryptographic hash function.
+ */
+uint64_t snippets_wyhash_64 (const uint8_t *data, size_t len, uint64_t seed);
+
+/** wyhash_128:
+ *  @data: Data to be hashed
+ *  @len: Length of @data in bytes
+ *  @seed: Seed for the hash
+ *  @hash: Pointer to two 64 bit integers for the calculated hash
+ *
+ *  Calculates a 128 bit hash from @data. @hash[0] is the same as
+ *  snippets_wyhash_64() would return, @hash[1] is a second, differently
+ *  keyed finalization of the same internal state.
+ */
+void snippets_wyhash_128 (const uint8_t *data, size_t len, uint64_t seed, uint64_t hash[2]);
+
+SNIPPETS_END_DECLS
+
+#endif /* __SNIPPETS_WYHASH_H__ */
@@ -0,0 +1,129 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* xoshiro256** by David Blackman and Sebastiano Vigna, see
+ *
+ * http://prng.di.unimi.it/xoshiro256starstar.c
+ *
+ * 256 bits of state, period 2^256 - 1. The state is seeded from
+ * SplitMix64 as recommended by the authors, which can't produce an
+ * all-zero state.
+ */
+
+typedef struct
+{
+  uint64_t s[4];
+} Xoshiro256State;
+
+static inline uint64_t
+xoshiro256_rotl (uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+static void
+xoshiro256_init (Xoshiro256State * state, uint64_t seed)
+{
+  int i;
+
+  for (i = 0; i < 4; i++)
+    state->s[i] = splitmix64_next (&seed);
+}
+
+/* gcc partially vectorizes the state update with mixed scalar and
+ * vector accesses to the state, which stalls on store forwarding in
+ * the next call. Hide the loaded values from the vectorizer */
+#ifdef __GNUC__
+#define XOSHIRO256_OPAQUE(x) __asm__ ("" : "+r" (x))
+#else
+#define XOSHIRO256_OPAQUE(x) do { } while (0)
+#endif
+
+static inline uint64_t
+xoshiro256_next (Xoshiro256State * state)
+{
+  uint64_t s0 = state->s[0], s1 = state->s[1];
+  uint64_t s2 = state->s[2], s3 = state->s[3];
+  uint64_t result, t;
+
+  XOSHIRO256_OPAQUE (s0);
+  XOSHIRO256_OPAQUE (s1);
+  XOSHIRO256_OPAQUE (s2);
+  XOSHIRO256_OPAQUE (s3);
+
+  result = xoshiro256_rotl (s1 * 5, 7) * 9;
+  t = s1 << 17;
+
+  s2 ^= s0;
+  s3 ^= s1;
+  s1 ^= s2;
+  s0 ^= s3;
+
+  s2 ^= t;
+
+  s3 = xoshiro256_rotl (s3, 45);
+
+  state->s[0] = s0;
+  state->s[1] = s1;
+  state->s[2] = s2;
+  state->s[3] = s3;
+
+  return result;
+}
+
+/* Returns x^(2^k) modulo the characteristic polynomial of the linear
+ * engine, which is calculated from the lowest bit of s[0] */
+static void
+xoshiro256_jump_poly (unsigned int k, uint64_t q[4])
+{
+  Xoshiro256State state = { {1, 2, 3, 4} };
+  uint64_t seq[GF2_WORDS (512 + 64)] = { 0 };
+  Gf2Poly poly;
+  size_t i;
+
+  for (i = 0; i < 512 + 64; i++) {
+    gf2_xor64 (seq, i, state.s[0] & 1, 1);
+    xoshiro256_next (&state);
+  }
+
+  gf2_poly_from_sequence (&poly, seq, 512 + 64, 0);
+  assert (poly.degree == 256);
+  gf2_poly_pow2_mod (&poly, k, q);
+  free (poly.terms);
+}
+
+/* Advances the state by the steps of the jump polynomial @q, for
+ * 2^128 and 2^192 these are the jump() and long_jump() constants of the
+ * reference implementation */
+static void
+xoshiro256_jump (Xoshiro256State * state, const uint64_t q[4])
+{
+  uint64_t s[4] = { 0, 0, 0, 0 };
+  unsigned int i, j;
+
+  for (i = 0; i < 256; i++) {
+    if (gf2_get (q, i)) {
+      for (j = 0; j < 4; j++)
+        s[j] ^= state->s[j];
+    }
+    xoshiro256_next (state);
+  }
+
+  memcpy (state->s, s, sizeof (s));
+}
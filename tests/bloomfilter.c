@@ -23,6 +23,8 @@
 
 #include <check.h>
 
+#include <string.h>
+
 #include <snippets/bloomfilter.h>
 #include <snippets/rand.h>
 #include <snippets/skiplist.h>
@@ -97,10 +99,10 @@ START_TEST (test_general)
 
 END_TEST;
 
-#define CREATE_TEST(filter_size, n_hash_functions, hash_size, elements) \
-START_TEST (test_##filter_size##_##n_hash_functions##_##hash_size##_##elements) \
+#define CREATE_TEST_FULL(prefix, hash, filter_size, n_hash_functions, hash_size, elements) \
+START_TEST (prefix##_##filter_size##_##n_hash_functions##_##hash_size##_##elements) \
 { \
-  SnippetsBloomFilter *filter = snippets_bloom_filter_new (filter_size, n_hash_functions, hash_size); \
+  SnippetsBloomFilter *filter = snippets_bloom_filter_new_full (filter_size, n_hash_functions, SNIPPETS_BLOOM_FILTER_HASH_##hash, hash_size, NULL); \
   SnippetsRand *rand = snippets_rand_new (0xdeadbeef); \
   SnippetsSkipList *list = snippets_skip_list_new (8, 0.25, sizeof (TestData), NULL, NULL, compare_data, NULL, NULL, NULL); \
   const int N = elements; \
@@ -154,6 +156,11 @@ START_TEST (test_##filter_size##_##n_hash_functions##_##hash_size##_##elements)
 \
 END_TEST;
 
+#define CREATE_TEST(filter_size, n_hash_functions, hash_size, elements) \
+  CREATE_TEST_FULL (test, FNV1A, filter_size, n_hash_functions, hash_size, elements)
+#define CREATE_WYHASH_TEST(filter_size, n_hash_functions, hash_size, elements) \
+  CREATE_TEST_FULL (test_wyhash, WYHASH, filter_size, n_hash_functions, hash_size, elements)
+
 CREATE_TEST (15000, 5, 64, 2000);
 CREATE_TEST (15000, 5, 128, 2000);
 CREATE_TEST (150000, 11, 128, 10000);
@@ -161,6 +168,257 @@ CREATE_TEST (150000, 11, 256, 10000);
 CREATE_TEST (150000, 11, 512, 10000);
 CREATE_TEST (150000, 11, 1024, 1000);
 CREATE_TEST (100000, 70, 1024, 1000);
+CREATE_WYHASH_TEST (15000, 5, 64, 2000);
+CREATE_WYHASH_TEST (15000, 5, 128, 2000);
+CREATE_WYHASH_TEST (150000, 11, 128, 10000);
+CREATE_WYHASH_TEST (100000, 70, 128, 1000);
+
+#define CREATE_IOV_TEST(hash_size) \
+START_TEST (test_iov_##hash_size) \
+{ \
+  SnippetsBloomFilter *filter = snippets_bloom_filter_new (150000, 11, hash_size); \
+  SnippetsRand *rand = snippets_rand_new (0xdeadbeef); \
+  TestData data[100]; \
+  struct iovec iov[3]; \
+  int i, j; \
+  \
+  for (i = 0; i < 100; i++) \
+    for (j = 0; j < 16; j++) \
+      data[i].data[j] = snippets_rand_uint32 (rand); \
+  \
+  /* Insert half of the elements split into slices, the other half \
+   * contiguous, and check for both the other way around */ \
+  for (i = 0; i < 100; i++) { \
+    iov[0].iov_base = data[i].data; \
+    iov[0].iov_len = 5; \
+    iov[1].iov_base = ((uint8_t *) data[i].data) + 5; \
+    iov[1].iov_len = 0; \
+    iov[2].iov_base = ((uint8_t *) data[i].data) + 5; \
+    iov[2].iov_len = sizeof (TestData) - 5; \
+    \
+    if (i % 2 == 0) { \
+      fail_if (snippets_bloom_filter_contains (filter, (uint8_t *) data[i].data, sizeof (TestData))); \
+      snippets_bloom_filter_insert_iov (filter, iov, 3); \
+      fail_unless (snippets_bloom_filter_contains (filter, (uint8_t *) data[i].data, sizeof (TestData))); \
+    } else { \
+      fail_if (snippets_bloom_filter_contains_iov (filter, iov, 3)); \
+      snippets_bloom_filter_insert (filter, (uint8_t *) data[i].data, sizeof (TestData)); \
+      fail_unless (snippets_bloom_filter_contains_iov (filter, iov, 3)); \
+    } \
+  } \
+  \
+  fail_unless (snippets_bloom_filter_n_elements (filter) == 100); \
+  \
+  snippets_rand_free (rand); \
+  snippets_bloom_filter_free (filter); \
+} \
+\
+END_TEST;
+
+CREATE_IOV_TEST (64);
+CREATE_IOV_TEST (128);
+CREATE_IOV_TEST (256);
+CREATE_IOV_TEST (512);
+CREATE_IOV_TEST (1024);
+
+#define CREATE_SEEDED_TEST(hash_size) \
+START_TEST (test_seeded_##hash_size) \
+{ \
+  static const uint64_t seed_a[2] = { 0x0123456789abcdefULL, 0xfedcba9876543210ULL }; \
+  static const uint64_t seed_b[2] = { 0x0123456789abcdefULL, 0xfedcba9876543211ULL }; \
+  SnippetsBloomFilter *a = snippets_bloom_filter_new_seeded (150000, 11, hash_size, seed_a); \
+  SnippetsBloomFilter *b = snippets_bloom_filter_new_seeded (150000, 11, hash_size, seed_b); \
+  SnippetsRand *rand = snippets_rand_new (0xdeadbeef); \
+  SnippetsHashedKey key_a, key_b; \
+  TestData data[100]; \
+  struct iovec iov[2]; \
+  int i, j; \
+  \
+  for (i = 0; i < 100; i++) \
+    for (j = 0; j < 16; j++) \
+      data[i].data[j] = snippets_rand_uint32 (rand); \
+  \
+  for (i = 0; i < 100; i++) { \
+    iov[0].iov_base = data[i].data; \
+    iov[0].iov_len = 7; \
+    iov[1].iov_base = ((uint8_t *) data[i].data) + 7; \
+    iov[1].iov_len = sizeof (TestData) - 7; \
+    \
+    if (i % 2 == 0) \
+      snippets_bloom_filter_insert (a, (uint8_t *) data[i].data, sizeof (TestData)); \
+    else \
+      snippets_bloom_filter_insert_iov (a, iov, 2); \
+  } \
+  \
+  /* Everything must be found with the same seed, in both ways, and \
+   * with a different seed the keys must hash differently */ \
+  for (i = 0; i < 100; i++) { \
+    iov[0].iov_base = data[i].data; \
+    iov[0].iov_len = 7; \
+    iov[1].iov_base = ((uint8_t *) data[i].data) + 7; \
+    iov[1].iov_len = sizeof (TestData) - 7; \
+    \
+    fail_unless (snippets_bloom_filter_contains (a, (uint8_t *) data[i].data, sizeof (TestData))); \
+    fail_unless (snippets_bloom_filter_contains_iov (a, iov, 2)); \
+    \
+    snippets_bloom_filter_hash_key (a, (uint8_t *) data[i].data, sizeof (TestData), &key_a); \
+    snippets_bloom_filter_hash_key (b, (uint8_t *) data[i].data, sizeof (TestData), &key_b); \
+    fail_if (memcmp (key_a.hash, key_b.hash, hash_size / 8) == 0); \
+    \
+    snippets_bloom_filter_insert (b, (uint8_t *) data[i].data, sizeof (TestData)); \
+  } \
+  \
+  for (i = 0; i < 100; i++) \
+    fail_unless (snippets_bloom_filter_contains (b, (uint8_t *) data[i].data, sizeof (TestData))); \
+  \
+  snippets_rand_free (rand); \
+  snippets_bloom_filter_free (b); \
+  snippets_bloom_filter_free (a); \
+} \
+\
+END_TEST;
+
+CREATE_SEEDED_TEST (64);
+CREATE_SEEDED_TEST (128);
+CREATE_SEEDED_TEST (256);
+CREATE_SEEDED_TEST (512);
+CREATE_SEEDED_TEST (1024);
+
+START_TEST (test_wyhash_iov)
+{
+  static const uint64_t seed[2] = { 0x0123456789abcdefULL, 0xfedcba9876543210ULL };
+  SnippetsBloomFilter *filter;
+  SnippetsRand *rand = snippets_rand_new (0xdeadbeef);
+  uint8_t data[100][300];
+  struct iovec iov[3];
+  int i, j, k;
+
+  for (i = 0; i < 100; i++)
+    for (j = 0; j < 300; j++)
+      data[i][j] = snippets_rand_uint32 (rand);
+
+  /* Unseeded and seeded, 64 and 128 bits. Keys of up to 300 bytes so
+   * that gathering the buffers needs a temporary allocation */
+  for (k = 0; k < 4; k++) {
+    filter = snippets_bloom_filter_new_full (150000, 11,
+        SNIPPETS_BLOOM_FILTER_HASH_WYHASH, k % 2 ? 128 : 64,
+        k / 2 ? seed : NULL);
+    fail_unless (snippets_bloom_filter_hash_type (filter) ==
+        SNIPPETS_BLOOM_FILTER_HASH_WYHASH);
+
+    for (i = 0; i < 100; i++) {
+      size_t len = 1 + i * 3;
+
+      iov[0].iov_base = data[i];
+      iov[0].iov_len = len / 3;
+      iov[1].iov_base = data[i] + len / 3;
+      iov[1].iov_len = 0;
+      iov[2].iov_base = data[i] + len / 3;
+      iov[2].iov_len = len - len / 3;
+
+      if (i % 2 == 0) {
+        fail_if (snippets_bloom_filter_contains (filter, data[i], len));
+        snippets_bloom_filter_insert_iov (filter, iov, 3);
+        fail_unless (snippets_bloom_filter_contains (filter, data[i], len));
+        fail_unless (snippets_bloom_filter_contains_iov (filter, iov, 1) ==
+            snippets_bloom_filter_contains (filter, data[i], len / 3));
+      } else {
+        fail_if (snippets_bloom_filter_contains_iov (filter, iov, 3));
+        snippets_bloom_filter_insert (filter, data[i], len);
+        fail_unless (snippets_bloom_filter_contains_iov (filter, iov, 3));
+      }
+    }
+
+    fail_unless (snippets_bloom_filter_n_elements (filter) == 100);
+    snippets_bloom_filter_free (filter);
+  }
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_hashed)
+{
+  static const uint64_t seed[2] = { 0x0123456789abcdefULL, 0xfedcba9876543210ULL };
+  static const struct
+  {
+    SnippetsBloomFilterHash hash;
+    unsigned int hash_size;
+    int seeded;
+  } configs[] = {
+    {SNIPPETS_BLOOM_FILTER_HASH_FNV1A, 64, FALSE},
+    {SNIPPETS_BLOOM_FILTER_HASH_FNV1A, 256, TRUE},
+    {SNIPPETS_BLOOM_FILTER_HASH_FNV1A, 1024, FALSE},
+    {SNIPPETS_BLOOM_FILTER_HASH_WYHASH, 64, TRUE},
+    {SNIPPETS_BLOOM_FILTER_HASH_WYHASH, 128, FALSE},
+  };
+  SnippetsBloomFilter *filter, *filter2;
+  SnippetsRand *rand = snippets_rand_new (0xdeadbeef);
+  SnippetsHashedKey key, key_iov;
+  TestData data[100];
+  struct iovec iov[2];
+  int c, i, j;
+
+  for (i = 0; i < 100; i++)
+    for (j = 0; j < 16; j++)
+      data[i].data[j] = snippets_rand_uint32 (rand);
+
+  for (c = 0; c < sizeof (configs) / sizeof (configs[0]); c++) {
+    const uint64_t *s = configs[c].seeded ? seed : NULL;
+
+    filter = snippets_bloom_filter_new_full (150000, 11, configs[c].hash,
+        configs[c].hash_size, s);
+    filter2 = snippets_bloom_filter_new_full (150000, 11, configs[c].hash,
+        configs[c].hash_size, s);
+
+    for (i = 0; i < 100; i++) {
+      const uint8_t *d = (const uint8_t *) data[i].data;
+
+      iov[0].iov_base = data[i].data;
+      iov[0].iov_len = 9;
+      iov[1].iov_base = ((uint8_t *) data[i].data) + 9;
+      iov[1].iov_len = sizeof (TestData) - 9;
+
+      snippets_bloom_filter_hash_key (filter, d, sizeof (TestData), &key);
+      snippets_bloom_filter_hash_key_iov (filter, iov, 2, &key_iov);
+      fail_unless (memcmp (key.hash, key_iov.hash,
+              configs[c].hash_size / 8) == 0);
+
+      /* Check-then-add with a single hash calculation */
+      if (i % 2 == 0) {
+        fail_if (snippets_bloom_filter_contains_hashed (filter, &key));
+        snippets_bloom_filter_insert_hashed (filter, &key);
+        fail_unless (snippets_bloom_filter_contains_hashed (filter, &key));
+        fail_unless (snippets_bloom_filter_contains (filter, d,
+                sizeof (TestData)));
+      } else {
+        fail_if (snippets_bloom_filter_test_and_insert_hashed (filter, &key));
+        fail_unless (snippets_bloom_filter_test_and_insert_hashed (filter,
+                &key));
+        fail_unless (snippets_bloom_filter_contains (filter, d,
+                sizeof (TestData)));
+      }
+
+      /* Keys can be used with filters with the same configuration */
+      fail_if (snippets_bloom_filter_test_and_insert (filter2, d,
+              sizeof (TestData)));
+      fail_unless (snippets_bloom_filter_test_and_insert (filter2, d,
+              sizeof (TestData)));
+      fail_unless (snippets_bloom_filter_contains_hashed (filter2, &key));
+    }
+
+    fail_unless (snippets_bloom_filter_n_elements (filter) == 100);
+    fail_unless (snippets_bloom_filter_n_elements (filter2) == 100);
+
+    snippets_bloom_filter_free (filter2);
+    snippets_bloom_filter_free (filter);
+  }
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
 
 START_TEST (test_optimal_n_hash_functions)
 {
@@ -189,6 +447,22 @@ bloomfilter_suite (void)
   tcase_add_test (tc_general, test_150000_11_512_10000);
   tcase_add_test (tc_general, test_150000_11_1024_1000);
   tcase_add_test (tc_general, test_100000_70_1024_1000);
+  tcase_add_test (tc_general, test_wyhash_15000_5_64_2000);
+  tcase_add_test (tc_general, test_wyhash_15000_5_128_2000);
+  tcase_add_test (tc_general, test_wyhash_150000_11_128_10000);
+  tcase_add_test (tc_general, test_wyhash_100000_70_128_1000);
+  tcase_add_test (tc_general, test_iov_64);
+  tcase_add_test (tc_general, test_iov_128);
+  tcase_add_test (tc_general, test_iov_256);
+  tcase_add_test (tc_general, test_iov_512);
+  tcase_add_test (tc_general, test_iov_1024);
+  tcase_add_test (tc_general, test_seeded_64);
+  tcase_add_test (tc_general, test_seeded_128);
+  tcase_add_test (tc_general, test_seeded_256);
+  tcase_add_test (tc_general, test_seeded_512);
+  tcase_add_test (tc_general, test_seeded_1024);
+  tcase_add_test (tc_general, test_wyhash_iov);
+  tcase_add_test (tc_general, test_hashed);
   tcase_add_test (tc_general, test_optimal_n_hash_functions);
   suite_add_tcase (s, tc_general);
 
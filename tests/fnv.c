@@ -23,7 +23,16 @@
 
 #include <check.h>
 
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
 #include <snippets/fnv.h>
+#include <snippets/fnv-inline.h>
+
+#include "simd.h"
 
 START_TEST (test_1_32)
 {
@@ -121,11 +130,11 @@ START_TEST (test_1a_128)
   uint8_t hash[16];
 
   snippets_fnv1a_128 ((const uint8_t *) str, strlen (str), hash);
-  fail_unless (hash[0] == 0x6f);
-  fail_unless (hash[1] == 0x36);
-  fail_unless (hash[2] == 0x56);
-  fail_unless (hash[3] == 0xc6);
-  fail_unless (hash[4] == 0x0d);
+  fail_unless (hash[0] == 0x84);
+  fail_unless (hash[1] == 0x10);
+  fail_unless (hash[2] == 0x91);
+  fail_unless (hash[3] == 0x22);
+  fail_unless (hash[4] == 0xdd);
   fail_unless (hash[5] == 0xf8);
   fail_unless (hash[6] == 0x43);
   fail_unless (hash[7] == 0x48);
@@ -189,17 +198,17 @@ START_TEST (test_1a_256)
   uint8_t hash[32];
 
   snippets_fnv1a_256 ((const uint8_t *) str, strlen (str), hash);
-  fail_unless (hash[0] == 0xc2);
-  fail_unless (hash[1] == 0x5f);
-  fail_unless (hash[2] == 0xb3);
-  fail_unless (hash[3] == 0xfd);
-  fail_unless (hash[4] == 0x87);
-  fail_unless (hash[5] == 0xc6);
-  fail_unless (hash[6] == 0x79);
-  fail_unless (hash[7] == 0xaf);
-  fail_unless (hash[8] == 0x4b);
-  fail_unless (hash[9] == 0x26);
-  fail_unless (hash[10] == 0x16);
+  fail_unless (hash[0] == 0x12);
+  fail_unless (hash[1] == 0xf8);
+  fail_unless (hash[2] == 0xa9);
+  fail_unless (hash[3] == 0x7d);
+  fail_unless (hash[4] == 0xe0);
+  fail_unless (hash[5] == 0xfc);
+  fail_unless (hash[6] == 0x40);
+  fail_unless (hash[7] == 0xb1);
+  fail_unless (hash[8] == 0x3d);
+  fail_unless (hash[9] == 0x2a);
+  fail_unless (hash[10] == 0x8e);
   fail_unless (hash[11] == 0x29);
   fail_unless (hash[12] == 0x02);
   fail_unless (hash[13] == 0xc6);
@@ -305,27 +314,27 @@ START_TEST (test_1a_512)
   uint8_t hash[64];
 
   snippets_fnv1a_512 ((const uint8_t *) str, strlen (str), hash);
-  fail_unless (hash[0] == 0x13);
-  fail_unless (hash[1] == 0x92);
-  fail_unless (hash[2] == 0x20);
-  fail_unless (hash[3] == 0xfc);
-  fail_unless (hash[4] == 0x4c);
-  fail_unless (hash[5] == 0xd6);
-  fail_unless (hash[6] == 0x48);
-  fail_unless (hash[7] == 0x3d);
-  fail_unless (hash[8] == 0xd3);
-  fail_unless (hash[9] == 0x15);
-  fail_unless (hash[10] == 0x39);
-  fail_unless (hash[11] == 0x42);
-  fail_unless (hash[12] == 0xb7);
-  fail_unless (hash[13] == 0x1a);
-  fail_unless (hash[14] == 0x92);
-  fail_unless (hash[15] == 0x0d);
-  fail_unless (hash[16] == 0xb5);
-  fail_unless (hash[17] == 0x63);
-  fail_unless (hash[18] == 0xe3);
-  fail_unless (hash[19] == 0x0e);
-  fail_unless (hash[20] == 0xca);
+  fail_unless (hash[0] == 0x44);
+  fail_unless (hash[1] == 0x80);
+  fail_unless (hash[2] == 0x56);
+  fail_unless (hash[3] == 0x11);
+  fail_unless (hash[4] == 0x6c);
+  fail_unless (hash[5] == 0x88);
+  fail_unless (hash[6] == 0xda);
+  fail_unless (hash[7] == 0x5d);
+  fail_unless (hash[8] == 0x01);
+  fail_unless (hash[9] == 0x99);
+  fail_unless (hash[10] == 0x15);
+  fail_unless (hash[11] == 0x16);
+  fail_unless (hash[12] == 0x69);
+  fail_unless (hash[13] == 0xac);
+  fail_unless (hash[14] == 0x30);
+  fail_unless (hash[15] == 0x68);
+  fail_unless (hash[16] == 0xbc);
+  fail_unless (hash[17] == 0xe1);
+  fail_unless (hash[18] == 0x9e);
+  fail_unless (hash[19] == 0x3f);
+  fail_unless (hash[20] == 0x46);
   fail_unless (hash[21] == 0x43);
   fail_unless (hash[22] == 0xa1);
   fail_unless (hash[23] == 0x8e);
@@ -521,45 +530,45 @@ START_TEST (test_1a_1024)
   fail_unless (hash[1] == 0x3e);
   fail_unless (hash[2] == 0x0e);
   fail_unless (hash[3] == 0x62);
-  fail_unless (hash[4] == 0xba);
-  fail_unless (hash[5] == 0x3f);
-  fail_unless (hash[6] == 0x8e);
-  fail_unless (hash[7] == 0xca);
-  fail_unless (hash[8] == 0xda);
-  fail_unless (hash[9] == 0x92);
-  fail_unless (hash[10] == 0xa7);
-  fail_unless (hash[11] == 0xd1);
-  fail_unless (hash[12] == 0xbf);
-  fail_unless (hash[13] == 0xfe);
-  fail_unless (hash[14] == 0x47);
-  fail_unless (hash[15] == 0x12);
-  fail_unless (hash[16] == 0x4a);
-  fail_unless (hash[17] == 0xdf);
-  fail_unless (hash[18] == 0xb2);
-  fail_unless (hash[19] == 0x8c);
-  fail_unless (hash[20] == 0x65);
-  fail_unless (hash[21] == 0x6b);
-  fail_unless (hash[22] == 0xd8);
-  fail_unless (hash[23] == 0x7c);
-  fail_unless (hash[24] == 0x9f);
-  fail_unless (hash[25] == 0xcb);
-  fail_unless (hash[26] == 0x78);
-  fail_unless (hash[27] == 0xc6);
-  fail_unless (hash[28] == 0x25);
-  fail_unless (hash[29] == 0x28);
-  fail_unless (hash[30] == 0x5d);
-  fail_unless (hash[31] == 0x26);
-  fail_unless (hash[32] == 0xa5);
-  fail_unless (hash[33] == 0x5d);
-  fail_unless (hash[34] == 0xe9);
-  fail_unless (hash[35] == 0x87);
-  fail_unless (hash[36] == 0x91);
-  fail_unless (hash[37] == 0x6e);
-  fail_unless (hash[38] == 0x74);
-  fail_unless (hash[39] == 0x2d);
-  fail_unless (hash[40] == 0x91);
-  fail_unless (hash[41] == 0xfe);
-  fail_unless (hash[42] == 0x12);
+  fail_unless (hash[4] == 0xcb);
+  fail_unless (hash[5] == 0xbc);
+  fail_unless (hash[6] == 0x7a);
+  fail_unless (hash[7] == 0x5d);
+  fail_unless (hash[8] == 0x07);
+  fail_unless (hash[9] == 0x48);
+  fail_unless (hash[10] == 0xdc);
+  fail_unless (hash[11] == 0xe7);
+  fail_unless (hash[12] == 0x7a);
+  fail_unless (hash[13] == 0xce);
+  fail_unless (hash[14] == 0x84);
+  fail_unless (hash[15] == 0xec);
+  fail_unless (hash[16] == 0x72);
+  fail_unless (hash[17] == 0x4d);
+  fail_unless (hash[18] == 0xc7);
+  fail_unless (hash[19] == 0x8d);
+  fail_unless (hash[20] == 0x55);
+  fail_unless (hash[21] == 0xe7);
+  fail_unless (hash[22] == 0xc2);
+  fail_unless (hash[23] == 0x70);
+  fail_unless (hash[24] == 0xf4);
+  fail_unless (hash[25] == 0x0e);
+  fail_unless (hash[26] == 0x36);
+  fail_unless (hash[27] == 0xc5);
+  fail_unless (hash[28] == 0xe3);
+  fail_unless (hash[29] == 0x65);
+  fail_unless (hash[30] == 0xb2);
+  fail_unless (hash[31] == 0x3f);
+  fail_unless (hash[32] == 0xa2);
+  fail_unless (hash[33] == 0xb2);
+  fail_unless (hash[34] == 0xe3);
+  fail_unless (hash[35] == 0xb3);
+  fail_unless (hash[36] == 0xb5);
+  fail_unless (hash[37] == 0x59);
+  fail_unless (hash[38] == 0x3c);
+  fail_unless (hash[39] == 0xc7);
+  fail_unless (hash[40] == 0x86);
+  fail_unless (hash[41] == 0x37);
+  fail_unless (hash[42] == 0x04);
   fail_unless (hash[43] == 0x00);
   fail_unless (hash[44] == 0x00);
   fail_unless (hash[45] == 0x00);
@@ -649,6 +658,466 @@ START_TEST (test_1a_1024)
 
 END_TEST;
 
+#define CREATE_STATE_TEST(func, variant, width) \
+START_TEST (test_state_##func##_##width) \
+{ \
+  const char *str = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"; \
+  size_t len = strlen (str); \
+  uint8_t hash[width / 8], hash2[width / 8]; \
+  SnippetsFnvState *state; \
+  size_t i, j; \
+  \
+  snippets_##func##_##width ((const uint8_t *) str, len, hash); \
+  \
+  state = snippets_fnv_state_new (variant, width); \
+  fail_unless (snippets_fnv_state_variant (state) == variant); \
+  fail_unless (snippets_fnv_state_width (state) == width); \
+  \
+  for (i = 0; i <= len; i++) { \
+    for (j = i; j <= len; j++) { \
+      snippets_fnv_state_init (state); \
+      snippets_fnv_state_update (state, (const uint8_t *) str, i); \
+      snippets_fnv_state_update (state, (const uint8_t *) str + i, j - i); \
+      snippets_fnv_state_update (state, (const uint8_t *) str + j, len - j); \
+      snippets_fnv_state_final (state, hash2); \
+      fail_unless (memcmp (hash, hash2, sizeof (hash)) == 0); \
+    } \
+  } \
+  \
+  snippets_fnv_state_init (state); \
+  snippets_fnv_state_final (state, hash2); \
+  snippets_##func##_##width (NULL, 0, hash); \
+  fail_unless (memcmp (hash, hash2, sizeof (hash)) == 0); \
+  \
+  snippets_fnv_state_free (state); \
+} \
+\
+END_TEST;
+
+CREATE_STATE_TEST (fnv1, SNIPPETS_FNV_VARIANT_1, 32);
+CREATE_STATE_TEST (fnv1a, SNIPPETS_FNV_VARIANT_1A, 32);
+CREATE_STATE_TEST (fnv1, SNIPPETS_FNV_VARIANT_1, 64);
+CREATE_STATE_TEST (fnv1a, SNIPPETS_FNV_VARIANT_1A, 64);
+CREATE_STATE_TEST (fnv1, SNIPPETS_FNV_VARIANT_1, 128);
+CREATE_STATE_TEST (fnv1a, SNIPPETS_FNV_VARIANT_1A, 128);
+CREATE_STATE_TEST (fnv1, SNIPPETS_FNV_VARIANT_1, 256);
+CREATE_STATE_TEST (fnv1a, SNIPPETS_FNV_VARIANT_1A, 256);
+CREATE_STATE_TEST (fnv1, SNIPPETS_FNV_VARIANT_1, 512);
+CREATE_STATE_TEST (fnv1a, SNIPPETS_FNV_VARIANT_1A, 512);
+CREATE_STATE_TEST (fnv1, SNIPPETS_FNV_VARIANT_1, 1024);
+CREATE_STATE_TEST (fnv1a, SNIPPETS_FNV_VARIANT_1A, 1024);
+
+#define CREATE_BATCH_TEST(width) \
+START_TEST (test_1a_##width##_batch) \
+{ \
+  uint8_t data[128]; \
+  const uint8_t *keys[101]; \
+  size_t lens[101]; \
+  uint##width##_t out[101], expected; \
+  uint8_t hash[width / 8]; \
+  int i, j; \
+  \
+  for (i = 0; i < sizeof (data); i++) \
+    data[i] = (i * 131) ^ (i >> 3); \
+  \
+  /* Long keys first so the parallel code paths are used, \
+   * then short ones of varying lengths */ \
+  for (i = 0; i < 101; i++) { \
+    keys[i] = data + (i % 50); \
+    lens[i] = (i < 64) ? 8 + (i * 37) % 60 : (i * 13) % 20; \
+  } \
+  \
+  snippets_fnv1a_##width##_batch (keys, lens, 101, out); \
+  \
+  for (i = 0; i < 101; i++) { \
+    snippets_fnv1a_##width (keys[i], lens[i], hash); \
+    expected = 0; \
+    for (j = 0; j < width / 8; j++) \
+      expected = (expected << 8) | hash[j]; \
+    fail_unless (out[i] == expected); \
+  } \
+} \
+\
+END_TEST;
+
+CREATE_BATCH_TEST (32);
+CREATE_BATCH_TEST (64);
+
+#define CREATE_UINT_TEST(func, width) \
+START_TEST (test_uint_##func##_##width) \
+{ \
+  const char *str = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"; \
+  size_t len = strlen (str); \
+  uint8_t hash[width / 8]; \
+  uint##width##_t expected; \
+  size_t i, j; \
+  \
+  for (i = 0; i <= len; i++) { \
+    snippets_##func##_##width ((const uint8_t *) str, i, hash); \
+    expected = 0; \
+    for (j = 0; j < width / 8; j++) \
+      expected = (expected << 8) | hash[j]; \
+    fail_unless (snippets_##func##_##width##_uint##width ((const uint8_t *) \
+            str, i) == expected); \
+  } \
+} \
+\
+END_TEST;
+
+CREATE_UINT_TEST (fnv1, 32);
+CREATE_UINT_TEST (fnv1a, 32);
+CREATE_UINT_TEST (fnv1, 64);
+CREATE_UINT_TEST (fnv1a, 64);
+
+static const uint64_t seed_a[2] = { 0x0123456789abcdefULL, 0xfedcba9876543210ULL };
+static const uint64_t seed_b[2] = { 0x0123456789abcdefULL, 0xfedcba9876543211ULL };
+
+#define CREATE_SEEDED_TEST(width) \
+START_TEST (test_seeded_fnv1a_##width) \
+{ \
+  const char *str = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"; \
+  size_t len = strlen (str); \
+  SnippetsFnvState *state; \
+  uint8_t hash[width / 8]; \
+  uint##width##_t seeded, expected; \
+  size_t i, j; \
+  \
+  state = snippets_fnv_state_new_seeded (SNIPPETS_FNV_VARIANT_1A, width, seed_a); \
+  for (i = 0; i <= len; i++) { \
+    seeded = snippets_fnv1a_##width##_seeded ((const uint8_t *) str, i, seed_a); \
+    fail_unless (seeded == snippets_fnv1a_##width##_seeded ((const uint8_t *) str, i, seed_a)); \
+    fail_if (seeded == snippets_fnv1a_##width##_seeded ((const uint8_t *) str, i, seed_b)); \
+    fail_if (seeded == snippets_fnv1a_##width##_uint##width ((const uint8_t *) str, i)); \
+    \
+    snippets_fnv_state_init (state); \
+    snippets_fnv_state_update (state, (const uint8_t *) str, i / 2); \
+    snippets_fnv_state_update (state, (const uint8_t *) str + i / 2, i - i / 2); \
+    snippets_fnv_state_final (state, hash); \
+    expected = 0; \
+    for (j = 0; j < width / 8; j++) \
+      expected = (expected << 8) | hash[j]; \
+    fail_unless (seeded == expected); \
+  } \
+  snippets_fnv_state_free (state); \
+} \
+\
+END_TEST;
+
+CREATE_SEEDED_TEST (32);
+CREATE_SEEDED_TEST (64);
+
+#define CREATE_SEEDED_STATE_TEST(width) \
+START_TEST (test_seeded_state_##width) \
+{ \
+  const char *str = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"; \
+  size_t len = strlen (str); \
+  SnippetsFnvState *a, *b, *unseeded; \
+  uint8_t hash_a[width / 8], hash_b[width / 8], hash_a2[width / 8]; \
+  uint8_t hash_unseeded[width / 8]; \
+  \
+  a = snippets_fnv_state_new_seeded (SNIPPETS_FNV_VARIANT_1A, width, seed_a); \
+  b = snippets_fnv_state_new_seeded (SNIPPETS_FNV_VARIANT_1A, width, seed_b); \
+  unseeded = snippets_fnv_state_new (SNIPPETS_FNV_VARIANT_1A, width); \
+  \
+  snippets_fnv_state_update (a, (const uint8_t *) str, len); \
+  snippets_fnv_state_final (a, hash_a); \
+  snippets_fnv_state_update (b, (const uint8_t *) str, len); \
+  snippets_fnv_state_final (b, hash_b); \
+  snippets_fnv_state_update (unseeded, (const uint8_t *) str, len); \
+  snippets_fnv_state_final (unseeded, hash_unseeded); \
+  \
+  /* The seed is kept when reinitializing */ \
+  snippets_fnv_state_init (a); \
+  snippets_fnv_state_update (a, (const uint8_t *) str, 3); \
+  snippets_fnv_state_update (a, (const uint8_t *) str + 3, len - 3); \
+  snippets_fnv_state_final (a, hash_a2); \
+  \
+  fail_unless (memcmp (hash_a, hash_a2, width / 8) == 0); \
+  fail_if (memcmp (hash_a, hash_b, width / 8) == 0); \
+  fail_if (memcmp (hash_a, hash_unseeded, width / 8) == 0); \
+  \
+  snippets_fnv_state_free (a); \
+  snippets_fnv_state_free (b); \
+  snippets_fnv_state_free (unseeded); \
+} \
+\
+END_TEST;
+
+CREATE_SEEDED_STATE_TEST (128);
+CREATE_SEEDED_STATE_TEST (256);
+CREATE_SEEDED_STATE_TEST (512);
+CREATE_SEEDED_STATE_TEST (1024);
+
+#define CREATE_WORDS_TEST(func, width) \
+START_TEST (test_words_##func##_##width) \
+{ \
+  const char *str = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"; \
+  size_t len = strlen (str); \
+  uint8_t hash[width / 8]; \
+  uint32_t words[width / 32]; \
+  size_t i, j; \
+  \
+  for (i = 0; i <= len; i++) { \
+    snippets_##func##_##width ((const uint8_t *) str, i, hash); \
+    snippets_##func##_##width##_words ((const uint8_t *) str, i, words); \
+    for (j = 0; j < width / 32; j++) \
+      fail_unless (words[j] == (((uint32_t) hash[4 * j] << 24) | \
+              (hash[4 * j + 1] << 16) | (hash[4 * j + 2] << 8) | \
+              hash[4 * j + 3])); \
+  } \
+} \
+\
+END_TEST;
+
+CREATE_WORDS_TEST (fnv1, 128);
+CREATE_WORDS_TEST (fnv1a, 128);
+CREATE_WORDS_TEST (fnv1, 256);
+CREATE_WORDS_TEST (fnv1a, 256);
+CREATE_WORDS_TEST (fnv1, 512);
+CREATE_WORDS_TEST (fnv1a, 512);
+CREATE_WORDS_TEST (fnv1, 1024);
+CREATE_WORDS_TEST (fnv1a, 1024);
+
+/* Big endian byte output for the integer returning 32/64 bit variants */
+#define CREATE_IOV_BYTES(func, width) \
+static void \
+func##_##width##_iov_bytes (const struct iovec *iov, int n, uint8_t *hash) \
+{ \
+  uint##width##_t h = snippets_##func##_##width##_iov (iov, n); \
+  int i; \
+  \
+  for (i = 0; i < width / 8; i++) \
+    hash[i] = (h >> (width - 8 - 8 * i)) & 0xff; \
+}
+
+CREATE_IOV_BYTES (fnv1, 32);
+CREATE_IOV_BYTES (fnv1a, 32);
+CREATE_IOV_BYTES (fnv1, 64);
+CREATE_IOV_BYTES (fnv1a, 64);
+
+#define CREATE_IOV_TEST(func, width, iov_func) \
+START_TEST (test_iov_##func##_##width) \
+{ \
+  const char *str = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"; \
+  size_t len = strlen (str); \
+  uint8_t hash[width / 8], hash2[width / 8]; \
+  struct iovec iov[3]; \
+  size_t i, j; \
+  \
+  snippets_##func##_##width ((const uint8_t *) str, len, hash); \
+  \
+  for (i = 0; i <= len; i++) { \
+    for (j = i; j <= len; j++) { \
+      iov[0].iov_base = (void *) str; \
+      iov[0].iov_len = i; \
+      iov[1].iov_base = (void *) (str + i); \
+      iov[1].iov_len = j - i; \
+      iov[2].iov_base = (void *) (str + j); \
+      iov[2].iov_len = len - j; \
+      iov_func (iov, 3, hash2); \
+      fail_unless (memcmp (hash, hash2, sizeof (hash)) == 0); \
+    } \
+  } \
+  \
+  /* No buffers at all */ \
+  snippets_##func##_##width (NULL, 0, hash); \
+  iov_func (NULL, 0, hash2); \
+  fail_unless (memcmp (hash, hash2, sizeof (hash)) == 0); \
+} \
+\
+END_TEST;
+
+CREATE_IOV_TEST (fnv1, 32, fnv1_32_iov_bytes);
+CREATE_IOV_TEST (fnv1a, 32, fnv1a_32_iov_bytes);
+CREATE_IOV_TEST (fnv1, 64, fnv1_64_iov_bytes);
+CREATE_IOV_TEST (fnv1a, 64, fnv1a_64_iov_bytes);
+CREATE_IOV_TEST (fnv1, 128, snippets_fnv1_128_iov);
+CREATE_IOV_TEST (fnv1a, 128, snippets_fnv1a_128_iov);
+CREATE_IOV_TEST (fnv1, 256, snippets_fnv1_256_iov);
+CREATE_IOV_TEST (fnv1a, 256, snippets_fnv1a_256_iov);
+CREATE_IOV_TEST (fnv1, 512, snippets_fnv1_512_iov);
+CREATE_IOV_TEST (fnv1a, 512, snippets_fnv1a_512_iov);
+CREATE_IOV_TEST (fnv1, 1024, snippets_fnv1_1024_iov);
+CREATE_IOV_TEST (fnv1a, 1024, snippets_fnv1a_1024_iov);
+
+#define CREATE_TREE_TEST(func, variant, width) \
+START_TEST (test_tree_##func##_##width) \
+{ \
+  static const size_t chunk_sizes[] = { 1, 7, 1000, 4096, 20000 }; \
+  uint8_t data[10000]; \
+  uint8_t digests[10000 * (width / 8)]; \
+  uint8_t hash[width / 8], expected[width / 8]; \
+  uint8_t len_bytes[8] = { 0, 0, 0, 0, 0, 0, 0x27, 0x10 }; \
+  size_t i, j, n_chunks, chunk_len; \
+  unsigned int n_threads; \
+  \
+  for (i = 0; i < sizeof (data); i++) \
+    data[i] = (i * 131) ^ (i >> 3); \
+  \
+  for (i = 0; i < sizeof (chunk_sizes) / sizeof (chunk_sizes[0]); i++) { \
+    SnippetsFnvState *state = snippets_fnv_state_new (variant, width); \
+    \
+    n_chunks = (sizeof (data) + chunk_sizes[i] - 1) / chunk_sizes[i]; \
+    for (j = 0; j < n_chunks; j++) { \
+      chunk_len = sizeof (data) - j * chunk_sizes[i]; \
+      if (chunk_len > chunk_sizes[i]) \
+        chunk_len = chunk_sizes[i]; \
+      snippets_##func##_##width (data + j * chunk_sizes[i], chunk_len, \
+          digests + j * (width / 8)); \
+    } \
+    snippets_fnv_state_update (state, digests, n_chunks * (width / 8)); \
+    snippets_fnv_state_update (state, len_bytes, 8); \
+    snippets_fnv_state_final (state, expected); \
+    snippets_fnv_state_free (state); \
+    \
+    for (n_threads = 1; n_threads <= 8; n_threads++) { \
+      snippets_fnv_tree (variant, width, chunk_sizes[i], n_threads, data, \
+          sizeof (data), hash); \
+      fail_unless (memcmp (hash, expected, sizeof (hash)) == 0); \
+    } \
+  } \
+  \
+  /* No chunks at all for empty input */ \
+  memset (len_bytes, 0, sizeof (len_bytes)); \
+  snippets_##func##_##width (len_bytes, 8, expected); \
+  snippets_fnv_tree (variant, width, 1000, 4, NULL, 0, hash); \
+  fail_unless (memcmp (hash, expected, sizeof (hash)) == 0); \
+} \
+\
+END_TEST;
+
+CREATE_TREE_TEST (fnv1a, SNIPPETS_FNV_VARIANT_1A, 64);
+CREATE_TREE_TEST (fnv1, SNIPPETS_FNV_VARIANT_1, 128);
+CREATE_TREE_TEST (fnv1a, SNIPPETS_FNV_VARIANT_1A, 256);
+
+START_TEST (test_hash_file)
+{
+  const size_t size = 3 * 1024 * 1024 + 123;
+  char path[] = "/tmp/snippets-fnv-XXXXXX";
+  uint8_t *data;
+  uint8_t hash[64], expected[64];
+  size_t i;
+  pid_t pid;
+  FILE *f;
+  int fd;
+
+  data = malloc (size);
+  for (i = 0; i < size; i++)
+    data[i] = (i * 131) ^ (i >> 3);
+
+  fail_unless (!snippets_fnv_hash_file ("/nonexistent/file",
+          SNIPPETS_FNV_VARIANT_1A, 64, hash));
+
+  /* Empty regular file */
+  fd = mkstemp (path);
+  fail_unless (fd >= 0);
+  close (fd);
+
+  fail_unless (snippets_fnv_hash_file (path, SNIPPETS_FNV_VARIANT_1A, 64,
+          hash));
+  snippets_fnv1a_64 (NULL, 0, expected);
+  fail_unless (memcmp (hash, expected, 8) == 0);
+
+  /* Regular file, memory mapped */
+  f = fopen (path, "wb");
+  fail_unless (fwrite (data, 1, size, f) == size);
+  fclose (f);
+
+  fail_unless (snippets_fnv_hash_file (path, SNIPPETS_FNV_VARIANT_1A, 64,
+          hash));
+  snippets_fnv1a_64 (data, size, expected);
+  fail_unless (memcmp (hash, expected, 8) == 0);
+
+  fail_unless (snippets_fnv_hash_file (path, SNIPPETS_FNV_VARIANT_1, 512,
+          hash));
+  snippets_fnv1_512 (data, size, expected);
+  fail_unless (memcmp (hash, expected, 64) == 0);
+
+  unlink (path);
+
+  /* Pipe, read in blocks */
+  fail_unless (mkfifo (path, 0600) == 0);
+  pid = fork ();
+  fail_unless (pid >= 0);
+  if (pid == 0) {
+    f = fopen (path, "wb");
+    fwrite (data, 1, size, f);
+    fclose (f);
+    _exit (0);
+  }
+
+  fail_unless (snippets_fnv_hash_file (path, SNIPPETS_FNV_VARIANT_1A, 64,
+          hash));
+  snippets_fnv1a_64 (data, size, expected);
+  fail_unless (memcmp (hash, expected, 8) == 0);
+
+  waitpid (pid, NULL, 0);
+  unlink (path);
+  free (data);
+}
+
+END_TEST;
+
+START_TEST (test_inline)
+{
+  uint64_t key[2];
+  uint32_t key32;
+  int i;
+
+  for (i = 0; i < 1000; i++) {
+    key[0] = 0x9e3779b97f4a7c15ULL * i;
+    key[1] = ~key[0] ^ (i << 7);
+    key32 = key[0] >> 16;
+
+    fail_unless (snippets_fnv1a_64_u32 (key32) ==
+        snippets_fnv1a_64_uint64 ((const uint8_t *) &key32, 4));
+    fail_unless (snippets_fnv1a_64_u64 (key[0]) ==
+        snippets_fnv1a_64_uint64 ((const uint8_t *) key, 8));
+    fail_unless (snippets_fnv1a_64_u128 (key) ==
+        snippets_fnv1a_64_uint64 ((const uint8_t *) key, 16));
+  }
+}
+
+END_TEST;
+
+/* Compares the batch hashing with the one-shot functions */
+static int
+batch_matches (void)
+{
+  uint8_t data[128];
+  const uint8_t *keys[101];
+  size_t lens[101];
+  uint32_t out32[101];
+  uint64_t out64[101];
+  int i, ok = TRUE;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = (i * 131) ^ (i >> 3);
+  for (i = 0; i < 101; i++) {
+    keys[i] = data + (i % 50);
+    lens[i] = (i < 64) ? 8 + (i * 37) % 60 : (i * 13) % 20;
+  }
+
+  snippets_fnv1a_32_batch (keys, lens, 101, out32);
+  snippets_fnv1a_64_batch (keys, lens, 101, out64);
+  for (i = 0; i < 101; i++) {
+    ok = ok && out32[i] == snippets_fnv1a_32_uint32 (keys[i], lens[i]);
+    ok = ok && out64[i] == snippets_fnv1a_64_uint64 (keys[i], lens[i]);
+  }
+
+  return ok;
+}
+
+START_TEST (test_batch_simd_levels)
+{
+  fail_unless (simd_check_with_level ("scalar"));
+  fail_unless (simd_check_with_level ("sse4.2"));
+  fail_unless (simd_check_with_level ("avx2"));
+  fail_unless (simd_check_with_level ("avx512"));
+}
+
+END_TEST;
+
 static Suite *
 fnv_suite (void)
 {
@@ -668,17 +1137,73 @@ fnv_suite (void)
   tcase_add_test (tc_general, test_1a_512);
   tcase_add_test (tc_general, test_1_1024);
   tcase_add_test (tc_general, test_1a_1024);
+  tcase_add_test (tc_general, test_1a_32_batch);
+  tcase_add_test (tc_general, test_1a_64_batch);
+  tcase_add_test (tc_general, test_batch_simd_levels);
+  tcase_add_test (tc_general, test_uint_fnv1_32);
+  tcase_add_test (tc_general, test_uint_fnv1a_32);
+  tcase_add_test (tc_general, test_uint_fnv1_64);
+  tcase_add_test (tc_general, test_uint_fnv1a_64);
+  tcase_add_test (tc_general, test_seeded_fnv1a_32);
+  tcase_add_test (tc_general, test_seeded_fnv1a_64);
+  tcase_add_test (tc_general, test_seeded_state_128);
+  tcase_add_test (tc_general, test_seeded_state_256);
+  tcase_add_test (tc_general, test_seeded_state_512);
+  tcase_add_test (tc_general, test_seeded_state_1024);
+  tcase_add_test (tc_general, test_words_fnv1_128);
+  tcase_add_test (tc_general, test_words_fnv1a_128);
+  tcase_add_test (tc_general, test_words_fnv1_256);
+  tcase_add_test (tc_general, test_words_fnv1a_256);
+  tcase_add_test (tc_general, test_words_fnv1_512);
+  tcase_add_test (tc_general, test_words_fnv1a_512);
+  tcase_add_test (tc_general, test_words_fnv1_1024);
+  tcase_add_test (tc_general, test_words_fnv1a_1024);
+  tcase_add_test (tc_general, test_iov_fnv1_32);
+  tcase_add_test (tc_general, test_iov_fnv1a_32);
+  tcase_add_test (tc_general, test_iov_fnv1_64);
+  tcase_add_test (tc_general, test_iov_fnv1a_64);
+  tcase_add_test (tc_general, test_iov_fnv1_128);
+  tcase_add_test (tc_general, test_iov_fnv1a_128);
+  tcase_add_test (tc_general, test_iov_fnv1_256);
+  tcase_add_test (tc_general, test_iov_fnv1a_256);
+  tcase_add_test (tc_general, test_iov_fnv1_512);
+  tcase_add_test (tc_general, test_iov_fnv1a_512);
+  tcase_add_test (tc_general, test_iov_fnv1_1024);
+  tcase_add_test (tc_general, test_iov_fnv1a_1024);
+  tcase_add_test (tc_general, test_tree_fnv1a_64);
+  tcase_add_test (tc_general, test_tree_fnv1_128);
+  tcase_add_test (tc_general, test_tree_fnv1a_256);
+  tcase_add_test (tc_general, test_hash_file);
+  tcase_add_test (tc_general, test_inline);
+  tcase_add_test (tc_general, test_state_fnv1_32);
+  tcase_add_test (tc_general, test_state_fnv1a_32);
+  tcase_add_test (tc_general, test_state_fnv1_64);
+  tcase_add_test (tc_general, test_state_fnv1a_64);
+  tcase_add_test (tc_general, test_state_fnv1_128);
+  tcase_add_test (tc_general, test_state_fnv1a_128);
+  tcase_add_test (tc_general, test_state_fnv1_256);
+  tcase_add_test (tc_general, test_state_fnv1a_256);
+  tcase_add_test (tc_general, test_state_fnv1_512);
+  tcase_add_test (tc_general, test_state_fnv1a_512);
+  tcase_add_test (tc_general, test_state_fnv1_1024);
+  tcase_add_test (tc_general, test_state_fnv1a_1024);
   suite_add_tcase (s, tc_general);
 
   return s;
 }
 
 int
-main (void)
+main (int argc, char **argv)
 {
   int number_failed;
-  Suite *s = fnv_suite ();
-  SRunner *sr = srunner_create (s);
+  Suite *s;
+  SRunner *sr;
+
+  /* Runs only the SIMD level check if this is its child process */
+  simd_handle_child (argv[0], batch_matches);
+
+  s = fnv_suite ();
+  sr = srunner_create (s);
   srunner_run_all (sr, CK_NORMAL);
   number_failed = srunner_ntests_failed (sr);
   srunner_free (sr);
@@ -0,0 +1,145 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <check.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <snippets/philox.h>
+
+#include "simd.h"
+
+/* Known answer tests from the Random123 library */
+static const struct
+{
+  uint32_t counter[4];
+  uint32_t key[2];
+  uint32_t out[4];
+} philox_vectors[] = {
+  {
+        {0, 0, 0, 0}, {0, 0},
+      {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+  {
+        {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+        {0xffffffff, 0xffffffff},
+      {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+  {
+        {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+        {0xa4093822, 0x299f31d0},
+      {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}
+};
+
+START_TEST (test_known_answers)
+{
+  uint32_t out[4];
+  unsigned int i;
+
+  for (i = 0; i < sizeof (philox_vectors) / sizeof (philox_vectors[0]); i++) {
+    snippets_philox4x32_10 (philox_vectors[i].key, philox_vectors[i].counter,
+        out);
+    fail_unless (memcmp (out, philox_vectors[i].out, sizeof (out)) == 0);
+
+    snippets_philox4x32_10_fill (philox_vectors[i].key,
+        philox_vectors[i].counter, out, 4);
+    fail_unless (memcmp (out, philox_vectors[i].out, sizeof (out)) == 0);
+  }
+}
+
+END_TEST;
+
+/* Fills must be the same as the single blocks for all sizes, also if
+ * the counter wraps around in any of its words */
+static int
+fill_matches_blocks (void)
+{
+  static const uint32_t counters[][4] = {
+    {0, 0, 0, 0},
+    {0xfffffff0, 7, 0, 0},
+    {0xfffffffb, 0xffffffff, 0xffffffff, 3},
+    {0xfffffffd, 0xffffffff, 0xffffffff, 0xffffffff}
+  };
+  static const uint32_t key[2] = { 0x12345678, 0x9abcdef0 };
+  uint32_t buf[1024], block[4], counter[4];
+  unsigned int c, n, i, j;
+
+  for (c = 0; c < sizeof (counters) / sizeof (counters[0]); c++) {
+    for (n = 0; n < 1024; n = n < 80 ? n + 1 : n * 2 + 3) {
+      snippets_philox4x32_10_fill (key, counters[c], buf, n);
+
+      memcpy (counter, counters[c], sizeof (counter));
+      for (i = 0; i < n; i += 4) {
+        snippets_philox4x32_10 (key, counter, block);
+        for (j = 0; j < 4 && i + j < n; j++) {
+          if (buf[i + j] != block[j])
+            return FALSE;
+        }
+        for (j = 0; j < 4 && ++counter[j] == 0; j++);
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+START_TEST (test_fill_simd_levels)
+{
+  fail_unless (simd_check_with_level ("scalar"));
+  fail_unless (simd_check_with_level ("sse4.2"));
+  fail_unless (simd_check_with_level ("avx2"));
+  fail_unless (simd_check_with_level ("avx512"));
+}
+
+END_TEST;
+
+static Suite *
+philox_suite (void)
+{
+  Suite *s = suite_create ("Philox");
+
+  /* Core test case */
+  TCase *tc_general = tcase_create ("general");
+  tcase_add_test (tc_general, test_known_answers);
+  tcase_add_test (tc_general, test_fill_simd_levels);
+  suite_add_tcase (s, tc_general);
+
+  return s;
+}
+
+int
+main (int argc, char **argv)
+{
+  int number_failed;
+  Suite *s;
+  SRunner *sr;
+
+  /* Runs only the SIMD level check if this is its child process */
+  simd_handle_child (argv[0], fill_matches_blocks);
+
+  s = philox_suite ();
+  sr = srunner_create (s);
+  srunner_run_all (sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -22,7 +22,20 @@
 #endif
 
 #include <check.h>
+
 #include <snippets/rand.h>
+#include <snippets/rand-inline.h>
+#include <snippets/philox.h>
+
+#include "simd.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 START_TEST (test_rand_mt_uint32)
 {
@@ -75,6 +88,45 @@ START_TEST (test_rand_mt_uint32_range_20_100)
 
 END_TEST;
 
+START_TEST (test_rand_uint32_range_rejection)
+{
+  /* Almost half of the numbers are rejected for this range */
+  const uint32_t min = 5, max = 5 + 0x80000001UL;
+  SnippetsRand *a = snippets_rand_new (0xdeadbeef);
+  SnippetsRand *b = snippets_rand_new (0xdeadbeef);
+  uint32_t vals[2000], counts[3] = { 0, 0, 0 };
+  unsigned int i, j;
+
+  for (i = 0; i < 2000; i++) {
+    vals[i] = snippets_rand_uint32_range (a, min, max);
+    fail_unless (vals[i] >= min && vals[i] < max);
+  }
+  fail_unless (snippets_rand_uint32_range (a, 7, 7) == 7);
+
+  for (i = 0; i < 30000; i++)
+    counts[snippets_rand_uint32_range (a, 0, 3)]++;
+  for (i = 0; i < 3; i++)
+    fail_unless (counts[i] > 9500 && counts[i] < 10500);
+
+  for (i = 0; i < 2000; i++)
+    snippets_rand_uint32_range (b, min, max);
+  snippets_rand_uint32_range (b, 7, 7);
+  for (i = 0; i < 30000; i++)
+    snippets_rand_uint32_range (b, 0, 3);
+
+  snippets_rand_fill_uint32_range (a, vals, 2000, min, max);
+  for (j = 0; j < 2000; j++) {
+    fail_unless (vals[j] >= min && vals[j] < max);
+    fail_unless (vals[j] == snippets_rand_uint32_range (b, min, max));
+  }
+  fail_unless (snippets_rand_uint32 (a) == snippets_rand_uint32 (b));
+
+  snippets_rand_free (a);
+  snippets_rand_free (b);
+}
+
+END_TEST;
+
 START_TEST (test_rand_mt_double_range_20_100)
 {
   SnippetsRand *rand = snippets_rand_new (0xdeadbeef);
@@ -93,6 +145,778 @@ START_TEST (test_rand_mt_double_range_20_100)
 
 END_TEST;
 
+/* The bulk functions must produce the same numbers as the single value
+ * functions, with sizes crossing state block boundaries */
+static const size_t fill_sizes[] = { 0, 1, 5, 623, 624, 625, 1300, 2000, 3 };
+
+START_TEST (test_rand_mt_fill_uint32)
+{
+  SnippetsRand *a = snippets_rand_new (0xdeadbeef);
+  SnippetsRand *b = snippets_rand_new (0xdeadbeef);
+  uint32_t vals[2000];
+  unsigned int i, j;
+
+  for (i = 0; i < sizeof (fill_sizes) / sizeof (fill_sizes[0]); i++) {
+    snippets_rand_fill_uint32 (a, vals, fill_sizes[i]);
+    for (j = 0; j < fill_sizes[i]; j++)
+      fail_unless (vals[j] == snippets_rand_uint32 (b));
+
+    snippets_rand_fill_uint32_range (a, vals, fill_sizes[i], 20, 100);
+    for (j = 0; j < fill_sizes[i]; j++)
+      fail_unless (vals[j] == snippets_rand_uint32_range (b, 20, 100));
+  }
+  fail_unless (snippets_rand_uint32 (a) == snippets_rand_uint32 (b));
+
+  snippets_rand_free (a);
+  snippets_rand_free (b);
+}
+
+END_TEST;
+
+START_TEST (test_rand_mt_fill_double)
+{
+  SnippetsRand *a = snippets_rand_new (0xdeadbeef);
+  SnippetsRand *b = snippets_rand_new (0xdeadbeef);
+  double vals[2000];
+  unsigned int i, j;
+
+  for (i = 0; i < sizeof (fill_sizes) / sizeof (fill_sizes[0]); i++) {
+    snippets_rand_fill_double (a, vals, fill_sizes[i]);
+    for (j = 0; j < fill_sizes[i]; j++) {
+      fail_unless (vals[j] >= 0.0 && vals[j] < 1.0);
+      fail_unless (vals[j] == snippets_rand_double (b));
+    }
+
+    snippets_rand_fill_double_range (a, vals, fill_sizes[i], 20, 100);
+    for (j = 0; j < fill_sizes[i]; j++) {
+      fail_unless (vals[j] >= 20 && vals[j] < 100);
+      fail_unless (vals[j] == snippets_rand_double_range (b, 20, 100));
+    }
+  }
+  fail_unless (snippets_rand_uint32 (a) == snippets_rand_uint32 (b));
+
+  snippets_rand_free (a);
+  snippets_rand_free (b);
+}
+
+END_TEST;
+
+/* First three 64 bit outputs for seed 1234567. SplitMix64 is the
+ * reference output, the other engines are seeded from it */
+#define CREATE_ENGINE_TEST(name, engine, r0, r1, r2) \
+START_TEST (test_rand_##name) \
+{ \
+  SnippetsRand *a = snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_##engine, 1234567); \
+  SnippetsRand *b = snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_##engine, 1234567); \
+  uint32_t vals32[2000]; \
+  double vals[2000]; \
+  unsigned int i, j; \
+  \
+  fail_unless (snippets_rand_get_engine (a) == SNIPPETS_RAND_ENGINE_##engine); \
+  fail_unless (snippets_rand_uint64 (a) == r0); \
+  fail_unless (snippets_rand_uint64 (a) == r1); \
+  fail_unless (snippets_rand_uint64 (a) == r2); \
+  for (i = 0; i < 3; i++) \
+    snippets_rand_uint64 (b); \
+  \
+  for (i = 0; i < 2048; i++) { \
+    double d = snippets_rand_double (a); \
+    uint32_t u = snippets_rand_uint32_range (a, 20, 100); \
+    \
+    fail_unless (d >= 0.0 && d < 1.0); \
+    fail_unless (u >= 20 && u < 100); \
+    fail_unless (snippets_rand_double (b) == d); \
+    fail_unless (snippets_rand_uint32_range (b, 20, 100) == u); \
+  } \
+  \
+  for (i = 0; i < sizeof (fill_sizes) / sizeof (fill_sizes[0]); i++) { \
+    snippets_rand_fill_uint32 (a, vals32, fill_sizes[i]); \
+    for (j = 0; j < fill_sizes[i]; j++) \
+      fail_unless (vals32[j] == snippets_rand_uint32 (b)); \
+    \
+    snippets_rand_fill_double_range (a, vals, fill_sizes[i], 20, 100); \
+    for (j = 0; j < fill_sizes[i]; j++) { \
+      fail_unless (vals[j] >= 20 && vals[j] < 100); \
+      fail_unless (vals[j] == snippets_rand_double_range (b, 20, 100)); \
+    } \
+  } \
+  fail_unless (snippets_rand_uint64 (a) == snippets_rand_uint64 (b)); \
+  \
+  snippets_rand_free (a); \
+  snippets_rand_free (b); \
+} \
+\
+END_TEST;
+
+CREATE_ENGINE_TEST (xoshiro256ss, XOSHIRO256SS, 3504822795582309479ULL,
+    1819558768956484042ULL, 1250851346055027673ULL);
+CREATE_ENGINE_TEST (pcg64, PCG64, 17097725841831356946ULL,
+    6914360091160402692ULL, 9190502956788895680ULL);
+CREATE_ENGINE_TEST (splitmix64, SPLITMIX64, 6457827717110365317ULL,
+    3203168211198807973ULL, 9817491932198370423ULL);
+CREATE_ENGINE_TEST (philox4x32, PHILOX4X32, 4389887489974102479ULL,
+    8784869116480249916ULL, 3463714932684049994ULL);
+
+/* The engine output is the counter-based stream for the seed as key */
+START_TEST (test_rand_philox4x32_stream)
+{
+  SnippetsRand *rand;
+  uint32_t key[2], counter[4] = { 0, 0, 0, 0 }, words[200];
+  uint64_t seed = 0x0123456789abcdefULL;
+  unsigned int i;
+
+  key[0] = (uint32_t) seed;
+  key[1] = seed >> 32;
+  snippets_philox4x32_10_fill (key, counter, words, 200);
+
+  rand = snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_PHILOX4X32, seed);
+  for (i = 0; i < 100; i++)
+    fail_unless (snippets_rand_uint64 (rand) ==
+        (words[2 * i] | ((uint64_t) words[2 * i + 1] << 32)));
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_rand_mt_engine)
+{
+  SnippetsRand *a = snippets_rand_new (5489);
+  SnippetsRand *b = snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_MT19937,
+      5489);
+  uint64_t v;
+
+  fail_unless (snippets_rand_get_engine (a) == SNIPPETS_RAND_ENGINE_MT19937);
+  fail_unless (snippets_rand_uint32 (a) == 3499211612U);
+  fail_unless (snippets_rand_uint32 (b) == 3499211612U);
+
+  /* 64 bit numbers are made from two draws, first one is the upper half */
+  v = snippets_rand_uint64 (a);
+  fail_unless ((v >> 32) == snippets_rand_uint32 (b));
+  fail_unless ((v & 0xffffffff) == snippets_rand_uint32 (b));
+
+  snippets_rand_free (a);
+  snippets_rand_free (b);
+}
+
+END_TEST;
+
+/* All engines, for the tests that are repeated for each of them */
+static const SnippetsRandEngine engines[] = {
+  SNIPPETS_RAND_ENGINE_MT19937, SNIPPETS_RAND_ENGINE_XOSHIRO256SS,
+  SNIPPETS_RAND_ENGINE_PCG64, SNIPPETS_RAND_ENGINE_SPLITMIX64,
+  SNIPPETS_RAND_ENGINE_PHILOX4X32
+};
+
+START_TEST (test_rand_jump)
+{
+  SnippetsRand *a, *b;
+  unsigned int e, k, i;
+  uint64_t n;
+
+  /* Jumping by 2^k is the same as 2^k steps, up to 2^16 which is above
+   * the degree of the MT19937 polynomial */
+  for (e = 0; e < sizeof (engines) / sizeof (engines[0]); e++) {
+    for (k = 0; k <= 16; k++) {
+      a = snippets_rand_new_with_engine (engines[e], 7);
+      b = snippets_rand_new_with_engine (engines[e], 7);
+      for (i = 0; i < 100; i++) {
+        snippets_rand_uint32 (a);
+        snippets_rand_uint32 (b);
+      }
+
+      for (n = 0; n < ((uint64_t) 1) << k; n++) {
+        if (engines[e] == SNIPPETS_RAND_ENGINE_MT19937)
+          snippets_rand_uint32 (a);
+        else
+          snippets_rand_uint64 (a);
+      }
+      snippets_rand_jump (b, k);
+      for (i = 0; i < 1000; i++)
+        fail_unless (snippets_rand_uint32 (a) == snippets_rand_uint32 (b));
+
+      snippets_rand_free (a);
+      snippets_rand_free (b);
+    }
+
+    /* Two jumps by 2^k are one by 2^(k+1) */
+    a = snippets_rand_new_with_engine (engines[e], 7);
+    b = snippets_rand_new_with_engine (engines[e], 7);
+    snippets_rand_jump (a, 127);
+    snippets_rand_jump (a, 127);
+    snippets_rand_jump (b, 128);
+    for (i = 0; i < 1000; i++)
+      fail_unless (snippets_rand_uint32 (a) == snippets_rand_uint32 (b));
+    snippets_rand_free (a);
+    snippets_rand_free (b);
+  }
+
+  /* Same as the jump() of the xoshiro256** reference implementation */
+  a = snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_XOSHIRO256SS, 42);
+  snippets_rand_jump (a, 128);
+  fail_unless (snippets_rand_uint64 (a) == 0x50086ef83cbf4f4aULL);
+  snippets_rand_free (a);
+}
+
+END_TEST;
+
+START_TEST (test_rand_split)
+{
+  static const unsigned int log2_steps[] = { 128, 128, 96, 48, 96 };
+  SnippetsRand *rand, *ref, *streams[4];
+  unsigned int e, i, j;
+
+  for (e = 0; e < sizeof (engines) / sizeof (engines[0]); e++) {
+    rand = snippets_rand_new_with_engine (engines[e], 99);
+    snippets_rand_uint32 (rand);
+
+    snippets_rand_split (rand, 4, streams);
+
+    /* Stream i starts i split distances after the generator, which
+     * continues after the last one */
+    for (i = 0; i <= 4; i++) {
+      ref = snippets_rand_new_with_engine (engines[e], 99);
+      snippets_rand_uint32 (ref);
+      for (j = 0; j < i; j++)
+        snippets_rand_jump (ref, log2_steps[e]);
+
+      for (j = 0; j < 100; j++)
+        fail_unless (snippets_rand_uint32 (i < 4 ? streams[i] : rand) ==
+            snippets_rand_uint32 (ref));
+      snippets_rand_free (ref);
+    }
+
+    for (i = 0; i < 4; i++) {
+      fail_unless (snippets_rand_get_engine (streams[i]) == engines[e]);
+      snippets_rand_free (streams[i]);
+    }
+    snippets_rand_free (rand);
+  }
+}
+
+END_TEST;
+
+START_TEST (test_rand_save_restore)
+{
+  static const uint8_t splitmix64_saved[] = {
+    'S', 'R', 1, SNIPPETS_RAND_ENGINE_SPLITMIX64,
+    0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01
+  };
+  SnippetsRand *a, *b;
+  uint8_t buf[4096];
+  size_t size;
+  unsigned int e, i, n;
+
+  for (e = 0; e < sizeof (engines) / sizeof (engines[0]); e++) {
+    /* Fresh, in the middle of a MT19937 block and at its end */
+    for (n = 0; n <= 1248; n += 624) {
+      a = snippets_rand_new_with_engine (engines[e], 4321);
+      for (i = 0; i < n + (n ? 376 : 0); i++)
+        snippets_rand_uint32 (a);
+
+      size = snippets_rand_get_save_size (a);
+      fail_unless (size > 4 && size <= sizeof (buf));
+      snippets_rand_save (a, buf);
+      b = snippets_rand_restore (buf, size);
+      fail_unless (b != NULL);
+      fail_unless (snippets_rand_get_engine (b) == engines[e]);
+      for (i = 0; i < 2000; i++)
+        fail_unless (snippets_rand_uint32 (a) == snippets_rand_uint32 (b));
+      snippets_rand_free (b);
+
+      /* Truncated, unknown version and not a saved state */
+      fail_unless (snippets_rand_restore (buf, size - 1) == NULL);
+      buf[2]++;
+      fail_unless (snippets_rand_restore (buf, size) == NULL);
+      buf[2]--;
+      buf[0] = 'X';
+      fail_unless (snippets_rand_restore (buf, size) == NULL);
+
+      snippets_rand_free (a);
+    }
+  }
+
+  /* Little endian on all platforms */
+  a = snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_SPLITMIX64,
+      0x0102030405060708ULL);
+  fail_unless (snippets_rand_get_save_size (a) == sizeof (splitmix64_saved));
+  snippets_rand_save (a, buf);
+  fail_unless (memcmp (buf, splitmix64_saved, sizeof (splitmix64_saved)) == 0);
+  snippets_rand_free (a);
+
+  /* mti beyond the state */
+  a = snippets_rand_new (1);
+  size = snippets_rand_get_save_size (a);
+  snippets_rand_save (a, buf);
+  buf[size - 4] = 0x71;
+  buf[size - 3] = 0x02;
+  fail_unless (snippets_rand_restore (buf, size) == NULL);
+  snippets_rand_free (a);
+}
+
+END_TEST;
+
+/* Copy of the thread default generator, via save and restore */
+static SnippetsRand *
+thread_default_copy (void)
+{
+  SnippetsRand *rand = snippets_rand_thread_default ();
+  size_t size = snippets_rand_get_save_size (rand);
+  uint8_t buf[64];
+
+  fail_unless (size <= sizeof (buf));
+  snippets_rand_save (rand, buf);
+
+  return snippets_rand_restore (buf, size);
+}
+
+START_TEST (test_rand_thread_default)
+{
+  SnippetsRand *rand, *copy;
+  SnippetsRandThreadState *state;
+  unsigned int i;
+
+  rand = snippets_rand_thread_default ();
+  fail_unless (rand != NULL);
+  fail_unless (snippets_rand_thread_default () == rand);
+  fail_unless (snippets_rand_get_engine (rand) ==
+      SNIPPETS_RAND_ENGINE_XOSHIRO256SS);
+
+  state = snippets_rand_thread_state ();
+  fail_unless (snippets_rand_thread_state () == state);
+
+  /* The inline functions and the generator continue each other */
+  copy = thread_default_copy ();
+  fail_unless (copy != NULL);
+  for (i = 0; i < 1000; i++) {
+    fail_unless (snippets_rand_thread_uint64 (state) ==
+        snippets_rand_uint64 (copy));
+    fail_unless (snippets_rand_uint64 (rand) == snippets_rand_uint64 (copy));
+    fail_unless (snippets_rand_thread_uint32 (state) ==
+        snippets_rand_uint32 (copy));
+    fail_unless (snippets_rand_thread_uint32_range (state, 20, 100) ==
+        snippets_rand_uint32_range (copy, 20, 100));
+    fail_unless (snippets_rand_thread_uint32_range (state, 0,
+            0x80000001) == snippets_rand_uint32_range (copy, 0, 0x80000001));
+    fail_unless (snippets_rand_thread_uint32_range (state, 7, 7) ==
+        snippets_rand_uint32_range (copy, 7, 7));
+    fail_unless (snippets_rand_thread_double (state) ==
+        snippets_rand_double (copy));
+  }
+  snippets_rand_free (copy);
+}
+
+END_TEST;
+
+#ifdef HAVE_PTHREAD
+typedef struct
+{
+  SnippetsRand *rand;
+  uint64_t first;
+} ThreadDefault;
+
+static void *
+thread_default_func (void *data)
+{
+  ThreadDefault *d = data;
+  SnippetsRand *copy;
+
+  d->rand = snippets_rand_thread_default ();
+  copy = thread_default_copy ();
+  d->first = snippets_rand_uint64 (copy);
+  snippets_rand_free (copy);
+
+  return NULL;
+}
+
+START_TEST (test_rand_thread_default_threads)
+{
+  ThreadDefault d[4];
+  pthread_t threads[4];
+  SnippetsRand *copy;
+  unsigned int i, j;
+
+  for (i = 0; i < 4; i++)
+    fail_unless (pthread_create (&threads[i], NULL, thread_default_func,
+            &d[i]) == 0);
+  for (i = 0; i < 4; i++)
+    fail_unless (pthread_join (threads[i], NULL) == 0);
+
+  /* The generators of exited threads are freed and their memory might
+   * be reused, so only the numbers can be compared between them */
+  copy = thread_default_copy ();
+  for (i = 0; i < 4; i++) {
+    fail_unless (d[i].rand != snippets_rand_thread_default ());
+    fail_unless (d[i].first != snippets_rand_uint64 (copy));
+    for (j = 0; j < i; j++)
+      fail_unless (d[i].first != d[j].first);
+  }
+  snippets_rand_free (copy);
+}
+
+END_TEST;
+
+typedef struct
+{
+  pthread_key_t key;
+  int engine;
+  int equal;
+} ThreadDefaultLate;
+
+/* Runs after the destructor of the thread default generator, which
+ * was used before this key was created */
+static void
+thread_default_late_free (void *data)
+{
+  ThreadDefaultLate *d = data;
+  SnippetsRand *rand, *copy;
+
+  rand = snippets_rand_thread_default ();
+  d->engine = snippets_rand_get_engine (rand);
+  copy = thread_default_copy ();
+  d->equal = snippets_rand_uint64 (rand) == snippets_rand_uint64 (copy);
+  snippets_rand_free (copy);
+}
+
+static void *
+thread_default_late_func (void *data)
+{
+  ThreadDefaultLate *d = data;
+
+  snippets_rand_uint64 (snippets_rand_thread_default ());
+  pthread_setspecific (d->key, d);
+
+  return NULL;
+}
+
+START_TEST (test_rand_thread_default_destructor)
+{
+  ThreadDefaultLate d;
+  pthread_t thread;
+
+  /* Creates the key of the thread default generator first */
+  snippets_rand_thread_default ();
+  fail_unless (pthread_key_create (&d.key, thread_default_late_free) == 0);
+  d.engine = -1;
+  d.equal = FALSE;
+
+  fail_unless (pthread_create (&thread, NULL, thread_default_late_func,
+          &d) == 0);
+  fail_unless (pthread_join (thread, NULL) == 0);
+  pthread_key_delete (d.key);
+
+  fail_unless (d.engine == SNIPPETS_RAND_ENGINE_XOSHIRO256SS);
+  fail_unless (d.equal);
+}
+
+END_TEST;
+#endif
+
+#define N_SAMPLES 200000
+
+START_TEST (test_rand_normal)
+{
+  SnippetsRand *a, *b;
+  double vals[2000], x, sum = 0, sum2 = 0;
+  unsigned int e, i, j, tail = 0;
+
+  a = snippets_rand_new (0xdeadbeef);
+  for (i = 0; i < N_SAMPLES; i++) {
+    x = snippets_rand_normal (a, 0.0, 1.0);
+    sum += x;
+    sum2 += x * x;
+    tail += (x > 3.5 || x < -3.5);
+  }
+  snippets_rand_free (a);
+
+  /* Mean, variance and P(|x| > 3.5) = 4.65e-4, which also covers the
+   * tail beyond the ziggurat */
+  fail_unless (fabs (sum / N_SAMPLES) < 0.01);
+  fail_unless (fabs (sum2 / N_SAMPLES - 1.0) < 0.02);
+  fail_unless (tail > 50 && tail < 140);
+
+  a = snippets_rand_new (1);
+  fail_unless (fabs (snippets_rand_normal (a, 1000.0, 0.001) - 1000.0) < 0.01);
+  snippets_rand_free (a);
+
+  for (e = 0; e < sizeof (engines) / sizeof (engines[0]); e++) {
+    a = snippets_rand_new_with_engine (engines[e], 1234);
+    b = snippets_rand_new_with_engine (engines[e], 1234);
+    for (i = 0; i < sizeof (fill_sizes) / sizeof (fill_sizes[0]); i++) {
+      snippets_rand_fill_normal (a, vals, fill_sizes[i], 5.0, 2.0);
+      for (j = 0; j < fill_sizes[i]; j++)
+        fail_unless (vals[j] == snippets_rand_normal (b, 5.0, 2.0));
+    }
+    fail_unless (snippets_rand_uint32 (a) == snippets_rand_uint32 (b));
+    snippets_rand_free (a);
+    snippets_rand_free (b);
+  }
+}
+
+END_TEST;
+
+START_TEST (test_rand_exponential)
+{
+  SnippetsRand *a, *b;
+  double vals[2000], x, sum = 0, sum2 = 0;
+  unsigned int e, i, j, tail = 0;
+
+  a = snippets_rand_new (0xdeadbeef);
+  for (i = 0; i < N_SAMPLES; i++) {
+    x = snippets_rand_exponential (a, 2.0);
+    fail_unless (x >= 0.0);
+    sum += x;
+    sum2 += x * x;
+    tail += (x > 4.0);
+  }
+  snippets_rand_free (a);
+
+  /* Mean 1 / 2, variance 1 / 4 and P(x > 4) = e^-8 = 3.35e-4, beyond
+   * the ziggurat */
+  fail_unless (fabs (sum / N_SAMPLES - 0.5) < 0.005);
+  fail_unless (fabs (sum2 / N_SAMPLES - (sum / N_SAMPLES) * (sum / N_SAMPLES)
+          - 0.25) < 0.01);
+  fail_unless (tail > 35 && tail < 105);
+
+  for (e = 0; e < sizeof (engines) / sizeof (engines[0]); e++) {
+    a = snippets_rand_new_with_engine (engines[e], 1234);
+    b = snippets_rand_new_with_engine (engines[e], 1234);
+    for (i = 0; i < sizeof (fill_sizes) / sizeof (fill_sizes[0]); i++) {
+      snippets_rand_fill_exponential (a, vals, fill_sizes[i], 0.5);
+      for (j = 0; j < fill_sizes[i]; j++)
+        fail_unless (vals[j] == snippets_rand_exponential (b, 0.5));
+    }
+    fail_unless (snippets_rand_uint32 (a) == snippets_rand_uint32 (b));
+    snippets_rand_free (a);
+    snippets_rand_free (b);
+  }
+}
+
+END_TEST;
+
+/* Checks the reference MT19937 output */
+static int
+mt_matches (void)
+{
+  SnippetsRand *rand;
+  uint32_t first, v = 0;
+  int i;
+
+  rand = snippets_rand_new (5489);
+  first = snippets_rand_uint32 (rand);
+  for (i = 1; i < 10000; i++)
+    v = snippets_rand_uint32 (rand);
+  snippets_rand_free (rand);
+
+  return first == 3499211612U && v == 4123659995U;
+}
+
+static int
+is_permutation (const uint32_t * p, uint32_t n)
+{
+  uint8_t *seen = calloc (n + 1, 1);
+  uint32_t i;
+  int ret = TRUE;
+
+  for (i = 0; i < n && ret; i++) {
+    if (p[i] >= n || seen[p[i]])
+      ret = FALSE;
+    else
+      seen[p[i]] = 1;
+  }
+  free (seen);
+
+  return ret;
+}
+
+START_TEST (test_rand_permutation_uniform)
+{
+  unsigned int counts[24] = { 0, };
+  uint32_t p[4];
+  unsigned int e, i, j, k, code;
+  double sd = sqrt (24000 * (1 / 24.0) * (23 / 24.0));
+  SnippetsRand *rand;
+
+  for (e = 0; e < sizeof (engines) / sizeof (engines[0]); e++) {
+    rand = snippets_rand_new_with_engine (engines[e], 2024);
+    memset (counts, 0, sizeof (counts));
+    for (i = 0; i < 24000; i++) {
+      snippets_rand_permutation (rand, p, 4);
+      fail_unless (is_permutation (p, 4));
+      /* Lehmer code of the permutation */
+      code = 0;
+      for (j = 0; j < 4; j++) {
+        code *= 4 - j;
+        for (k = j + 1; k < 4; k++)
+          code += p[k] < p[j];
+      }
+      counts[code]++;
+    }
+    for (j = 0; j < 24; j++)
+      fail_unless (fabs (counts[j] - 1000.0) <= 5 * sd,
+          "permutation %u: %u of 24000", j, counts[j]);
+    snippets_rand_free (rand);
+  }
+}
+
+END_TEST;
+
+START_TEST (test_rand_shuffle)
+{
+  static const uint32_t sizes[] = { 0, 1, 2, 3, 5, 17, 1000, 70001 };
+  SnippetsRand *rand = snippets_rand_new (77);
+  uint32_t *p;
+  unsigned int counts[256];
+  uint8_t *elems;
+  unsigned int i, j;
+  uint32_t v;
+
+  for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    p = malloc ((sizes[i] + 1) * sizeof (uint32_t));
+    snippets_rand_permutation (rand, p, sizes[i]);
+    fail_unless (is_permutation (p, sizes[i]));
+    free (p);
+  }
+
+  /* Elements of other sizes stay intact */
+  elems = malloc (1000 * 7);
+  for (i = 0; i < 1000; i++)
+    for (j = 0; j < 7; j++)
+      elems[i * 7 + j] = (i + j) & 0xff;
+  snippets_rand_shuffle (rand, elems, 1000, 7);
+  memset (counts, 0, sizeof (counts));
+  for (i = 0; i < 1000; i++) {
+    v = 0;
+    for (j = 0; j < 7; j++)
+      v += (elems[i * 7 + j] - elems[i * 7]) & 0xff;
+    fail_unless (v == 21);
+    counts[elems[i * 7]]++;
+  }
+  for (i = 0; i < 256; i++)
+    fail_unless (counts[i] == 3 + (i < 1000 - 3 * 256));
+  free (elems);
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+#define N_LARGE 8400017
+
+START_TEST (test_rand_shuffle_large)
+{
+  SnippetsRand *a = snippets_rand_new (5), *b;
+  uint32_t *p = malloc (N_LARGE * sizeof (uint32_t));
+  uint32_t *q = malloc (N_LARGE * sizeof (uint32_t));
+  unsigned int n_threads, i, stayed, fixed;
+  uint32_t next;
+
+  /* Blocks and merges */
+  b = snippets_rand_new (5);
+  snippets_rand_permutation (a, p, N_LARGE);
+  fail_unless (is_permutation (p, N_LARGE));
+
+  /* Elements of the first half end up in either half with the same
+   * probability, and there are few fixed points */
+  stayed = fixed = 0;
+  for (i = 0; i < N_LARGE / 2; i++) {
+    stayed += p[i] < N_LARGE / 2;
+    fixed += p[i] == i;
+  }
+  fail_unless (fabs (stayed - N_LARGE / 4.0) < 5 * sqrt (N_LARGE) / 4,
+      "%u of %u", stayed, N_LARGE / 2);
+  fail_unless (fixed < 20);
+
+  /* The number of threads doesn't change the result */
+  next = snippets_rand_uint32 (a);
+  for (n_threads = 1; n_threads <= 8; n_threads += 3) {
+    snippets_rand_free (b);
+    b = snippets_rand_new (5);
+    for (i = 0; i < N_LARGE; i++)
+      q[i] = i;
+    snippets_rand_shuffle_parallel (b, q, N_LARGE, sizeof (uint32_t),
+        n_threads);
+    fail_unless (memcmp (p, q, N_LARGE * sizeof (uint32_t)) == 0);
+    fail_unless (snippets_rand_uint32 (b) == next);
+  }
+
+  snippets_rand_free (a);
+  snippets_rand_free (b);
+  free (p);
+  free (q);
+}
+
+END_TEST;
+
+START_TEST (test_rand_from_array)
+{
+  /* First outputs of mt19937ar.c */
+  static const uint32_t key[] = { 0x123, 0x234, 0x345, 0x456 };
+  static const uint32_t expected[] = {
+    1067595299, 955945823, 477289528, 4107218783, 4228976476,
+    3344332714, 3355579695, 227628506, 810200273, 2591290167
+  };
+  static const uint32_t halves[] = { 4, 5 };
+  SnippetsRand *rand, *other;
+  unsigned int i;
+
+  rand = snippets_rand_new_from_array (key, 4);
+  fail_unless (snippets_rand_get_engine (rand) ==
+      SNIPPETS_RAND_ENGINE_MT19937);
+  for (i = 0; i < sizeof (expected) / sizeof (expected[0]); i++)
+    fail_unless (snippets_rand_uint32 (rand) == expected[i]);
+  snippets_rand_free (rand);
+
+  /* Seeds above 2^32 are not truncated but the two halves as key */
+  rand = snippets_rand_new_with_engine (SNIPPETS_RAND_ENGINE_MT19937,
+      0x0000000500000004ULL);
+  other = snippets_rand_new_from_array (halves, 2);
+  fail_unless (snippets_rand_uint32 (rand) == snippets_rand_uint32 (other));
+  snippets_rand_free (other);
+  other = snippets_rand_new (4);
+  fail_unless (snippets_rand_uint32 (rand) != snippets_rand_uint32 (other));
+  snippets_rand_free (other);
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_rand_new_entropy)
+{
+  SnippetsRand *a, *b;
+  unsigned int e, i, same;
+
+  a = snippets_rand_new_entropy ();
+  fail_unless (snippets_rand_get_engine (a) == SNIPPETS_RAND_ENGINE_MT19937);
+  snippets_rand_free (a);
+
+  for (e = 0; e < sizeof (engines) / sizeof (engines[0]); e++) {
+    a = snippets_rand_new_entropy_with_engine (engines[e]);
+    b = snippets_rand_new_entropy_with_engine (engines[e]);
+    fail_unless (a != NULL && b != NULL);
+    fail_unless (snippets_rand_get_engine (a) == engines[e]);
+
+    same = 0;
+    for (i = 0; i < 100; i++)
+      same += snippets_rand_uint32 (a) == snippets_rand_uint32 (b);
+    fail_unless (same < 3);
+
+    snippets_rand_free (a);
+    snippets_rand_free (b);
+  }
+}
+
+END_TEST;
+
+START_TEST (test_rand_mt_simd_levels)
+{
+  fail_unless (simd_check_with_level ("scalar"));
+  fail_unless (simd_check_with_level ("sse4.2"));
+  fail_unless (simd_check_with_level ("avx2"));
+  fail_unless (simd_check_with_level ("avx512"));
+}
+
+END_TEST;
+
 static Suite *
 rand_suite (void)
 {
@@ -103,18 +927,49 @@ rand_suite (void)
   tcase_add_test (tc_general, test_rand_mt_uint32);
   tcase_add_test (tc_general, test_rand_mt_double);
   tcase_add_test (tc_general, test_rand_mt_uint32_range_20_100);
+  tcase_add_test (tc_general, test_rand_uint32_range_rejection);
   tcase_add_test (tc_general, test_rand_mt_double_range_20_100);
+  tcase_add_test (tc_general, test_rand_mt_fill_uint32);
+  tcase_add_test (tc_general, test_rand_mt_fill_double);
+  tcase_add_test (tc_general, test_rand_mt_engine);
+  tcase_add_test (tc_general, test_rand_xoshiro256ss);
+  tcase_add_test (tc_general, test_rand_pcg64);
+  tcase_add_test (tc_general, test_rand_splitmix64);
+  tcase_add_test (tc_general, test_rand_philox4x32);
+  tcase_add_test (tc_general, test_rand_philox4x32_stream);
+  tcase_add_test (tc_general, test_rand_jump);
+  tcase_add_test (tc_general, test_rand_split);
+  tcase_add_test (tc_general, test_rand_save_restore);
+  tcase_add_test (tc_general, test_rand_thread_default);
+#ifdef HAVE_PTHREAD
+  tcase_add_test (tc_general, test_rand_thread_default_threads);
+  tcase_add_test (tc_general, test_rand_thread_default_destructor);
+#endif
+  tcase_add_test (tc_general, test_rand_normal);
+  tcase_add_test (tc_general, test_rand_exponential);
+  tcase_add_test (tc_general, test_rand_permutation_uniform);
+  tcase_add_test (tc_general, test_rand_shuffle);
+  tcase_add_test (tc_general, test_rand_shuffle_large);
+  tcase_add_test (tc_general, test_rand_from_array);
+  tcase_add_test (tc_general, test_rand_new_entropy);
+  tcase_add_test (tc_general, test_rand_mt_simd_levels);
   suite_add_tcase (s, tc_general);
 
   return s;
 }
 
 int
-main (void)
+main (int argc, char **argv)
 {
   int number_failed;
-  Suite *s = rand_suite ();
-  SRunner *sr = srunner_create (s);
+  Suite *s;
+  SRunner *sr;
+
+  /* Runs only the SIMD level check if this is its child process */
+  simd_handle_child (argv[0], mt_matches);
+
+  s = rand_suite ();
+  sr = srunner_create (s);
   srunner_run_all (sr, CK_NORMAL);
   number_failed = srunner_ntests_failed (sr);
   srunner_free (sr);
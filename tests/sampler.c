@@ -0,0 +1,438 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <check.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <snippets/sampler.h>
+
+#define N_SAMPLES 1000000
+
+/* Checks that the frequencies of N_SAMPLES samples are within 5
+ * standard deviations of the weights */
+static void
+check_distribution (SnippetsWeightedSampler * sampler, SnippetsRand * rand)
+{
+  uint32_t n = snippets_weighted_sampler_get_size (sampler);
+  unsigned int *counts = calloc (n, sizeof (unsigned int));
+  double sum = 0, p, expected, sd;
+  uint32_t i, idx;
+
+  for (i = 0; i < N_SAMPLES; i++) {
+    idx = snippets_weighted_sampler_sample (sampler, rand);
+    fail_unless (idx < n);
+    counts[idx]++;
+  }
+
+  for (i = 0; i < n; i++)
+    sum += snippets_weighted_sampler_get_weight (sampler, i);
+
+  for (i = 0; i < n; i++) {
+    p = snippets_weighted_sampler_get_weight (sampler, i) / sum;
+    expected = p * N_SAMPLES;
+    sd = sqrt (N_SAMPLES * p * (1 - p));
+    if (p == 0)
+      fail_unless (counts[i] == 0);
+    else
+      fail_unless (fabs (counts[i] - expected) <= 5 * sd + 1,
+          "index %u: %u samples, expected %f", i, counts[i], expected);
+  }
+
+  free (counts);
+}
+
+START_TEST (test_weighted_sampler_distribution)
+{
+  static const double weights[] = { 1, 2, 3, 4, 0, 10, 0.5, 100 };
+  SnippetsWeightedSampler *sampler;
+  SnippetsRand *rand = snippets_rand_new (0xdeadbeef);
+  double *uniform;
+  uint32_t i;
+
+  sampler = snippets_weighted_sampler_new (weights,
+      sizeof (weights) / sizeof (weights[0]));
+  fail_unless (snippets_weighted_sampler_get_size (sampler) ==
+      sizeof (weights) / sizeof (weights[0]));
+  check_distribution (sampler, rand);
+  snippets_weighted_sampler_free (sampler);
+
+  /* Every entry of the table is its own index only */
+  uniform = malloc (1000 * sizeof (double));
+  for (i = 0; i < 1000; i++)
+    uniform[i] = 3.0;
+  sampler = snippets_weighted_sampler_new (uniform, 1000);
+  check_distribution (sampler, rand);
+  snippets_weighted_sampler_free (sampler);
+
+  /* Power law over many weights */
+  for (i = 0; i < 1000; i++)
+    uniform[i] = 1.0 / (i + 1);
+  sampler = snippets_weighted_sampler_new (uniform, 1000);
+  check_distribution (sampler, rand);
+  snippets_weighted_sampler_free (sampler);
+  free (uniform);
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_weighted_sampler_single)
+{
+  static const double weights[] = { 0, 0, 5, 0 };
+  SnippetsWeightedSampler *sampler;
+  SnippetsRand *rand = snippets_rand_new (1);
+  unsigned int i;
+
+  sampler = snippets_weighted_sampler_new (weights + 2, 1);
+  fail_unless (snippets_weighted_sampler_get_size (sampler) == 1);
+  for (i = 0; i < 1000; i++)
+    fail_unless (snippets_weighted_sampler_sample (sampler, rand) == 0);
+  snippets_weighted_sampler_free (sampler);
+
+  sampler = snippets_weighted_sampler_new (weights, 4);
+  for (i = 0; i < 1000; i++)
+    fail_unless (snippets_weighted_sampler_sample (sampler, rand) == 2);
+  snippets_weighted_sampler_free (sampler);
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_weighted_sampler_set_weight)
+{
+  static const double weights[] = { 1, 1, 1, 1, 1 };
+  SnippetsWeightedSampler *sampler;
+  SnippetsRand *rand = snippets_rand_new (42);
+
+  sampler = snippets_weighted_sampler_new (weights, 5);
+  check_distribution (sampler, rand);
+
+  snippets_weighted_sampler_set_weight (sampler, 0, 0);
+  snippets_weighted_sampler_set_weight (sampler, 3, 7.5);
+  snippets_weighted_sampler_set_weight (sampler, 3, 8);
+  fail_unless (snippets_weighted_sampler_get_weight (sampler, 0) == 0);
+  fail_unless (snippets_weighted_sampler_get_weight (sampler, 3) == 8);
+  fail_unless (snippets_weighted_sampler_get_weight (sampler, 4) == 1);
+  check_distribution (sampler, rand);
+
+  snippets_weighted_sampler_free (sampler);
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_weighted_sampler_fill)
+{
+  static const double weights[] = { 0.25, 3, 0, 1, 17, 2.5, 0.01 };
+  SnippetsWeightedSampler *sampler;
+  SnippetsRand *a, *b;
+  uint32_t buf[1001];
+  unsigned int e, i;
+
+  sampler = snippets_weighted_sampler_new (weights,
+      sizeof (weights) / sizeof (weights[0]));
+
+  for (e = SNIPPETS_RAND_ENGINE_MT19937; e <= SNIPPETS_RAND_ENGINE_PHILOX4X32;
+      e++) {
+    a = snippets_rand_new_with_engine (e, 123);
+    b = snippets_rand_new_with_engine (e, 123);
+
+    snippets_weighted_sampler_fill (sampler, a, buf, 1001);
+    for (i = 0; i < 1001; i++)
+      fail_unless (buf[i] == snippets_weighted_sampler_sample (sampler, b));
+
+    /* A rebuild in between */
+    snippets_weighted_sampler_set_weight (sampler, 2, e + 1.0);
+    snippets_weighted_sampler_fill (sampler, a, buf, 17);
+    for (i = 0; i < 17; i++)
+      fail_unless (buf[i] == snippets_weighted_sampler_sample (sampler, b));
+    snippets_weighted_sampler_set_weight (sampler, 2, 0);
+
+    snippets_rand_free (a);
+    snippets_rand_free (b);
+  }
+
+  snippets_weighted_sampler_free (sampler);
+}
+
+END_TEST;
+
+#define N_TRIALS 20000
+
+START_TEST (test_reservoir_uniform)
+{
+  SnippetsRand *rand = snippets_rand_new (4711);
+  SnippetsReservoir *reservoir;
+  unsigned int counts[100] = { 0, };
+  double p = 10.0 / 100, sd = sqrt (N_TRIALS * p * (1 - p));
+  unsigned int i, j;
+
+  for (i = 0; i < N_TRIALS; i++) {
+    reservoir = snippets_reservoir_new (10, sizeof (unsigned int), NULL, NULL);
+    for (j = 0; j < 100; j++)
+      snippets_reservoir_add (reservoir, rand, &j);
+    fail_unless (snippets_reservoir_length (reservoir) == 10);
+    fail_unless (snippets_reservoir_n_seen (reservoir) == 100);
+    for (j = 0; j < 10; j++)
+      counts[*snippets_reservoir_get (reservoir, j, unsigned int)]++;
+    snippets_reservoir_free (reservoir);
+  }
+
+  for (i = 0; i < 100; i++)
+    fail_unless (fabs (counts[i] - p * N_TRIALS) <= 5 * sd,
+        "item %u: %u of %u", i, counts[i], N_TRIALS);
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_reservoir_short)
+{
+  SnippetsRand *rand = snippets_rand_new (1);
+  SnippetsReservoir *reservoir;
+  uint64_t j;
+
+  /* Less items than the capacity are all kept in order */
+  reservoir = snippets_reservoir_new (10, sizeof (uint64_t), NULL, NULL);
+  for (j = 0; j < 7; j++)
+    fail_unless (snippets_reservoir_add (reservoir, rand, &j));
+  fail_unless (snippets_reservoir_length (reservoir) == 7);
+  for (j = 0; j < 7; j++)
+    fail_unless (*snippets_reservoir_get (reservoir, j, uint64_t) == j);
+  snippets_reservoir_free (reservoir);
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_reservoir_add_array)
+{
+  SnippetsRand *a = snippets_rand_new (99), *b = snippets_rand_new (99);
+  SnippetsReservoir *ra, *rb;
+  uint32_t items[10000];
+  unsigned int i, j, n;
+
+  for (i = 0; i < 10000; i++)
+    items[i] = i;
+
+  ra = snippets_reservoir_new (50, sizeof (uint32_t), NULL, NULL);
+  rb = snippets_reservoir_new (50, sizeof (uint32_t), NULL, NULL);
+
+  /* Chunks that start and end anywhere relative to the taken items */
+  for (i = 0, n = 1; i < 10000; i += n, n = n * 3 % 997 + 1) {
+    if (n > 10000 - i)
+      n = 10000 - i;
+    snippets_reservoir_add_array (ra, a, items + i, n);
+    for (j = i; j < i + n; j++)
+      snippets_reservoir_add (rb, b, &items[j]);
+    fail_unless (snippets_reservoir_n_seen (ra) ==
+        snippets_reservoir_n_seen (rb));
+  }
+
+  fail_unless (snippets_reservoir_length (ra) == 50);
+  for (i = 0; i < 50; i++)
+    fail_unless (*snippets_reservoir_get (ra, i, uint32_t) ==
+        *snippets_reservoir_get (rb, i, uint32_t));
+  fail_unless (snippets_rand_uint32 (a) == snippets_rand_uint32 (b));
+
+  snippets_reservoir_free (ra);
+  snippets_reservoir_free (rb);
+  snippets_rand_free (a);
+  snippets_rand_free (b);
+}
+
+END_TEST;
+
+static unsigned int n_allocated;
+
+static void
+counted_copy (void *dest, const void *src)
+{
+  uint32_t *copy = malloc (sizeof (uint32_t));
+
+  *copy = *(const uint32_t *) src;
+  *(uint32_t **) dest = copy;
+  n_allocated++;
+}
+
+static void
+counted_free (void *data)
+{
+  free (data);
+  n_allocated--;
+}
+
+START_TEST (test_reservoir_pointer)
+{
+  SnippetsRand *rand = snippets_rand_new (7);
+  SnippetsReservoir *reservoir;
+  SnippetsWeightedReservoir *weighted;
+  uint32_t i, v, *ptrs[1000];
+
+  n_allocated = 0;
+  reservoir = snippets_reservoir_new_pointer (16, counted_copy, counted_free);
+  for (i = 0; i < 1000; i++)
+    snippets_reservoir_add (reservoir, rand, &i);
+  fail_unless (n_allocated == 16);
+  for (i = 0; i < 16; i++)
+    fail_unless (*snippets_reservoir_get (reservoir, i, uint32_t) < 1000);
+  snippets_reservoir_free (reservoir);
+  fail_unless (n_allocated == 0);
+
+  /* Without copy function the pointers are stored */
+  for (i = 0; i < 1000; i++) {
+    ptrs[i] = malloc (sizeof (uint32_t));
+    *ptrs[i] = i;
+  }
+  reservoir = snippets_reservoir_new_pointer (16, NULL, NULL);
+  snippets_reservoir_add_array (reservoir, rand, ptrs, 1000);
+  for (i = 0; i < 16; i++)
+    fail_unless (ptrs[*snippets_reservoir_get (reservoir, i,
+                uint32_t)] == snippets_reservoir_get (reservoir, i, uint32_t));
+  snippets_reservoir_free (reservoir);
+  for (i = 0; i < 1000; i++)
+    free (ptrs[i]);
+
+  n_allocated = 0;
+  weighted =
+      snippets_weighted_reservoir_new_pointer (16, counted_copy, counted_free);
+  for (i = 0; i < 1000; i++)
+    snippets_weighted_reservoir_add (weighted, rand, &i, i % 5);
+  fail_unless (n_allocated == 16);
+  for (i = 0; i < 16; i++) {
+    /* Items with weight 0 are never taken */
+    v = *snippets_weighted_reservoir_get (weighted, i, uint32_t) % 5;
+    fail_unless (v != 0);
+  }
+  snippets_weighted_reservoir_free (weighted);
+  fail_unless (n_allocated == 0);
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_weighted_reservoir_single)
+{
+  static const double weights[] = { 1, 2, 0, 3, 4 };
+  SnippetsRand *rand = snippets_rand_new (123);
+  SnippetsWeightedReservoir *reservoir;
+  unsigned int counts[5] = { 0, };
+  double p, sd;
+  unsigned int i, j;
+
+  /* With a single item the probabilities are the normalized weights */
+  for (i = 0; i < N_TRIALS; i++) {
+    reservoir =
+        snippets_weighted_reservoir_new (1, sizeof (unsigned int), NULL, NULL);
+    for (j = 0; j < 5; j++)
+      snippets_weighted_reservoir_add (reservoir, rand, &j, weights[j]);
+    fail_unless (snippets_weighted_reservoir_length (reservoir) == 1);
+    fail_unless (snippets_weighted_reservoir_n_seen (reservoir) == 5);
+    counts[*snippets_weighted_reservoir_get (reservoir, 0, unsigned int)]++;
+    snippets_weighted_reservoir_free (reservoir);
+  }
+
+  fail_unless (counts[2] == 0);
+  for (i = 0; i < 5; i++) {
+    p = weights[i] / 10.0;
+    sd = sqrt (N_TRIALS * p * (1 - p));
+    fail_unless (fabs (counts[i] - p * N_TRIALS) <= 5 * sd,
+        "item %u: %u of %u", i, counts[i], N_TRIALS);
+  }
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+START_TEST (test_weighted_reservoir_stream)
+{
+  SnippetsRand *rand = snippets_rand_new (321);
+  SnippetsWeightedReservoir *reservoir;
+  unsigned int counts[2] = { 0, 0 };
+  unsigned int i, j, v;
+
+  for (i = 0; i < 2000; i++) {
+    reservoir =
+        snippets_weighted_reservoir_new (20, sizeof (unsigned int), NULL, NULL);
+    for (j = 0; j < 1000; j++) {
+      /* The second half has 9 times the weight */
+      v = j >= 500;
+      snippets_weighted_reservoir_add (reservoir, rand, &v, v ? 9.0 : 1.0);
+    }
+    fail_unless (snippets_weighted_reservoir_length (reservoir) == 20);
+    for (j = 0; j < 20; j++)
+      counts[*snippets_weighted_reservoir_get (reservoir, j, unsigned int)]++;
+    snippets_weighted_reservoir_free (reservoir);
+  }
+
+  /* Sampling without replacement of 20 from 1000 barely changes the
+   * ratio of 9:1 */
+  fail_unless (fabs (counts[1] / (double) (counts[0] + counts[1]) - 0.9) <
+      0.01, "%u vs. %u", counts[0], counts[1]);
+
+  snippets_rand_free (rand);
+}
+
+END_TEST;
+
+static Suite *
+sampler_suite (void)
+{
+  Suite *s = suite_create ("Sampler");
+
+  /* Core test case */
+  TCase *tc_general = tcase_create ("general");
+  tcase_add_test (tc_general, test_weighted_sampler_distribution);
+  tcase_add_test (tc_general, test_weighted_sampler_single);
+  tcase_add_test (tc_general, test_weighted_sampler_set_weight);
+  tcase_add_test (tc_general, test_weighted_sampler_fill);
+  tcase_add_test (tc_general, test_reservoir_uniform);
+  tcase_add_test (tc_general, test_reservoir_short);
+  tcase_add_test (tc_general, test_reservoir_add_array);
+  tcase_add_test (tc_general, test_reservoir_pointer);
+  tcase_add_test (tc_general, test_weighted_reservoir_single);
+  tcase_add_test (tc_general, test_weighted_reservoir_stream);
+  suite_add_tcase (s, tc_general);
+
+  return s;
+}
+
+int
+main (void)
+{
+  int number_failed;
+  Suite *s = sampler_suite ();
+  SRunner *sr = srunner_create (s);
+  srunner_run_all (sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
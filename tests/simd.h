@@ -0,0 +1,103 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Shared by the tests: Runs a check in a new process with the SIMD
+ * level forced by the SNIPPETS_SIMD environment variable.
+ *
+ * The level is selected only once per process, and some functions
+ * additionally remember the implementation they picked, so the check
+ * runs in a freshly executed copy of the test program instead of a
+ * forked child that would inherit all of this from its parent.
+ */
+
+#ifndef __TESTS_SIMD_H__
+#define __TESTS_SIMD_H__
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/* The level selection is internal to the library and not exported, so
+ * the test has its own copy. In the freshly executed process it sees
+ * the same CPU and environment as the library */
+#include <snippets/cpu.c>
+
+#define SIMD_CHILD_ENV "SNIPPETS_TEST_SIMD_CHILD"
+
+static const char *simd_program = NULL;
+
+static const char *simd_level_names[] = {
+  "scalar", "sse4.2", "avx2", "avx512"
+};
+
+/* Has to be called first in main(). In the executed copy of the test
+ * program this checks that the forced level was selected, limited to
+ * what the CPU supports, runs @check and exits */
+static void
+simd_handle_child (const char *program, int (*check) (void))
+{
+  SnippetsCpuLevel forced = SNIPPETS_CPU_LEVEL_SCALAR, expected;
+  const char *env;
+
+  simd_program = program;
+
+  if (!getenv (SIMD_CHILD_ENV))
+    return;
+
+  env = getenv ("SNIPPETS_SIMD");
+  while (forced < SNIPPETS_CPU_LEVEL_AVX512
+      && strcmp (env, simd_level_names[forced]) != 0)
+    forced++;
+
+  expected = cpu_detect_level ();
+  if (forced < expected)
+    expected = forced;
+
+  if (_snippets_cpu_level () != expected)
+    exit (2);
+
+  exit (check ()? 0 : 1);
+}
+
+static int
+simd_check_with_level (const char *level)
+{
+  int status;
+  pid_t pid;
+
+  pid = fork ();
+  if (pid < 0)
+    return FALSE;
+
+  if (pid == 0) {
+    setenv ("SNIPPETS_SIMD", level, 1);
+    setenv (SIMD_CHILD_ENV, "1", 1);
+    execl (simd_program, simd_program, (char *) NULL);
+    _exit (3);
+  }
+
+  if (waitpid (pid, &status, 0) != pid)
+    return FALSE;
+
+  return WIFEXITED (status) && WEXITSTATUS (status) == 0;
+}
+
+#endif /* __TESTS_SIMD_H__ */
@@ -0,0 +1,134 @@
+/* This file is part of libsnippets
+ *
+ * Copyright (C) 2010 Sebastian Dröge <slomo@circular-chaos.org>
+ * 
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <check.h>
+
+#include <string.h>
+
+#include <snippets/wyhash.h>
+
+/* Test vectors from the reference implementation, with
+ * the index of the message as seed */
+static const char *messages[] = {
+  "",
+  "a",
+  "abc",
+  "message digest",
+  "abcdefghijklmnopqrstuvwxyz",
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+  "12345678901234567890123456789012345678901234567890123456789012345678901234567890"
+};
+
+static const uint64_t expected[] = {
+  0x93228a4de0eec5a2ULL,
+  0xc5bac3db178713c4ULL,
+  0xa97f2f7b1d9b3314ULL,
+  0x786d1f1df3801df4ULL,
+  0xdca5a8138ad37c87ULL,
+  0xb9e734f117cfaf70ULL,
+  0x6cc5eab49a92d617ULL
+};
+
+START_TEST (test_64)
+{
+  int i;
+
+  for (i = 0; i < sizeof (messages) / sizeof (messages[0]); i++)
+    fail_unless (snippets_wyhash_64 ((const uint8_t *) messages[i],
+            strlen (messages[i]), i) == expected[i]);
+}
+
+END_TEST;
+
+START_TEST (test_128)
+{
+  uint8_t data[200];
+  uint64_t hash[2], hash2[2];
+  size_t i;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = i * 7;
+
+  /* The first half is the 64 bit hash, and the second half
+   * must not simply repeat it. Each length goes through a
+   * different combination of the code paths */
+  for (i = 0; i <= sizeof (data); i++) {
+    snippets_wyhash_128 (data, i, 0x1234, hash);
+    fail_unless (hash[0] == snippets_wyhash_64 (data, i, 0x1234));
+    fail_if (hash[0] == hash[1]);
+
+    snippets_wyhash_128 (data, i, 0x1235, hash2);
+    fail_if (hash[0] == hash2[0]);
+    fail_if (hash[1] == hash2[1]);
+  }
+}
+
+END_TEST;
+
+START_TEST (test_unaligned)
+{
+  uint8_t data[128 + 8];
+  size_t i, len;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = i;
+
+  for (len = 0; len <= 128; len++) {
+    uint64_t h = snippets_wyhash_64 (data, len, 0);
+
+    for (i = 1; i < 8; i++) {
+      memmove (data + i, data, len);
+      fail_unless (snippets_wyhash_64 (data + i, len, 0) == h);
+      memmove (data, data + i, len);
+    }
+  }
+}
+
+END_TEST;
+
+static Suite *
+wyhash_suite (void)
+{
+  Suite *s = suite_create ("WyHash");
+
+  /* Core test case */
+  TCase *tc_general = tcase_create ("general");
+  tcase_add_test (tc_general, test_64);
+  tcase_add_test (tc_general, test_128);
+  tcase_add_test (tc_general, test_unaligned);
+  suite_add_tcase (s, tc_general);
+
+  return s;
+}
+
+int
+main (void)
+{
+  int number_failed;
+  Suite *s = wyhash_suite ();
+  SRunner *sr = srunner_create (s);
+  srunner_run_all (sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}